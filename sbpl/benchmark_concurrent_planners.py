@@ -0,0 +1,104 @@
+from __future__ import print_function
+from __future__ import absolute_import
+from __future__ import division
+
+import argparse
+import multiprocessing
+import os
+import threading
+import time
+import numpy as np
+
+from sbpl.environments import EnvironmentNAVXYTHETALAT
+from sbpl.motion_primitives import mprim_folder, load_motion_pritimives
+from sbpl.planners import create_planner
+from sbpl.runners import env_examples_folder
+
+
+def create_environment_and_planner(model_env, planner_name, forward_search, initial_epsilon):
+    """
+    Every planner gets its own search instance of model_env: the bindings release the GIL while
+    planning and separate environment/planner pairs can be used from separate threads. The instances
+    share the costmap and the primitive kernels of model_env.
+    """
+    env = model_env.create_search_instance()
+    planner = create_planner(planner_name, env, forward_search)
+    planner.set_start_goal_from_env(env)
+    planner.set_planning_params(initial_epsilon=initial_epsilon, search_until_first_solution=True)
+    return env, planner
+
+
+def plan_from_scratch(env, planner, results, index):
+    start = time.time()
+    plan_xytheta, _, _, _, solution_eps = planner.replan(env, allocated_time=np.inf, final_epsilon=1.)
+    results[index] = (time.time() - start, len(plan_xytheta), solution_eps)
+
+
+def run_planners(pairs, concurrent):
+    """
+    Runs one search on every environment/planner pair, either one after the other or each on its
+    own thread, and returns the wall time
+    """
+    results = [None] * len(pairs)
+    start = time.time()
+    if concurrent:
+        threads = [threading.Thread(target=plan_from_scratch, args=(env, planner, results, i))
+                   for i, (env, planner) in enumerate(pairs)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+    else:
+        for i, (env, planner) in enumerate(pairs):
+            plan_from_scratch(env, planner, results, i)
+    wall_time = time.time() - start
+
+    assert all(r[1] > 0 for r in results), "a planner did not find a solution"
+    return wall_time
+
+
+def benchmark_concurrent_planners(environment_config, motion_primitives, planner_name, forward_search,
+                                  initial_epsilon, max_threads):
+    """
+    Plans with N independent planners at once for N = 1..max_threads and compares the wall time with
+    running them one after the other. With the GIL released the speedup should be close to N as long
+    as N does not exceed the number of cores.
+    """
+    true_env = EnvironmentNAVXYTHETALAT.create_from_config(environment_config)
+    footprint = np.array([[-0.01, -0.01], [0.01, -0.01], [0.01, 0.01], [-0.01, 0.01]])
+    model_env = EnvironmentNAVXYTHETALAT(footprint, motion_primitives, true_env.get_costmap(),
+                                         true_env.get_params())
+
+    print("%8s %12s %12s %8s %10s" % ('planners', 'serial (s)', 'threads (s)', 'speedup', 'efficiency'))
+    for n in range(1, max_threads + 1):
+        # the planners keep their search state, so every run gets fresh ones
+        serial_time = run_planners(
+            [create_environment_and_planner(model_env, planner_name, forward_search, initial_epsilon)
+             for _ in range(n)],
+            concurrent=False)
+        concurrent_time = run_planners(
+            [create_environment_and_planner(model_env, planner_name, forward_search, initial_epsilon)
+             for _ in range(n)],
+            concurrent=True)
+        speedup = serial_time / concurrent_time
+        print("%8d %12.3f %12.3f %8.2f %10.2f" % (n, serial_time, concurrent_time, speedup, speedup / n))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Scaling of independent planners run on python threads')
+    parser.add_argument('--environment', default=os.path.join(env_examples_folder(), 'nav3d/cubicle-25mm-inflated-env.cfg'))
+    parser.add_argument('--primitives', default=os.path.join(mprim_folder(), 'pr2.mprim'))
+    parser.add_argument('--planner', default='arastar')
+    parser.add_argument('--backward', action='store_true')
+    parser.add_argument('--initial-epsilon', type=float, default=3.0)
+    parser.add_argument('--max-threads', type=int, default=multiprocessing.cpu_count())
+    args = parser.parse_args()
+
+    benchmark_concurrent_planners(
+        environment_config=args.environment,
+        motion_primitives=load_motion_pritimives(args.primitives),
+        planner_name=args.planner,
+        forward_search=not args.backward,
+        initial_epsilon=args.initial_epsilon,
+        max_threads=args.max_threads
+    )
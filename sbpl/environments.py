@@ -22,7 +22,11 @@ class EnvNAVXYTHETALAT_InitParms(sbpl._sbpl_module.EnvNAVXYTHETALAT_InitParms):
 class EnvironmentNAVXYTHETALAT(sbpl._sbpl_module.EnvironmentNAVXYTHETALAT):
 
     def __init__(self, footprint, motion_primitives, costmap_data, env_params,
-                 override_primitive_kernels=True, use_full_kernels=False):
+                 override_primitive_kernels=True, use_full_kernels=False, kernel_cache_dir=None):
+        """
+        kernel_cache_dir: directory where the kernels computed by sbpl are cached between environments
+            with the same primitives, footprint and resolution (unused with override_primitive_kernels)
+        """
         primitives_folder = tempfile.mkdtemp()
         try:
             dump_motion_primitives(motion_primitives, os.path.join(primitives_folder, 'primitives.mprim'))
@@ -32,7 +36,8 @@ class EnvironmentNAVXYTHETALAT(sbpl._sbpl_module.EnvironmentNAVXYTHETALAT):
                 os.path.join(primitives_folder, 'primitives.mprim'),
                 costmap_data,
                 env_params,
-                not override_primitive_kernels
+                not override_primitive_kernels,
+                kernel_cache_dir or ''
             )
             if override_primitive_kernels:
                 self._override_primitive_kernels(motion_primitives, footprint, use_full_kernels)
@@ -5,6 +5,7 @@ import sbpl._sbpl_module
 
 import numpy as np
 import os
+import struct
 import cv2
 
 from bc_gym_planning_env.robot_models.differential_drive import kinematic_body_pose_motion_step
@@ -42,6 +43,12 @@ def angle_discrete_to_cont(angle_cell, num_angles):
     return normalize_angle(angle_cell*bin_size)
 
 
+# binary motion primitive files (see EnvironmentNAVXYTHETALATTICE::WriteMotionPrimitivesBinary)
+# start with this magic and are stored in native byte order
+MPRIM_BINARY_MAGIC = b'SBPLMPRM'
+MPRIM_BINARY_VERSION = 1
+
+
 def mprim_folder():
     current_dir = os.path.dirname(__file__)
     return os.path.abspath(os.path.join(current_dir, '../matlab/mprim'))
@@ -116,8 +123,12 @@ class MotionPrimitive(object):
         return self._control_signals
 
 
-def load_motion_pritimives(mprim_filename):
-    """Load motion primitives from file (uses proxy environment to use SBPL code)"""
+def is_binary_motion_primitives_file(mprim_filename):
+    with open(mprim_filename, 'rb') as f:
+        return f.read(len(MPRIM_BINARY_MAGIC)) == MPRIM_BINARY_MAGIC
+
+
+def _read_text_motion_primitives_header(mprim_filename):
     with open(mprim_filename) as f:
         l0 = f.readline().strip()
         if not l0.startswith('resolution_m: '):
@@ -128,6 +139,26 @@ def load_motion_pritimives(mprim_filename):
         if not l1.startswith('numberofangles: '):
             raise AssertionError("Invalid number of angles entry")
         number_of_angles = int(l1[len('numberofangles: '):])
+    return resolution, number_of_angles
+
+
+def _read_binary_motion_primitives_header(mprim_filename):
+    with open(mprim_filename, 'rb') as f:
+        header = f.read(struct.calcsize('=8siid'))
+    magic, version, number_of_angles, resolution = struct.unpack('=8siid', header)
+    if magic != MPRIM_BINARY_MAGIC:
+        raise AssertionError("Invalid binary motion primitives magic")
+    if version != MPRIM_BINARY_VERSION:
+        raise AssertionError("Unsupported binary motion primitives version %d" % version)
+    return resolution, number_of_angles
+
+
+def load_motion_pritimives(mprim_filename):
+    """Load motion primitives from text or binary file (uses proxy environment to use SBPL code)"""
+    if is_binary_motion_primitives_file(mprim_filename):
+        resolution, number_of_angles = _read_binary_motion_primitives_header(mprim_filename)
+    else:
+        resolution, number_of_angles = _read_text_motion_primitives_header(mprim_filename)
 
     params = sbpl._sbpl_module.EnvNAVXYTHETALAT_InitParms()
     params.size_x = 1
@@ -250,6 +281,29 @@ def dump_motion_primitives(motion_primitives, filename):
                 f.write('%.4f %.4f %.4f\n' % (s[0], s[1], s[2]))
 
 
+def dump_motion_primitives_binary(motion_primitives, filename):
+    """Write motion primitives in the binary format that SBPL loads with a single read"""
+    check_motion_primitives(motion_primitives)
+
+    with open(filename, 'wb') as f:
+        # uniform angles only, so the list of angles is empty
+        f.write(struct.pack('=8siidii', MPRIM_BINARY_MAGIC, MPRIM_BINARY_VERSION,
+                            motion_primitives.get_number_of_angles(), motion_primitives.get_resolution(),
+                            0, len(motion_primitives.get_primitives())))
+
+        for p in motion_primitives.get_primitives():
+            states = np.ascontiguousarray(p.get_intermediate_states(), dtype=np.float64)
+            f.write(struct.pack('=6idi', p.motprimID, p.starttheta_c,
+                                p.endcell[0], p.endcell[1], p.endcell[2],
+                                p.additionalactioncostmult, 0., len(states)))
+            f.write(states.tobytes())
+
+
+def convert_motion_primitives_to_binary(mprim_filename, binary_filename):
+    """Convert a text .mprim file to the binary format"""
+    dump_motion_primitives_binary(load_motion_pritimives(mprim_filename), binary_filename)
+
+
 def assert_motion_primitives_equal(motion_primitives_0, motion_primitives_1):
     assert motion_primitives_0.get_resolution() == motion_primitives_1.get_resolution()
     assert motion_primitives_0.get_number_of_angles() == motion_primitives_1.get_number_of_angles()
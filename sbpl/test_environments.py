@@ -0,0 +1,62 @@
+from __future__ import print_function
+from __future__ import absolute_import
+from __future__ import division
+import os
+import numpy as np
+import pytest
+
+from sbpl.environments import EnvironmentNAVXYTHETALAT
+from sbpl.runners import env_examples_folder
+
+
+def create_environment():
+    return EnvironmentNAVXYTHETALAT.create_from_config(os.path.join(env_examples_folder(), 'nav3d/env1.cfg'))
+
+
+def test_update_environment_costmap_reports_changed_cells():
+    environment = create_environment()
+    costmap = environment.get_costmap()
+    costmap[3, 5] = 254 - costmap[3, 5]
+
+    changed_cells = environment.update_environment_costmap(costmap)
+    np.testing.assert_array_equal(changed_cells, [[5, 3]])
+    np.testing.assert_array_equal(environment.get_costmap(), costmap)
+
+
+@pytest.mark.parametrize('zero_copy', [False, True])
+def test_update_environment_costmap_rejects_the_costmap_in_use(zero_copy):
+    environment = create_environment()
+    costmap = environment.get_costmap()
+    costmap[3, 5] = 254 - costmap[3, 5]
+    environment.update_environment_costmap(costmap, zero_copy=True)
+
+    # the environment plans on costmap now, it can not be edited in place
+    with pytest.raises(ValueError):
+        costmap[3, 5] = 254 - costmap[3, 5]
+
+    # and an edit made in place could not be found by comparing with it, in either mode
+    with pytest.raises(Exception):
+        environment.update_environment_costmap(costmap, zero_copy=zero_copy)
+    with pytest.raises(Exception):
+        environment.update_environment_costmap(environment.get_costmap(copy=False), zero_copy=zero_copy)
+
+
+def test_update_environment_costmap_releases_the_adopted_costmap():
+    environment = create_environment()
+    costmap = environment.get_costmap()
+    costmap[3, 5] = 254 - costmap[3, 5]
+    environment.update_environment_costmap(costmap, zero_copy=True)
+    assert not costmap.flags.writeable
+
+    new_costmap = costmap.copy()
+    new_costmap[3, 5] = 254 - new_costmap[3, 5]
+    environment.update_environment_costmap(new_costmap)
+    assert costmap.flags.writeable
+    costmap[3, 5] = 0
+
+
+if __name__ == '__main__':
+    test_update_environment_costmap_reports_changed_cells()
+    test_update_environment_costmap_rejects_the_costmap_in_use(False)
+    test_update_environment_costmap_rejects_the_costmap_in_use(True)
+    test_update_environment_costmap_releases_the_adopted_costmap()
@@ -5,7 +5,7 @@ import tempfile
 import os
 
 from sbpl.motion_primitives import load_motion_pritimives, mprim_folder, dump_motion_primitives, \
-    assert_motion_primitives_equal
+    assert_motion_primitives_equal, convert_motion_primitives_to_binary
 
 
 def test_motion_primitive_file_dumping():
@@ -20,5 +20,16 @@ def test_motion_primitive_file_dumping():
     assert_motion_primitives_equal(mprimtives, mprimtives_loaded)
 
 
+def test_motion_primitive_binary_file():
+    text_filename = os.path.join(mprim_folder(), 'all_file.mprim')
+    mprimtives = load_motion_pritimives(text_filename)
+
+    tempdir = tempfile.mkdtemp()
+    converted_filename = os.path.join(tempdir, 'converted.bmprim')
+    convert_motion_primitives_to_binary(text_filename, converted_filename)
+    assert_motion_primitives_equal(mprimtives, load_motion_pritimives(converted_filename))
+
+
 if __name__ == '__main__':
     test_motion_primitive_file_dumping()
+    test_motion_primitive_binary_file()
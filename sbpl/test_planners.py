@@ -0,0 +1,41 @@
+from __future__ import print_function
+from __future__ import absolute_import
+from __future__ import division
+import os
+import numpy as np
+import pytest
+
+from sbpl.environments import EnvironmentNAVXYTHETALAT
+from sbpl.planners import create_planner
+from sbpl.runners import env_examples_folder
+
+
+def plan(open_type, forward_search):
+    environment = EnvironmentNAVXYTHETALAT.create_from_config(os.path.join(env_examples_folder(), 'nav3d/env1.cfg'))
+    planner = create_planner('arastar', environment, forward_search)
+    planner.set_open_type(open_type)
+    planner.set_start_goal_from_env(environment)
+    planner.set_planning_params(initial_epsilon=3., search_until_first_solution=False)
+    _, plan_xytheta_cell, _, _, solution_eps = planner.replan(environment, allocated_time=np.inf, final_epsilon=1.)
+    return plan_xytheta_cell, solution_eps
+
+
+@pytest.mark.parametrize('forward_search', [False, True])
+def test_arastar_plans_with_the_bucket_queue(forward_search):
+    plan_xytheta_cell, solution_eps = plan('bucket_queue', forward_search)
+    assert len(plan_xytheta_cell) > 0
+    assert solution_eps == 1.
+    np.testing.assert_array_equal(plan_xytheta_cell[-1], plan('heap', forward_search)[0][-1])
+
+
+def test_arastar_rejects_unknown_open_type():
+    environment = EnvironmentNAVXYTHETALAT.create_from_config(os.path.join(env_examples_folder(), 'nav3d/env1.cfg'))
+    planner = create_planner('arastar', environment, False)
+    with pytest.raises(Exception):
+        planner.set_open_type('fibonacci_heap')
+
+
+if __name__ == '__main__':
+    test_arastar_plans_with_the_bucket_queue(False)
+    test_arastar_plans_with_the_bucket_queue(True)
+    test_arastar_rejects_unknown_open_type()
@@ -48,7 +48,8 @@ setup(
     packages=find_packages(),
     ext_modules=[Extension(
         'sbpl._sbpl_module',
-        extra_compile_args=['-std=c++1y', '-O3'],
+        extra_compile_args=['-std=c++1y', '-O3', '-pthread'],
+        extra_link_args=['-pthread'],
         include_dirs=['dep/pybind11/include',
                       'src/include'],
         sources=[
@@ -62,6 +63,7 @@ setup(
             'src/planners/adplanner.cpp',
             'src/planners/ANAplanner.cpp',
             'src/planners/araplanner.cpp',
+            'src/planners/batchplanner.cpp',
             'src/planners/lazyARA.cpp',
             'src/planners/mhaplanner.cpp',
             'src/planners/ppcpplanner.cpp',
@@ -72,6 +74,7 @@ setup(
             'src/utils/utils.cpp',
             'src/utils/2Dgridsearch.cpp',
             'src/utils/config.cpp',
+            'src/utils/workerpool.cpp',
             'src/python_wrapper.cpp'])
     ]
 )
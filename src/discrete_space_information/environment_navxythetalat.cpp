@@ -27,14 +27,34 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <thread>
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include <sbpl/discrete_space_information/environment_navxythetalat.h>
 #include <sbpl/utils/2Dgridsearch.h>
 #include <sbpl/utils/key.h>
 #include <sbpl/utils/mdp.h>
 #include <sbpl/utils/mdpconfig.h>
+#include <sbpl/utils/workerpool.h>
+
+// AVX2 versions of the cell cost reductions are compiled in on x86 with GCC
+// and clang, and used if the CPU supports them
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define NAVXYTHETALAT_HAVE_AVX2 1
+#include <immintrin.h>
+#else
+#define NAVXYTHETALAT_HAVE_AVX2 0
+#endif
 
 #if TIME_DEBUG
 static clock_t time3_addallout = 0;
@@ -43,10 +63,188 @@ static clock_t time_createhash = 0;
 static clock_t time_getsuccs = 0;
 #endif
 
-static long int checks = 0;
+// allocates a costmap buffer aligned to NAVXYTHETALAT_GRID2D_ALIGNMENT bytes
+static unsigned char* AllocateGrid2D(size_t size)
+{
+    void* grid = NULL;
+#ifdef WIN32
+    grid = _aligned_malloc(__max(size, (size_t)1), NAVXYTHETALAT_GRID2D_ALIGNMENT);
+#else
+    if (posix_memalign(&grid, NAVXYTHETALAT_GRID2D_ALIGNMENT, __max(size, (size_t)1)) != 0) {
+        grid = NULL;
+    }
+#endif
+    if (grid == NULL) {
+        throw SBPL_Exception("ERROR: failed to allocate the 2D costmap");
+    }
+    return (unsigned char*)grid;
+}
+
+static void FreeGrid2D(unsigned char* grid)
+{
+#ifdef WIN32
+    _aligned_free(grid);
+#else
+    free(grid);
+#endif
+}
 
-#define XYTHETA2INDEX(X,Y,THETA) (THETA + X*EnvNAVXYTHETALATCfg.NumThetaDirs + \
-                                  Y*EnvNAVXYTHETALATCfg.EnvWidth_c*EnvNAVXYTHETALATCfg.NumThetaDirs)
+// allocates a hash table of size empty slots, each group of
+// NAVXYTHETALAT_HASHSLOTSPERLINE slots starting on a cache line
+static EnvNAVXYTHETALATHashSlot_t* AllocateHashTable(int size)
+{
+    void* table = NULL;
+    size_t bytes = (size_t)size * sizeof(EnvNAVXYTHETALATHashSlot_t);
+#ifdef WIN32
+    table = _aligned_malloc(bytes, NAVXYTHETALAT_GRID2D_ALIGNMENT);
+#else
+    if (posix_memalign(&table, NAVXYTHETALAT_GRID2D_ALIGNMENT, bytes) != 0) {
+        table = NULL;
+    }
+#endif
+    if (table == NULL) {
+        throw SBPL_Exception("ERROR: failed to allocate the state hash table");
+    }
+    memset(table, 0, bytes);
+    return (EnvNAVXYTHETALATHashSlot_t*)table;
+}
+
+static void FreeHashTable(EnvNAVXYTHETALATHashSlot_t* table)
+{
+#ifdef WIN32
+    _aligned_free(table);
+#else
+    free(table);
+#endif
+}
+
+// packs <X, Y, Theta> into a hash table key, returns false if the
+// coordinates do not fit into it
+static inline bool PackHashKey(int X, int Y, int Theta, unsigned long long* key)
+{
+    if ((unsigned int)X >= (1u << 24) || (unsigned int)Y >= (1u << 24) || (unsigned int)Theta >= (1u << 16)) {
+        return false;
+    }
+    *key = ((unsigned long long)X << 40) | ((unsigned long long)Y << 16) | (unsigned long long)Theta;
+    return true;
+}
+
+// index of the lookup table tile containing the cell and of the state inside the tile's page
+#define XY2LOOKUPTILE(X,Y) (((Y) >> NAVXYTHETALAT_LOOKUPTILESHIFT) * LookupTilesX + \
+                            ((X) >> NAVXYTHETALAT_LOOKUPTILESHIFT))
+#define XYTHETA2LOOKUPINDEX(X,Y,THETA) ((THETA) + EnvNAVXYTHETALATCfg.NumThetaDirs * \
+        ((((Y) & (NAVXYTHETALAT_LOOKUPTILESIZE - 1)) << NAVXYTHETALAT_LOOKUPTILESHIFT) + \
+         ((X) & (NAVXYTHETALAT_LOOKUPTILESIZE - 1))))
+
+// true if the CPU supports AVX2, checked once
+static bool CPUSupportsAVX2()
+{
+#if NAVXYTHETALAT_HAVE_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2") != 0;
+    return supported;
+#else
+    return false;
+#endif
+}
+
+// returns the max of sourcecell[offsets[i]] over the numofcells cells,
+// reduced in blocks of NAVXYTHETALAT_COLLISIONCHECK_BLOCKSIZE cells. It stops
+// after the first block that reaches thresh, so a result below thresh is the
+// max of all the cells.
+static inline unsigned char MaxCellCost(
+    const unsigned char* sourcecell, const int* offsets, int numofcells, unsigned char thresh)
+{
+    unsigned char maxcellcost = 0;
+    int i = 0;
+    while (i < numofcells) {
+        const int blockend = __min(i + NAVXYTHETALAT_COLLISIONCHECK_BLOCKSIZE, numofcells);
+        for (; i < blockend; i++) {
+            unsigned char cost = sourcecell[offsets[i]];
+            maxcellcost = cost > maxcellcost ? cost : maxcellcost;
+        }
+        if (maxcellcost >= thresh) {
+            break;
+        }
+    }
+    return maxcellcost;
+}
+
+#if NAVXYTHETALAT_HAVE_AVX2
+// MaxCellCost with the blocks of 8 cells loaded by one gather. Every gather
+// reads the 3 bytes after each cell too, the caller makes sure that they are
+// inside the costmap.
+__attribute__((target("avx2")))
+static unsigned char MaxCellCostAVX2(
+    const unsigned char* sourcecell, const int* offsets, int numofcells, unsigned char thresh)
+{
+    const __m256i bytemask = _mm256_set1_epi32(0xff);
+    const __m256i belowthresh = _mm256_set1_epi32((int)thresh - 1);
+    __m256i maxcosts = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= numofcells; i += 8) {
+        const __m256i blockoffsets = _mm256_loadu_si256((const __m256i*)(offsets + i));
+        const __m256i costs = _mm256_and_si256(
+                _mm256_i32gather_epi32((const int*)sourcecell, blockoffsets, 1), bytemask);
+        maxcosts = _mm256_max_epi32(maxcosts, costs);
+        const __m256i reached = _mm256_cmpgt_epi32(maxcosts, belowthresh);
+        if (!_mm256_testz_si256(reached, reached)) {
+            break;
+        }
+    }
+
+    // horizontal max of the 8 lanes
+    __m128i max4 = _mm_max_epi32(_mm256_castsi256_si128(maxcosts), _mm256_extracti128_si256(maxcosts, 1));
+    max4 = _mm_max_epi32(max4, _mm_shuffle_epi32(max4, _MM_SHUFFLE(1, 0, 3, 2)));
+    max4 = _mm_max_epi32(max4, _mm_shuffle_epi32(max4, _MM_SHUFFLE(2, 3, 0, 1)));
+    unsigned char maxcellcost = (unsigned char)_mm_cvtsi128_si32(max4);
+
+    if (maxcellcost >= thresh) {
+        return maxcellcost;
+    }
+
+    // the last partial block
+    for (; i < numofcells; i++) {
+        unsigned char cost = sourcecell[offsets[i]];
+        maxcellcost = cost > maxcellcost ? cost : maxcellcost;
+    }
+    return maxcellcost;
+}
+#else
+static inline unsigned char MaxCellCostAVX2(
+    const unsigned char* sourcecell, const int* offsets, int numofcells, unsigned char thresh)
+{
+    return MaxCellCost(sourcecell, offsets, numofcells, thresh);
+}
+#endif
+
+// returns true if any footprint cell of action from the source cell
+// <SourceX,SourceY> is set in mask. The footprint has to lie inside the map.
+static inline bool FootprintIntersectsMask(
+    const unsigned long long* mask, int maskstride, int SourceX, int SourceY,
+    const EnvNAVXYTHETALATAction_t* action)
+{
+    const EnvNAVXYTHETALATMaskRow_t* rows = action->footprintmaskrowsV.data();
+    const unsigned long long* words = action->footprintmaskwordsV.data();
+    const int numofrows = (int)action->footprintmaskrowsV.size();
+    for (int r = 0; r < numofrows; r++) {
+        const unsigned long long* maskrow = mask + (SourceY + rows[r].dY) * maskstride;
+        int bit = SourceX + rows[r].dX;
+        for (int w = 0; w < rows[r].numofwords; w++, bit += 64) {
+            // the 64 cells from bit on, the spare word at the end of the row
+            // makes maskrow[word + 1] valid
+            const int word = bit >> 6;
+            const int shift = bit & 63;
+            unsigned long long cells = maskrow[word] >> shift;
+            if (shift != 0) {
+                cells |= maskrow[word + 1] << (64 - shift);
+            }
+            if ((cells & words[rows[r].firstword + w]) != 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
 EnvironmentNAVXYTHETALATTICE::EnvironmentNAVXYTHETALATTICE()
 {
@@ -60,12 +258,22 @@ EnvironmentNAVXYTHETALATTICE::EnvironmentNAVXYTHETALATTICE()
 
     grid2Dsearchfromstart = NULL;
     grid2Dsearchfromgoal = NULL;
+    HeuristicThreads = 1;
     bNeedtoRecomputeStartHeuristics = true;
     bNeedtoRecomputeGoalHeuristics = true;
     iteration = 0;
+    checks = 0;
     bucketsize = 0; // fixed bucket size
     blocksize = 1;
     bUseNonUniformAngles = false;
+    bExternalGrid2D = false;
+    ActionCostMinBatch = NAVXYTHETALAT_DEFAULT_ACTIONCOSTMINBATCH;
+    bActionCostSIMD = CPUSupportsAVX2();
+    ObstacleMask = NULL;
+    ObstacleMaskStride = 0;
+    bFootprintBitmask = true;
+    bIncrementalHeuristics = true;
+    bLazyHeuristics = false;
 
     EnvNAVXYTHETALAT.bInitialized = false;
 
@@ -75,6 +283,7 @@ EnvironmentNAVXYTHETALATTICE::EnvironmentNAVXYTHETALATTICE()
 
     // no memory allocated in cfg yet
     EnvNAVXYTHETALATCfg.Grid2D = NULL;
+    EnvNAVXYTHETALATCfg.Grid2DVersion = 0;
     EnvNAVXYTHETALATCfg.ActionsV = NULL;
     EnvNAVXYTHETALATCfg.PredActionsV = NULL;
 }
@@ -93,40 +302,115 @@ EnvironmentNAVXYTHETALATTICE::~EnvironmentNAVXYTHETALATTICE()
     grid2Dsearchfromgoal = NULL;
 
     if (EnvNAVXYTHETALATCfg.Grid2D != NULL) {
-        for (int x = 0; x < EnvNAVXYTHETALATCfg.EnvWidth_c; x++) {
-            delete[] EnvNAVXYTHETALATCfg.Grid2D[x];
+        if (!bExternalGrid2D) {
+            FreeGrid2D(EnvNAVXYTHETALATCfg.Grid2D);
         }
-        delete[] EnvNAVXYTHETALATCfg.Grid2D;
         EnvNAVXYTHETALATCfg.Grid2D = NULL;
     }
 
-    //delete actions
-    if (EnvNAVXYTHETALATCfg.ActionsV != NULL) {
-        for (int tind = 0; tind < EnvNAVXYTHETALATCfg.NumThetaDirs; tind++) {
-            delete[] EnvNAVXYTHETALATCfg.ActionsV[tind];
-        }
-        delete[] EnvNAVXYTHETALATCfg.ActionsV;
-        EnvNAVXYTHETALATCfg.ActionsV = NULL;
+    //the actions are deleted with the last owner of ActionTable
+    EnvNAVXYTHETALATCfg.ActionsV = NULL;
+    EnvNAVXYTHETALATCfg.PredActionsV = NULL;
+}
+
+EnvNAVXYTHETALATActionTable_t::EnvNAVXYTHETALATActionTable_t(int numthetadirs)
+{
+    NumThetaDirs = numthetadirs;
+    ActionsV = new EnvNAVXYTHETALATAction_t*[NumThetaDirs];
+    for (int tind = 0; tind < NumThetaDirs; tind++) {
+        ActionsV[tind] = NULL;
     }
-    if (EnvNAVXYTHETALATCfg.PredActionsV != NULL) {
-        delete[] EnvNAVXYTHETALATCfg.PredActionsV;
-        EnvNAVXYTHETALATCfg.PredActionsV = NULL;
+    PredActionsV = new std::vector<EnvNAVXYTHETALATAction_t*>[NumThetaDirs];
+}
+
+EnvNAVXYTHETALATActionTable_t::~EnvNAVXYTHETALATActionTable_t()
+{
+    for (int tind = 0; tind < NumThetaDirs; tind++) {
+        delete[] ActionsV[tind];
     }
+    delete[] ActionsV;
+    delete[] PredActionsV;
 }
 
-static unsigned int inthash(unsigned int key)
+EnvNAVXYTHETALATLatticeModel::EnvNAVXYTHETALATLatticeModel()
 {
-    key += (key << 12);
-    key ^= (key >> 22);
-    key += (key << 4);
-    key ^= (key >> 9);
-    key += (key << 10);
-    key ^= (key >> 2);
-    key += (key << 7);
-    key ^= (key >> 12);
+    cfg.Grid2D = NULL;
+    cfg.ActionsV = NULL;
+    cfg.PredActionsV = NULL;
+    obstaclemaskstride = 0;
+    blocksize = 1;
+    bucketsize = 0;
+    bUseNonUniformAngles = false;
+}
+
+EnvNAVXYTHETALATLatticeModel::~EnvNAVXYTHETALATLatticeModel()
+{
+    if (cfg.Grid2D != NULL) {
+        FreeGrid2D(cfg.Grid2D);
+    }
+}
+
+static inline unsigned long long inthash(unsigned long long key)
+{
+    key ^= (key >> 33);
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= (key >> 33);
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= (key >> 33);
     return key;
 }
 
+// the binary motion primitive file holds, all in native byte order:
+//   "SBPLMPRM", version, numberofangles, resolution_m,
+//   angles (empty unless the angles are non-uniform), totalnumberofprimitives,
+//   for every primitive: motprimID, starttheta_c, endcell x y theta,
+//   additionalactioncostmult, turning_radius, intermediate poses,
+// where angles and poses are stored as their int size followed by the doubles
+static const char MotionPrimitivesMagic[8] = { 'S', 'B', 'P', 'L', 'M', 'P', 'R', 'M' };
+
+// reads the binary motion primitive and kernel cache files from a memory
+// mapped (or read in) buffer
+class BinaryReader
+{
+public:
+    BinaryReader(const unsigned char* data, size_t size) : ptr(data), end(data + size) { }
+
+    bool Read(void* out, size_t size)
+    {
+        if ((size_t)(end - ptr) < size) {
+            return false;
+        }
+        memcpy(out, ptr, size);
+        ptr += size;
+        return true;
+    }
+
+    template <typename T>
+    bool ReadVector(std::vector<T>* v)
+    {
+        int size;
+        if (!Read(&size, sizeof(size)) || size < 0 || (size_t)(end - ptr) / sizeof(T) < (size_t)size) {
+            return false;
+        }
+        v->resize(size);
+        return size == 0 || Read(v->data(), size * sizeof(T));
+    }
+
+    bool AtEnd() const { return ptr == end; }
+
+private:
+    const unsigned char* ptr;
+    const unsigned char* end;
+};
+
+template <typename T>
+static bool WriteVector(FILE* f, const std::vector<T>& v)
+{
+    int size = (int)v.size();
+    return fwrite(&size, sizeof(size), 1, f) == 1 &&
+           (size == 0 || fwrite(v.data(), sizeof(T), v.size(), f) == v.size());
+}
+
 void EnvironmentNAVXYTHETALATTICE::SetConfiguration(
     int width, int height, const unsigned char* mapdata,
     int startx, int starty, int starttheta,
@@ -186,34 +470,26 @@ void EnvironmentNAVXYTHETALATTICE::SetConfiguration(
 
     // unallocate the 2D environment
     if (EnvNAVXYTHETALATCfg.Grid2D != NULL) {
-        for (int x = 0; x < EnvNAVXYTHETALATCfg.EnvWidth_c; x++) {
-            delete[] EnvNAVXYTHETALATCfg.Grid2D[x];
+        if (!bExternalGrid2D) {
+            FreeGrid2D(EnvNAVXYTHETALATCfg.Grid2D);
         }
-        delete[] EnvNAVXYTHETALATCfg.Grid2D;
         EnvNAVXYTHETALATCfg.Grid2D = NULL;
     }
 
     // allocate the 2D environment
-    EnvNAVXYTHETALATCfg.Grid2D = new unsigned char*[EnvNAVXYTHETALATCfg.EnvWidth_c];
-    for (int x = 0; x < EnvNAVXYTHETALATCfg.EnvWidth_c; x++) {
-        EnvNAVXYTHETALATCfg.Grid2D[x] = new unsigned char[EnvNAVXYTHETALATCfg.EnvHeight_c];
-    }
+    EnvNAVXYTHETALATCfg.Grid2DStride = EnvNAVXYTHETALATCfg.EnvWidth_c;
+    bExternalGrid2D = false;
+    const size_t gridsize = (size_t)EnvNAVXYTHETALATCfg.Grid2DStride * EnvNAVXYTHETALATCfg.EnvHeight_c;
+    EnvNAVXYTHETALATCfg.Grid2D = AllocateGrid2D(gridsize);
 
     // environment:
     if (0 == mapdata) {
-        for (int y = 0; y < EnvNAVXYTHETALATCfg.EnvHeight_c; y++) {
-            for (int x = 0; x < EnvNAVXYTHETALATCfg.EnvWidth_c; x++) {
-                EnvNAVXYTHETALATCfg.Grid2D[x][y] = 0;
-            }
-        }
+        memset(EnvNAVXYTHETALATCfg.Grid2D, 0, gridsize);
     }
     else {
-        for (int y = 0; y < EnvNAVXYTHETALATCfg.EnvHeight_c; y++) {
-            for (int x = 0; x < EnvNAVXYTHETALATCfg.EnvWidth_c; x++) {
-                EnvNAVXYTHETALATCfg.Grid2D[x][y] = mapdata[x + y * width];
-            }
-        }
+        memcpy(EnvNAVXYTHETALATCfg.Grid2D, mapdata, gridsize);
     }
+    HashGrid2D();
 }
 
 void EnvironmentNAVXYTHETALATTICE::ReadConfiguration(FILE* fCfg)
@@ -431,18 +707,17 @@ void EnvironmentNAVXYTHETALATTICE::ReadConfiguration(FILE* fCfg)
 
     // unallocate the 2d environment
     if (EnvNAVXYTHETALATCfg.Grid2D != NULL) {
-        for (x = 0; x < EnvNAVXYTHETALATCfg.EnvWidth_c; x++) {
-            delete[] EnvNAVXYTHETALATCfg.Grid2D[x];
+        if (!bExternalGrid2D) {
+            FreeGrid2D(EnvNAVXYTHETALATCfg.Grid2D);
         }
-        delete[] EnvNAVXYTHETALATCfg.Grid2D;
         EnvNAVXYTHETALATCfg.Grid2D = NULL;
     }
 
     // allocate the 2D environment
-    EnvNAVXYTHETALATCfg.Grid2D = new unsigned char*[EnvNAVXYTHETALATCfg.EnvWidth_c];
-    for (x = 0; x < EnvNAVXYTHETALATCfg.EnvWidth_c; x++) {
-        EnvNAVXYTHETALATCfg.Grid2D[x] = new unsigned char[EnvNAVXYTHETALATCfg.EnvHeight_c];
-    }
+    EnvNAVXYTHETALATCfg.Grid2DStride = EnvNAVXYTHETALATCfg.EnvWidth_c;
+    bExternalGrid2D = false;
+    EnvNAVXYTHETALATCfg.Grid2D = AllocateGrid2D(
+            (size_t)EnvNAVXYTHETALATCfg.Grid2DStride * EnvNAVXYTHETALATCfg.EnvHeight_c);
 
     // environment:
     if (fscanf(fCfg, "%s", sTemp) != 1) {
@@ -453,9 +728,10 @@ void EnvironmentNAVXYTHETALATTICE::ReadConfiguration(FILE* fCfg)
             if (fscanf(fCfg, "%d", &dTemp) != 1) {
                 throw SBPL_Exception("ERROR: incorrect format of config file");
             }
-            EnvNAVXYTHETALATCfg.Grid2D[x][y] = dTemp;
+            EnvNAVXYTHETALATCfg.Grid2DCell(x, y) = dTemp;
         }
     }
+    HashGrid2D();
 
     EnvNAVXYTHETALATCfg.StartTheta = ContTheta2DiscNew(EnvNAVXYTHETALATCfg.StartTheta_rad);
     if (EnvNAVXYTHETALATCfg.StartTheta < 0 ||
@@ -726,6 +1002,17 @@ bool EnvironmentNAVXYTHETALATTICE::ReadinMotionPrimitive(
         pMotPrim->intermptV.push_back(intermpose);
     }
 
+    return CheckMotionPrimitive(pMotPrim);
+}
+
+bool EnvironmentNAVXYTHETALATTICE::CheckMotionPrimitive(const SBPL_xytheta_mprimitive* pMotPrim) const
+{
+    if (pMotPrim->intermptV.empty()) {
+        SBPL_ERROR("ERROR: primitive %d with startangle=%d has no intermediate poses\n",
+                   pMotPrim->motprimID, pMotPrim->starttheta_c);
+        return false;
+    }
+
     // Check that the last pose of the motion matches (within lattice
     // resolution) the designated end pose of the primitive
     sbpl_xy_theta_pt_t sourcepose;
@@ -773,6 +1060,16 @@ bool EnvironmentNAVXYTHETALATTICE::ReadMotionPrimitives(FILE* fMotPrims)
     SBPL_INFO("Reading in motion primitives...");
     fflush(stdout);
 
+    // binary files start with their magic, text ones with the resolution
+    char magic[sizeof(MotionPrimitivesMagic)];
+    long start = ftell(fMotPrims);
+    if (fread(magic, 1, sizeof(magic), fMotPrims) == sizeof(magic) &&
+        memcmp(magic, MotionPrimitivesMagic, sizeof(magic)) == 0)
+    {
+        return ReadMotionPrimitivesBinary(fMotPrims);
+    }
+    fseek(fMotPrims, start, SEEK_SET);
+
     //read in the resolution
     strcpy(sExpected, "resolution_m:");
     if (fscanf(fMotPrims, "%s", sTemp) == 0) {
@@ -892,10 +1189,149 @@ bool EnvironmentNAVXYTHETALATTICE::ReadMotionPrimitives(FILE* fMotPrims)
     return true;
 }
 
+bool EnvironmentNAVXYTHETALATTICE::ReadMotionPrimitivesBinary(FILE* fMotPrims)
+{
+    // read the rest of the file (everything after the magic) at once
+    long start = ftell(fMotPrims);
+    if (start < 0 || fseek(fMotPrims, 0, SEEK_END) != 0) {
+        return false;
+    }
+    long end = ftell(fMotPrims);
+    if (end < start || fseek(fMotPrims, start, SEEK_SET) != 0) {
+        return false;
+    }
+    std::vector<unsigned char> buffer(end - start);
+    if (!buffer.empty() && fread(buffer.data(), 1, buffer.size(), fMotPrims) != buffer.size()) {
+        SBPL_ERROR("ERROR: failed to read in binary motion primitives\n");
+        return false;
+    }
+
+    BinaryReader reader(buffer.data(), buffer.size());
+    int version, numofangles, totalNumofActions;
+    double resolution;
+    std::vector<double> angles;
+    if (!reader.Read(&version, sizeof(version)) || version != NAVXYTHETALAT_MPRIMBINARY_VERSION) {
+        SBPL_ERROR("ERROR: unsupported binary motion primitive file version\n");
+        return false;
+    }
+    if (!reader.Read(&numofangles, sizeof(numofangles)) ||
+        !reader.Read(&resolution, sizeof(resolution)) ||
+        !reader.ReadVector(&angles) ||
+        !reader.Read(&totalNumofActions, sizeof(totalNumofActions)) ||
+        totalNumofActions < 0)
+    {
+        SBPL_ERROR("ERROR: truncated binary motion primitive file\n");
+        return false;
+    }
+
+    if (fabs(resolution - EnvNAVXYTHETALATCfg.cellsize_m) > ERR_EPS) {
+        SBPL_ERROR("ERROR: invalid resolution %f (instead of %f) in the dynamics file\n", resolution, EnvNAVXYTHETALATCfg.cellsize_m);
+        return false;
+    }
+    if (numofangles != EnvNAVXYTHETALATCfg.NumThetaDirs) {
+        SBPL_ERROR("ERROR: invalid angular resolution %d angles (instead of %d angles) in the motion primitives file\n", numofangles, EnvNAVXYTHETALATCfg.NumThetaDirs);
+        return false;
+    }
+    if (!angles.empty()) {
+        if ((int)angles.size() != numofangles) {
+            SBPL_ERROR("ERROR: expected %d angles but got %d\n", numofangles, (int)angles.size());
+            return false;
+        }
+        bUseNonUniformAngles = true;
+        EnvNAVXYTHETALATCfg.ThetaDirs = angles;
+        EnvNAVXYTHETALATCfg.ThetaDirs.push_back(2.0 * M_PI); // Add 2 PI at end for overlap
+    }
+    SBPL_PRINTF("resolution_m: %f numberofangles: %d totalnumberofprimitives: %d\n", resolution, numofangles, totalNumofActions);
+
+    std::vector<SBPL_xytheta_mprimitive> mprimV(totalNumofActions);
+    for (int i = 0; i < totalNumofActions; i++) {
+        SBPL_xytheta_mprimitive* motprim = &mprimV[i];
+        if (!reader.Read(&motprim->motprimID, sizeof(int)) ||
+            !reader.Read(&motprim->starttheta_c, sizeof(int)) ||
+            !reader.Read(&motprim->endcell.x, sizeof(int)) ||
+            !reader.Read(&motprim->endcell.y, sizeof(int)) ||
+            !reader.Read(&motprim->endcell.theta, sizeof(int)) ||
+            !reader.Read(&motprim->additionalactioncostmult, sizeof(int)) ||
+            !reader.Read(&motprim->turning_radius, sizeof(double)) ||
+            !reader.ReadVector(&motprim->intermptV))
+        {
+            SBPL_ERROR("ERROR: truncated binary motion primitive file\n");
+            return false;
+        }
+        motprim->endcell.theta = normalizeDiscAngle(motprim->endcell.theta);
+        for (size_t pind = 0; pind < motprim->intermptV.size(); pind++) {
+            motprim->intermptV[pind].theta = normalizeAngle(motprim->intermptV[pind].theta);
+        }
+        if (!CheckMotionPrimitive(motprim)) {
+            return false;
+        }
+    }
+    if (!reader.AtEnd()) {
+        SBPL_ERROR("ERROR: unexpected data at the end of the binary motion primitive file\n");
+        return false;
+    }
+
+    EnvNAVXYTHETALATCfg.mprimV.insert(EnvNAVXYTHETALATCfg.mprimV.end(), mprimV.begin(), mprimV.end());
+    SBPL_PRINTF("done");
+    SBPL_FFLUSH(stdout);
+    return true;
+}
+
+bool EnvironmentNAVXYTHETALATTICE::WriteMotionPrimitivesBinary(const char* filename) const
+{
+    FILE* f = fopen(filename, "wb");
+    if (f == NULL) {
+        SBPL_ERROR("ERROR: unable to open %s\n", filename);
+        return false;
+    }
+
+    int version = NAVXYTHETALAT_MPRIMBINARY_VERSION;
+    int numofangles = EnvNAVXYTHETALATCfg.NumThetaDirs;
+    double resolution = EnvNAVXYTHETALATCfg.cellsize_m;
+    std::vector<double> angles;
+    if (bUseNonUniformAngles) {
+        angles.assign(EnvNAVXYTHETALATCfg.ThetaDirs.begin(), EnvNAVXYTHETALATCfg.ThetaDirs.begin() + numofangles);
+    }
+    int totalNumofActions = (int)EnvNAVXYTHETALATCfg.mprimV.size();
+    bool written = fwrite(MotionPrimitivesMagic, sizeof(MotionPrimitivesMagic), 1, f) == 1 &&
+            fwrite(&version, sizeof(version), 1, f) == 1 &&
+            fwrite(&numofangles, sizeof(numofangles), 1, f) == 1 &&
+            fwrite(&resolution, sizeof(resolution), 1, f) == 1 &&
+            WriteVector(f, angles) &&
+            fwrite(&totalNumofActions, sizeof(totalNumofActions), 1, f) == 1;
+    for (int i = 0; written && i < totalNumofActions; i++) {
+        const SBPL_xytheta_mprimitive* motprim = &EnvNAVXYTHETALATCfg.mprimV[i];
+        // the turning radius is only read in for non-uniform angles
+        double turning_radius = bUseNonUniformAngles ? motprim->turning_radius : 0.0;
+        int fields[6] = {
+            motprim->motprimID, motprim->starttheta_c,
+            motprim->endcell.x, motprim->endcell.y, motprim->endcell.theta,
+            motprim->additionalactioncostmult
+        };
+        written = fwrite(fields, sizeof(fields), 1, f) == 1 &&
+                fwrite(&turning_radius, sizeof(turning_radius), 1, f) == 1 &&
+                WriteVector(f, motprim->intermptV);
+    }
+    written = (fclose(f) == 0) && written;
+    if (!written) {
+        SBPL_ERROR("ERROR: failed to write motion primitives to %s\n", filename);
+    }
+    return written;
+}
+
 void EnvironmentNAVXYTHETALATTICE::ComputeReplanningDataforAction(
     EnvNAVXYTHETALATAction_t* action)
 {
-    int j;
+    // the sets are only kept while ComputeReplanningData runs, rebuild them
+    // if the states were changed since
+    if (affectedsuccstatesS.size() != affectedsuccstatesV.size()) {
+        affectedsuccstatesS.clear();
+        affectedsuccstatesS.insert(affectedsuccstatesV.begin(), affectedsuccstatesV.end());
+    }
+    if (affectedpredstatesS.size() != affectedpredstatesV.size()) {
+        affectedpredstatesS.clear();
+        affectedpredstatesS.insert(affectedpredstatesV.begin(), affectedpredstatesV.end());
+    }
 
     // iterate over all the cells involved in the action
     sbpl_xy_theta_cell_t startcell3d, endcell3d;
@@ -918,23 +1354,7 @@ void EnvironmentNAVXYTHETALATTICE::ComputeReplanningDataforAction(
         endcell3d.y = startcell3d.y + action->dY;
 
         //store the cells if not already there
-        for (j = 0; j < (int)affectedsuccstatesV.size(); j++) {
-            if (affectedsuccstatesV.at(j) == endcell3d) {
-                break;
-            }
-        }
-        if (j == (int)affectedsuccstatesV.size()) {
-            affectedsuccstatesV.push_back(endcell3d);
-        }
-
-        for (j = 0; j < (int)affectedpredstatesV.size(); j++) {
-            if (affectedpredstatesV.at(j) == startcell3d) {
-                break;
-            }
-        }
-        if (j == (int)affectedpredstatesV.size()) {
-            affectedpredstatesV.push_back(startcell3d);
-        }
+        AddAffectedStates(startcell3d, endcell3d);
     } // over intersecting cells
 
     // add the centers since with h2d we are using these in cost computations
@@ -957,23 +1377,7 @@ void EnvironmentNAVXYTHETALATTICE::ComputeReplanningDataforAction(
     endcell3d.y = startcell3d.y + action->dY;
 
     //store the cells if not already there
-    for (j = 0; j < (int)affectedsuccstatesV.size(); j++) {
-        if (affectedsuccstatesV.at(j) == endcell3d) {
-            break;
-        }
-    }
-    if (j == (int)affectedsuccstatesV.size()) {
-        affectedsuccstatesV.push_back(endcell3d);
-    }
-
-    for (j = 0; j < (int)affectedpredstatesV.size(); j++) {
-        if (affectedpredstatesV.at(j) == startcell3d) {
-            break;
-        }
-    }
-    if (j == (int)affectedpredstatesV.size()) {
-        affectedpredstatesV.push_back(startcell3d);
-    }
+    AddAffectedStates(startcell3d, endcell3d);
 
     //---intersecting cell = outcome state
     // compute the translated affected search Pose - what state has an outgoing
@@ -993,22 +1397,20 @@ void EnvironmentNAVXYTHETALATTICE::ComputeReplanningDataforAction(
     endcell3d.x = startcell3d.x + action->dX;
     endcell3d.y = startcell3d.y + action->dY;
 
-    for (j = 0; j < (int)affectedsuccstatesV.size(); j++) {
-        if (affectedsuccstatesV.at(j) == endcell3d) {
-            break;
-        }
-    }
-    if (j == (int)affectedsuccstatesV.size()) {
-        affectedsuccstatesV.push_back(endcell3d);
-    }
+    AddAffectedStates(startcell3d, endcell3d);
+}
 
-    for (j = 0; j < (int)affectedpredstatesV.size(); j++) {
-        if (affectedpredstatesV.at(j) == startcell3d) {
-            break;
-        }
+// appends the states to affectedpredstatesV and affectedsuccstatesV unless
+// they are there already, keeping the order in which they were first added
+void EnvironmentNAVXYTHETALATTICE::AddAffectedStates(
+    const sbpl_xy_theta_cell_t& predcell3d,
+    const sbpl_xy_theta_cell_t& succcell3d)
+{
+    if (affectedsuccstatesS.insert(succcell3d).second) {
+        affectedsuccstatesV.push_back(succcell3d);
     }
-    if (j == (int)affectedpredstatesV.size()) {
-        affectedpredstatesV.push_back(startcell3d);
+    if (affectedpredstatesS.insert(predcell3d).second) {
+        affectedpredstatesV.push_back(predcell3d);
     }
 }
 
@@ -1027,16 +1429,129 @@ void EnvironmentNAVXYTHETALATTICE::ComputeReplanningData()
             ComputeReplanningDataforAction(&EnvNAVXYTHETALATCfg.ActionsV[tind][aind]);
         }
     }
+
+    // the sets are only needed for deduplication
+    affectedsuccstatesS.clear();
+    affectedpredstatesS.clear();
 }
 
+// sorts the collision cells of the action so that the ones farthest from the
+// source cell (the most likely to be in collision) are checked first and
+// computes the bounding box of all the cells the action touches
+void EnvironmentNAVXYTHETALATTICE::ComputeCollisionDataforAction(
+    EnvNAVXYTHETALATAction_t* action)
+{
+    std::stable_sort(
+            action->intersectingcellsV.begin(),
+            action->intersectingcellsV.end(),
+            [](const sbpl_2Dcell_t& a, const sbpl_2Dcell_t& b) {
+                return a.x * a.x + a.y * a.y > b.x * b.x + b.y * b.y;
+            });
+
+    action->minX = __min(0, action->dX);
+    action->minY = __min(0, action->dY);
+    action->maxX = __max(0, action->dX);
+    action->maxY = __max(0, action->dY);
+    for (size_t i = 0; i < action->interm3DcellsV.size(); i++) {
+        action->minX = __min(action->minX, action->interm3DcellsV[i].x);
+        action->minY = __min(action->minY, action->interm3DcellsV[i].y);
+        action->maxX = __max(action->maxX, action->interm3DcellsV[i].x);
+        action->maxY = __max(action->maxY, action->interm3DcellsV[i].y);
+    }
+    for (size_t i = 0; i < action->intersectingcellsV.size(); i++) {
+        action->minX = __min(action->minX, action->intersectingcellsV[i].x);
+        action->minY = __min(action->minY, action->intersectingcellsV[i].y);
+        action->maxX = __max(action->maxX, action->intersectingcellsV[i].x);
+        action->maxY = __max(action->maxY, action->intersectingcellsV[i].y);
+    }
+
+    // the intermediate cells are checked from the end of the primitive
+    const int width = EnvNAVXYTHETALATCfg.EnvWidth_c;
+    const int numintermcells = (int)action->interm3DcellsV.size();
+    action->interm2DoffsetsV.resize(numintermcells);
+    for (int i = 0; i < numintermcells; i++) {
+        const sbpl_xy_theta_cell_t& cell = action->interm3DcellsV[numintermcells - 1 - i];
+        action->interm2DoffsetsV[i] = cell.y * width + cell.x;
+    }
+    action->intersectingoffsetsV.resize(action->intersectingcellsV.size());
+    for (size_t i = 0; i < action->intersectingcellsV.size(); i++) {
+        action->intersectingoffsetsV[i] = action->intersectingcellsV[i].y * width + action->intersectingcellsV[i].x;
+    }
+
+    // the footprint rows, ordered by their first cell in intersectingcellsV
+    action->footprintmaskrowsV.clear();
+    action->footprintmaskwordsV.clear();
+    std::vector<int> rowcells;
+    for (size_t i = 0; i < action->intersectingcellsV.size(); i++) {
+        const int dY = action->intersectingcellsV[i].y;
+        bool bnewrow = true;
+        for (size_t r = 0; r < action->footprintmaskrowsV.size(); r++) {
+            if (action->footprintmaskrowsV[r].dY == dY) {
+                bnewrow = false;
+                break;
+            }
+        }
+        if (!bnewrow) {
+            continue;
+        }
+
+        rowcells.clear();
+        for (size_t j = i; j < action->intersectingcellsV.size(); j++) {
+            if (action->intersectingcellsV[j].y == dY) {
+                rowcells.push_back(action->intersectingcellsV[j].x);
+            }
+        }
+        const int minx = *std::min_element(rowcells.begin(), rowcells.end());
+        const int maxx = *std::max_element(rowcells.begin(), rowcells.end());
+
+        EnvNAVXYTHETALATMaskRow_t row;
+        row.dX = minx;
+        row.dY = dY;
+        row.firstword = (int)action->footprintmaskwordsV.size();
+        row.numofwords = (maxx - minx) / 64 + 1;
+        action->footprintmaskwordsV.resize(row.firstword + row.numofwords, 0);
+        for (size_t j = 0; j < rowcells.size(); j++) {
+            const int bit = rowcells[j] - minx;
+            action->footprintmaskwordsV[row.firstword + bit / 64] |= 1ULL << (bit % 64);
+        }
+        action->footprintmaskrowsV.push_back(row);
+    }
+}
+
+// calls fn(i) for every i in [0, n), spreading the calls over the hardware threads
+template <typename Fn>
+static void ParallelFor(int n, Fn fn)
+{
+    int numthreads = __min(n, (int)std::thread::hardware_concurrency());
+    if (numthreads <= 1) {
+        for (int i = 0; i < n; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<int> next(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numthreads; t++) {
+        threads.push_back(std::thread([&next, n, &fn]() {
+            for (int i = next++; i < n; i = next++) {
+                fn(i);
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+}
 
 // here motionprimitivevector contains actions for all angles
 void EnvironmentNAVXYTHETALATTICE::PrecomputeActionswithCompleteMotionPrimitive(
     std::vector<SBPL_xytheta_mprimitive>* motionprimitiveV, bool computeKernels)
 {
     SBPL_PRINTF("Pre-computing action data using motion primitives for every angle...\n");
-    EnvNAVXYTHETALATCfg.ActionsV = new EnvNAVXYTHETALATAction_t*[EnvNAVXYTHETALATCfg.NumThetaDirs];
-    EnvNAVXYTHETALATCfg.PredActionsV = new std::vector<EnvNAVXYTHETALATAction_t*>[EnvNAVXYTHETALATCfg.NumThetaDirs];
+    ActionTable = std::make_shared<EnvNAVXYTHETALATActionTable_t>(EnvNAVXYTHETALATCfg.NumThetaDirs);
+    EnvNAVXYTHETALATCfg.ActionsV = ActionTable->ActionsV;
+    EnvNAVXYTHETALATCfg.PredActionsV = ActionTable->PredActionsV;
     std::vector<sbpl_2Dcell_t> footprint;
 
     if (motionprimitiveV->size() % EnvNAVXYTHETALATCfg.NumThetaDirs != 0) {
@@ -1162,19 +1677,10 @@ void EnvironmentNAVXYTHETALATTICE::PrecomputeActionswithCompleteMotionPrimitive(
             // use any additional cost multiplier
             EnvNAVXYTHETALATCfg.ActionsV[tind][aind].cost *= motionprimitiveV->at(mind).additionalactioncostmult;
 
-            if (computeKernels) {
-                // now compute the intersecting cells for this motion (including ignoring the source footprint)
-                get_2d_motion_cells(
-                        EnvNAVXYTHETALATCfg.FootprintPolygon,
-                        motionprimitiveV->at(mind).intermptV,
-                        &EnvNAVXYTHETALATCfg.ActionsV[tind][aind].intersectingcellsV,
-                        EnvNAVXYTHETALATCfg.cellsize_m);
-            }
-
 #if DEBUG
             SBPL_DEBUG(
                          "action tind=%2d aind=%2d: dX=%3d dY=%3d endtheta=%3d (%6.2f degs -> %6.2f degs) "
-                         "cost=%4d (mprimID %3d: %3d %3d %3d) numofintermcells = %d numofintercells=%d\n",
+                         "cost=%4d (mprimID %3d: %3d %3d %3d) numofintermcells = %d\n",
                          tind,
                          aind,
                          EnvNAVXYTHETALATCfg.ActionsV[tind][aind].dX,
@@ -1185,8 +1691,7 @@ void EnvironmentNAVXYTHETALATTICE::PrecomputeActionswithCompleteMotionPrimitive(
                          EnvNAVXYTHETALATCfg.ActionsV[tind][aind].cost,
                          motionprimitiveV->at(mind).motprimID, motionprimitiveV->at(mind).endcell.x,
                          motionprimitiveV->at(mind).endcell.y, motionprimitiveV->at(mind).endcell.theta,
-                         (int)EnvNAVXYTHETALATCfg.ActionsV[tind][aind].interm3DcellsV.size(),
-                         (int)EnvNAVXYTHETALATCfg.ActionsV[tind][aind].intersectingcellsV.size());
+                         (int)EnvNAVXYTHETALATCfg.ActionsV[tind][aind].interm3DcellsV.size());
 #endif
 
             // add to the list of backward actions
@@ -1213,12 +1718,240 @@ void EnvironmentNAVXYTHETALATTICE::PrecomputeActionswithCompleteMotionPrimitive(
         throw SBPL_Exception(ss.str());
     }
 
-    // now compute replanning data
-    ComputeReplanningData();
+    unsigned long long cachekey = 0;
+    std::string cachefilename;
+    bool cacheloaded = false;
+    if (computeKernels && !KernelCacheDirectory.empty()) {
+        cachekey = ComputeKernelCacheKey(motionprimitiveV);
+        cachefilename = GetKernelCacheFilename(cachekey);
+        cacheloaded = LoadKernelCache(cachefilename, cachekey);
+        if (cacheloaded) {
+            SBPL_PRINTF("loaded motion primitive kernels from %s\n", cachefilename.c_str());
+        }
+    }
+
+    if (computeKernels && !cacheloaded) {
+        // now compute the intersecting cells for each motion (including
+        // ignoring the source footprint). Every action only writes its own
+        // cells, so the result does not depend on the threads
+        ParallelFor(EnvNAVXYTHETALATCfg.NumThetaDirs, [this](int tind) {
+            for (int aind = 0; aind < EnvNAVXYTHETALATCfg.actionwidth; aind++) {
+                EnvNAVXYTHETALATAction_t* action = &EnvNAVXYTHETALATCfg.ActionsV[tind][aind];
+                get_2d_motion_cells(
+                        EnvNAVXYTHETALATCfg.FootprintPolygon,
+                        action->intermptV,
+                        &action->intersectingcellsV,
+                        EnvNAVXYTHETALATCfg.cellsize_m);
+            }
+        });
+    }
+
+    // now compute replanning data (the cache already has it)
+    if (!cacheloaded) {
+        ComputeReplanningData();
+    }
+
+    // collision cell order and bounding boxes are computed after the
+    // replanning data so that the latter does not depend on the order
+    ParallelFor(EnvNAVXYTHETALATCfg.NumThetaDirs, [this](int tind) {
+        for (int aind = 0; aind < EnvNAVXYTHETALATCfg.actionwidth; aind++) {
+            ComputeCollisionDataforAction(&EnvNAVXYTHETALATCfg.ActionsV[tind][aind]);
+        }
+    });
+
+    if (computeKernels && !cacheloaded && !cachefilename.empty()) {
+        if (!SaveKernelCache(cachefilename, cachekey)) {
+            SBPL_WARN("WARNING: failed to write motion primitive kernel cache %s\n", cachefilename.c_str());
+        }
+    }
 
     SBPL_PRINTF("done pre-computing action data based on motion primitives\n");
 }
 
+void EnvironmentNAVXYTHETALATTICE::SetKernelCacheDirectory(const char* directory)
+{
+    KernelCacheDirectory = directory != NULL ? directory : "";
+}
+
+// FNV-1a hash of size bytes at data, continuing from hash
+static unsigned long long HashBytes(unsigned long long hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// hash of everything the kernels and the replanning data depend on
+unsigned long long EnvironmentNAVXYTHETALATTICE::ComputeKernelCacheKey(
+    const std::vector<SBPL_xytheta_mprimitive>* motionprimitiveV) const
+{
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    int version = NAVXYTHETALAT_KERNELCACHE_VERSION;
+    hash = HashBytes(hash, &version, sizeof(version));
+    hash = HashBytes(hash, &EnvNAVXYTHETALATCfg.NumThetaDirs, sizeof(EnvNAVXYTHETALATCfg.NumThetaDirs));
+    hash = HashBytes(hash, &EnvNAVXYTHETALATCfg.cellsize_m, sizeof(EnvNAVXYTHETALATCfg.cellsize_m));
+    hash = HashBytes(hash, &bUseNonUniformAngles, sizeof(bUseNonUniformAngles));
+    if (bUseNonUniformAngles) {
+        hash = HashBytes(hash, EnvNAVXYTHETALATCfg.ThetaDirs.data(),
+                         EnvNAVXYTHETALATCfg.ThetaDirs.size() * sizeof(double));
+    }
+    for (size_t i = 0; i < EnvNAVXYTHETALATCfg.FootprintPolygon.size(); i++) {
+        hash = HashBytes(hash, &EnvNAVXYTHETALATCfg.FootprintPolygon[i].x, sizeof(double));
+        hash = HashBytes(hash, &EnvNAVXYTHETALATCfg.FootprintPolygon[i].y, sizeof(double));
+    }
+    for (size_t mind = 0; mind < motionprimitiveV->size(); mind++) {
+        const SBPL_xytheta_mprimitive& mprim = motionprimitiveV->at(mind);
+        hash = HashBytes(hash, &mprim.starttheta_c, sizeof(mprim.starttheta_c));
+        hash = HashBytes(hash, &mprim.endcell.x, sizeof(mprim.endcell.x));
+        hash = HashBytes(hash, &mprim.endcell.y, sizeof(mprim.endcell.y));
+        hash = HashBytes(hash, &mprim.endcell.theta, sizeof(mprim.endcell.theta));
+        for (size_t pind = 0; pind < mprim.intermptV.size(); pind++) {
+            hash = HashBytes(hash, &mprim.intermptV[pind].x, sizeof(double));
+            hash = HashBytes(hash, &mprim.intermptV[pind].y, sizeof(double));
+            hash = HashBytes(hash, &mprim.intermptV[pind].theta, sizeof(double));
+        }
+    }
+    return hash;
+}
+
+std::string EnvironmentNAVXYTHETALATTICE::GetKernelCacheFilename(unsigned long long key) const
+{
+    char name[64];
+    sprintf(name, "sbpl_kernels_%016llx.bin", key);
+    std::string filename = KernelCacheDirectory;
+    if (filename[filename.size() - 1] != '/') {
+        filename += '/';
+    }
+    return filename + name;
+}
+
+// the cache file holds, all in native byte order:
+//   "SBPLKERN", version, key, NumThetaDirs, actionwidth,
+//   for every action: interm3DcellsV, intersectingcellsV,
+//   affectedsuccstatesV, affectedpredstatesV,
+// where every vector is stored as its int size followed by its elements
+static const char KernelCacheMagic[8] = { 'S', 'B', 'P', 'L', 'K', 'E', 'R', 'N' };
+
+bool EnvironmentNAVXYTHETALATTICE::LoadKernelCache(const std::string& filename, unsigned long long key)
+{
+    const unsigned char* data = NULL;
+    size_t size = 0;
+#ifndef WIN32
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    size = (size_t)st.st_size;
+    void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    data = (const unsigned char*)mapped;
+#else
+    std::vector<unsigned char> buffer;
+    FILE* f = fopen(filename.c_str(), "rb");
+    if (f == NULL) {
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    buffer.resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    bool read = buffer.size() > 0 && fread(buffer.data(), 1, buffer.size(), f) == buffer.size();
+    fclose(f);
+    if (!read) {
+        return false;
+    }
+    data = buffer.data();
+    size = buffer.size();
+#endif
+
+    BinaryReader reader(data, size);
+    char magic[sizeof(KernelCacheMagic)];
+    int version, numthetadirs, actionwidth;
+    unsigned long long filekey;
+    bool valid = reader.Read(magic, sizeof(magic)) &&
+            memcmp(magic, KernelCacheMagic, sizeof(magic)) == 0 &&
+            reader.Read(&version, sizeof(version)) && version == NAVXYTHETALAT_KERNELCACHE_VERSION &&
+            reader.Read(&filekey, sizeof(filekey)) && filekey == key &&
+            reader.Read(&numthetadirs, sizeof(numthetadirs)) && numthetadirs == EnvNAVXYTHETALATCfg.NumThetaDirs &&
+            reader.Read(&actionwidth, sizeof(actionwidth)) && actionwidth == EnvNAVXYTHETALATCfg.actionwidth;
+
+    // read into temporaries so that a truncated file leaves the actions alone
+    std::vector<std::vector<sbpl_xy_theta_cell_t> > interm3DcellsV;
+    std::vector<std::vector<sbpl_2Dcell_t> > intersectingcellsV;
+    std::vector<sbpl_xy_theta_cell_t> succstatesV, predstatesV;
+    if (valid) {
+        interm3DcellsV.resize(numthetadirs * actionwidth);
+        intersectingcellsV.resize(numthetadirs * actionwidth);
+        for (int i = 0; valid && i < numthetadirs * actionwidth; i++) {
+            valid = reader.ReadVector(&interm3DcellsV[i]) && reader.ReadVector(&intersectingcellsV[i]);
+        }
+        valid = valid && reader.ReadVector(&succstatesV) && reader.ReadVector(&predstatesV) && reader.AtEnd();
+    }
+
+#ifndef WIN32
+    munmap((void*)data, size);
+#endif
+
+    if (!valid) {
+        SBPL_WARN("WARNING: ignoring invalid motion primitive kernel cache %s\n", filename.c_str());
+        return false;
+    }
+
+    for (int tind = 0; tind < numthetadirs; tind++) {
+        for (int aind = 0; aind < actionwidth; aind++) {
+            EnvNAVXYTHETALATAction_t* action = &EnvNAVXYTHETALATCfg.ActionsV[tind][aind];
+            action->interm3DcellsV.swap(interm3DcellsV[tind * actionwidth + aind]);
+            action->intersectingcellsV.swap(intersectingcellsV[tind * actionwidth + aind]);
+        }
+    }
+    affectedsuccstatesV.swap(succstatesV);
+    affectedpredstatesV.swap(predstatesV);
+    return true;
+}
+
+bool EnvironmentNAVXYTHETALATTICE::SaveKernelCache(const std::string& filename, unsigned long long key) const
+{
+    // write to a temporary file and rename it so that other processes never
+    // see a partially written cache
+    std::stringstream tmpfilename;
+    tmpfilename << filename << ".tmp" << (unsigned long long)(size_t)this << "." << (unsigned long long)time(NULL);
+    FILE* f = fopen(tmpfilename.str().c_str(), "wb");
+    if (f == NULL) {
+        return false;
+    }
+
+    int version = NAVXYTHETALAT_KERNELCACHE_VERSION;
+    bool written = fwrite(KernelCacheMagic, sizeof(KernelCacheMagic), 1, f) == 1 &&
+            fwrite(&version, sizeof(version), 1, f) == 1 &&
+            fwrite(&key, sizeof(key), 1, f) == 1 &&
+            fwrite(&EnvNAVXYTHETALATCfg.NumThetaDirs, sizeof(int), 1, f) == 1 &&
+            fwrite(&EnvNAVXYTHETALATCfg.actionwidth, sizeof(int), 1, f) == 1;
+    for (int tind = 0; written && tind < EnvNAVXYTHETALATCfg.NumThetaDirs; tind++) {
+        for (int aind = 0; written && aind < EnvNAVXYTHETALATCfg.actionwidth; aind++) {
+            const EnvNAVXYTHETALATAction_t* action = &EnvNAVXYTHETALATCfg.ActionsV[tind][aind];
+            written = WriteVector(f, action->interm3DcellsV) && WriteVector(f, action->intersectingcellsV);
+        }
+    }
+    written = written && WriteVector(f, affectedsuccstatesV) && WriteVector(f, affectedpredstatesV);
+    written = (fclose(f) == 0) && written;
+
+    if (!written || rename(tmpfilename.str().c_str(), filename.c_str()) != 0) {
+        remove(tmpfilename.str().c_str());
+        return false;
+    }
+    return true;
+}
+
 void EnvironmentNAVXYTHETALATTICE::InitializeEnvConfig(
     std::vector<SBPL_xytheta_mprimitive>* motionprimitiveV,
     bool computeKernels)
@@ -1276,13 +2009,44 @@ void EnvironmentNAVXYTHETALATTICE::InitializeEnvConfig(
     else {
         PrecomputeActionswithCompleteMotionPrimitive(motionprimitiveV, computeKernels);
     }
+
+    PrecomputeFootprintCells();
+}
+
+// rasterizes the footprint at every discrete theta around the origin, the
+// same way the motion primitive kernels are computed
+void EnvironmentNAVXYTHETALATTICE::PrecomputeFootprintCells()
+{
+    EnvNAVXYTHETALATCfg.FootprintCellsV.clear();
+    EnvNAVXYTHETALATCfg.FootprintCellsV.resize(EnvNAVXYTHETALATCfg.NumThetaDirs);
+
+    for (int tind = 0; tind < EnvNAVXYTHETALATCfg.NumThetaDirs; tind++) {
+        EnvNAVXYTHETALATFootprint_t* footprint = &EnvNAVXYTHETALATCfg.FootprintCellsV[tind];
+
+        sbpl_xy_theta_pt_t pose(0.0, 0.0, DiscTheta2ContNew(tind));
+        get_2d_footprint_cells(
+                EnvNAVXYTHETALATCfg.FootprintPolygon,
+                &footprint->cells,
+                pose,
+                EnvNAVXYTHETALATCfg.cellsize_m);
+
+        footprint->minX = footprint->maxX = 0;
+        footprint->minY = footprint->maxY = 0;
+        for (size_t i = 0; i < footprint->cells.size(); i++) {
+            const sbpl_2Dcell_t& cell = footprint->cells[i];
+            if (i == 0 || cell.x < footprint->minX) footprint->minX = cell.x;
+            if (i == 0 || cell.x > footprint->maxX) footprint->maxX = cell.x;
+            if (i == 0 || cell.y < footprint->minY) footprint->minY = cell.y;
+            if (i == 0 || cell.y > footprint->maxY) footprint->maxY = cell.y;
+        }
+    }
 }
 
 bool EnvironmentNAVXYTHETALATTICE::IsValidCell(int X, int Y)
 {
     return (X >= 0 && X < EnvNAVXYTHETALATCfg.EnvWidth_c &&
             Y >= 0 && Y < EnvNAVXYTHETALATCfg.EnvHeight_c &&
-            EnvNAVXYTHETALATCfg.Grid2D[X][Y] < EnvNAVXYTHETALATCfg.obsthresh);
+            EnvNAVXYTHETALATCfg.Grid2DCell(X, Y) < EnvNAVXYTHETALATCfg.obsthresh);
 }
 
 bool EnvironmentNAVXYTHETALATTICE::IsWithinMapCell(int X, int Y)
@@ -1293,6 +2057,30 @@ bool EnvironmentNAVXYTHETALATTICE::IsWithinMapCell(int X, int Y)
 
 bool EnvironmentNAVXYTHETALATTICE::IsValidConfiguration(int X, int Y, int Theta) const
 {
+    if (Theta >= 0 && Theta < (int)EnvNAVXYTHETALATCfg.FootprintCellsV.size()) {
+        const EnvNAVXYTHETALATFootprint_t& footprint = EnvNAVXYTHETALATCfg.FootprintCellsV[Theta];
+
+        // the bounding box is spanned by footprint cells, so if it is not
+        // inside the map then some cell is outside
+        if (X + footprint.minX < 0 || X + footprint.maxX >= EnvNAVXYTHETALATCfg.EnvWidth_c ||
+            Y + footprint.minY < 0 || Y + footprint.maxY >= EnvNAVXYTHETALATCfg.EnvHeight_c)
+        {
+            return false;
+        }
+
+        const int stride = EnvNAVXYTHETALATCfg.Grid2DStride;
+        const unsigned char* center = EnvNAVXYTHETALATCfg.Grid2D + Y * stride + X;
+        const sbpl_2Dcell_t* cells = footprint.cells.data();
+        const int numcells = (int)footprint.cells.size();
+        for (int find = 0; find < numcells; find++) {
+            if (center[cells[find].y * stride + cells[find].x] >= EnvNAVXYTHETALATCfg.obsthresh) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the footprint cells are not precomputed yet
     std::vector<sbpl_2Dcell_t> footprint;
     sbpl_xy_theta_pt_t pose;
 
@@ -1315,7 +2103,7 @@ bool EnvironmentNAVXYTHETALATTICE::IsValidConfiguration(int X, int Y, int Theta)
 
         if (x < 0 || x >= EnvNAVXYTHETALATCfg.EnvWidth_c ||
             y < 0 || y >= EnvNAVXYTHETALATCfg.EnvHeight_c ||
-            EnvNAVXYTHETALATCfg.Grid2D[x][y] >= EnvNAVXYTHETALATCfg.obsthresh)
+            EnvNAVXYTHETALATCfg.Grid2DCell(x, y) >= EnvNAVXYTHETALATCfg.obsthresh)
         {
             return false;
         }
@@ -1324,6 +2112,16 @@ bool EnvironmentNAVXYTHETALATTICE::IsValidConfiguration(int X, int Y, int Theta)
     return true;
 }
 
+void EnvironmentNAVXYTHETALATTICE::IsValidConfigurations(
+    const std::vector<sbpl_xy_theta_cell_t>& configurations,
+    std::vector<bool>* valid) const
+{
+    valid->resize(configurations.size());
+    for (size_t i = 0; i < configurations.size(); i++) {
+        (*valid)[i] = IsValidConfiguration(configurations[i].x, configurations[i].y, configurations[i].theta);
+    }
+}
+
 int EnvironmentNAVXYTHETALATTICE::GetActionCost(
     int SourceX, int SourceY, int SourceTheta,
     EnvNAVXYTHETALATAction_t* action)
@@ -1332,10 +2130,6 @@ int EnvironmentNAVXYTHETALATTICE::GetActionCost(
     sbpl_xy_theta_cell_t interm3Dcell;
     int i;
 
-    // TODO - go over bounding box (minpt and maxpt) to test validity and skip
-    // testing boundaries below, also order intersect cells so that the four
-    // farthest pts go first
-
     if (!IsValidCell(SourceX, SourceY)) {
         return INFINITECOST;
     }
@@ -1343,30 +2137,82 @@ int EnvironmentNAVXYTHETALATTICE::GetActionCost(
         return INFINITECOST;
     }
 
-    if (EnvNAVXYTHETALATCfg.Grid2D[SourceX + action->dX][SourceY + action->dY] >=
+    if (EnvNAVXYTHETALATCfg.Grid2DCell(SourceX + action->dX, SourceY + action->dY) >=
         EnvNAVXYTHETALATCfg.cost_inscribed_thresh)
     {
         return INFINITECOST;
     }
 
-    // need to iterate over discretized center cells and compute cost based on them
+    // if the bounding box of the action is inside the map, none of its cells
+    // need to be bounds checked
+    const bool inside =
+            SourceX + action->minX >= 0 &&
+            SourceX + action->maxX < EnvNAVXYTHETALATCfg.EnvWidth_c &&
+            SourceY + action->minY >= 0 &&
+            SourceY + action->maxY < EnvNAVXYTHETALATCfg.EnvHeight_c;
+
+    // the precomputed cell offsets of the action hold for a costmap whose
+    // stride is its width. The gathers of MaxCellCostAVX2 read 3 bytes past
+    // a cell, which stay inside the costmap unless the action reaches its
+    // last row.
+    const int stride = EnvNAVXYTHETALATCfg.Grid2DStride;
+    const bool useoffsets = inside && stride == EnvNAVXYTHETALATCfg.EnvWidth_c;
+    const bool usesimd = useoffsets && bActionCostSIMD && EnvNAVXYTHETALATCfg.EnvWidth_c >= 4 &&
+            SourceY + action->maxY < EnvNAVXYTHETALATCfg.EnvHeight_c - 1;
+
+    // need to iterate over discretized center cells and compute cost based on
+    // them. The cells are visited from the end of the primitive since that is
+    // where collisions are usually found.
     unsigned char maxcellcost = 0;
-    for (i = 0; i < (int)action->interm3DcellsV.size(); i++) {
-        interm3Dcell = action->interm3DcellsV.at(i);
-        interm3Dcell.x = interm3Dcell.x + SourceX;
-        interm3Dcell.y = interm3Dcell.y + SourceY;
+    const int numintermcells = (int)action->interm3DcellsV.size();
+    const unsigned char* sourcecell = EnvNAVXYTHETALATCfg.Grid2D + SourceY * stride + SourceX;
+    if (useoffsets) {
+        const int* offsets = action->interm2DoffsetsV.data();
+        const unsigned char thresh = EnvNAVXYTHETALATCfg.cost_inscribed_thresh;
+        maxcellcost = usesimd ?
+                MaxCellCostAVX2(sourcecell, offsets, numintermcells, thresh) :
+                MaxCellCost(sourcecell, offsets, numintermcells, thresh);
 
-        if (interm3Dcell.x < 0 || interm3Dcell.x >= EnvNAVXYTHETALATCfg.EnvWidth_c ||
-            interm3Dcell.y < 0 || interm3Dcell.y >= EnvNAVXYTHETALATCfg.EnvHeight_c)
-        {
+        // check that the robot is NOT in the cell at which there is no valid orientation
+        if (maxcellcost >= thresh) {
             return INFINITECOST;
         }
+    }
+    else if (inside) {
+        const sbpl_xy_theta_cell_t* intermcells = action->interm3DcellsV.data();
+        i = numintermcells;
+        while (i > 0) {
+            // branch-free max over a block of cells, then a single threshold test
+            const int blockend = __max(i - NAVXYTHETALAT_COLLISIONCHECK_BLOCKSIZE, 0);
+            for (; i > blockend; i--) {
+                unsigned char cost = sourcecell[intermcells[i - 1].y * stride + intermcells[i - 1].x];
+                maxcellcost = cost > maxcellcost ? cost : maxcellcost;
+            }
 
-        maxcellcost = __max(maxcellcost, EnvNAVXYTHETALATCfg.Grid2D[interm3Dcell.x][interm3Dcell.y]);
+            // check that the robot is NOT in the cell at which there is no valid orientation
+            if (maxcellcost >= EnvNAVXYTHETALATCfg.cost_inscribed_thresh) {
+                return INFINITECOST;
+            }
+        }
+    }
+    else {
+        for (i = numintermcells - 1; i >= 0; i--) {
+            interm3Dcell = action->interm3DcellsV[i];
+            interm3Dcell.x = interm3Dcell.x + SourceX;
+            interm3Dcell.y = interm3Dcell.y + SourceY;
+
+            if (interm3Dcell.x < 0 || interm3Dcell.x >= EnvNAVXYTHETALATCfg.EnvWidth_c ||
+                interm3Dcell.y < 0 || interm3Dcell.y >= EnvNAVXYTHETALATCfg.EnvHeight_c)
+            {
+                return INFINITECOST;
+            }
 
-        // check that the robot is NOT in the cell at which there is no valid orientation
-        if (maxcellcost >= EnvNAVXYTHETALATCfg.cost_inscribed_thresh) {
-            return INFINITECOST;
+            maxcellcost = __max(maxcellcost, EnvNAVXYTHETALATCfg.Grid2DCell(interm3Dcell.x, interm3Dcell.y));
+
+            // check that the robot is NOT in the cell at which there is no valid orientation
+            if (maxcellcost >= EnvNAVXYTHETALATCfg.cost_inscribed_thresh) {
+                return INFINITECOST;
+            }
         }
     }
 
@@ -1374,31 +2220,89 @@ int EnvironmentNAVXYTHETALATTICE::GetActionCost(
     if (EnvNAVXYTHETALATCfg.FootprintPolygon.size() > 1 &&
         (int)maxcellcost >= EnvNAVXYTHETALATCfg.cost_possibly_circumscribed_thresh)
     {
-        checks++;
-
-        for (i = 0; i < (int)action->intersectingcellsV.size(); i++) {
-            // get the cell in the map
-            cell = action->intersectingcellsV.at(i);
-            cell.x = cell.x + SourceX;
-            cell.y = cell.y + SourceY;
+        checks.fetch_add(1, std::memory_order_relaxed); // a statistic, the order does not matter
 
-            // check validity
-            if (!IsValidCell(cell.x, cell.y)) {
+        const int numcells = (int)action->intersectingcellsV.size();
+        if (inside && bFootprintBitmask && ObstacleMask != NULL) {
+            if (FootprintIntersectsMask(ObstacleMask, ObstacleMaskStride, SourceX, SourceY, action)) {
                 return INFINITECOST;
             }
         }
+        else if (useoffsets) {
+            const int* offsets = action->intersectingoffsetsV.data();
+            const unsigned char thresh = EnvNAVXYTHETALATCfg.obsthresh;
+            const unsigned char maxfootprintcost = usesimd ?
+                    MaxCellCostAVX2(sourcecell, offsets, numcells, thresh) :
+                    MaxCellCost(sourcecell, offsets, numcells, thresh);
+            if (maxfootprintcost >= thresh) {
+                return INFINITECOST;
+            }
+        }
+        else if (inside) {
+            const sbpl_2Dcell_t* cells = action->intersectingcellsV.data();
+            i = 0;
+            while (i < numcells) {
+                const int blockend = __min(i + NAVXYTHETALAT_COLLISIONCHECK_BLOCKSIZE, numcells);
+                unsigned char maxfootprintcost = 0;
+                for (; i < blockend; i++) {
+                    unsigned char cost = sourcecell[cells[i].y * stride + cells[i].x];
+                    maxfootprintcost = cost > maxfootprintcost ? cost : maxfootprintcost;
+                }
+                if (maxfootprintcost >= EnvNAVXYTHETALATCfg.obsthresh) {
+                    return INFINITECOST;
+                }
+            }
+        }
+        else {
+            for (i = 0; i < numcells; i++) {
+                // get the cell in the map
+                cell = action->intersectingcellsV[i];
+                cell.x = cell.x + SourceX;
+                cell.y = cell.y + SourceY;
+
+                // check validity
+                if (!IsValidCell(cell.x, cell.y)) {
+                    return INFINITECOST;
+                }
+            }
+        }
     }
 
     // to ensure consistency of h2D:
-    maxcellcost = __max(maxcellcost, EnvNAVXYTHETALATCfg.Grid2D[SourceX][SourceY]);
+    maxcellcost = __max(maxcellcost, EnvNAVXYTHETALATCfg.Grid2DCell(SourceX, SourceY));
     int currentmaxcost = (int)__max(
             maxcellcost,
-            EnvNAVXYTHETALATCfg.Grid2D[SourceX + action->dX][SourceY + action->dY]);
+            EnvNAVXYTHETALATCfg.Grid2DCell(SourceX + action->dX, SourceY + action->dY));
 
     // use cell cost as multiplicative factor
     return action->cost * (currentmaxcost + 1);
 }
 
+void EnvironmentNAVXYTHETALATTICE::GetActionCosts(
+    std::vector<EnvNAVXYTHETALATActionCostQuery_t>* queries)
+{
+    const int numofqueries = (int)queries->size();
+    EnvNAVXYTHETALATActionCostQuery_t* q = queries->data();
+
+    if (!ActionCostWorkers || numofqueries < ActionCostMinBatch) {
+        for (int i = 0; i < numofqueries; i++) {
+            q[i].cost = GetActionCost(q[i].SourceX, q[i].SourceY, q[i].SourceTheta, q[i].action);
+        }
+        return;
+    }
+
+    // the costs are independent reads of the costmap, each thread takes a
+    // few of them at a time so that the handout does not dominate
+    const int chunksize = 4;
+    const int numofchunks = (numofqueries + chunksize - 1) / chunksize;
+    ActionCostWorkers->run(numofchunks, [this, q, numofqueries](int chunk) {
+        const int end = __min((chunk + 1) * chunksize, numofqueries);
+        for (int i = chunk * chunksize; i < end; i++) {
+            q[i].cost = GetActionCost(q[i].SourceX, q[i].SourceY, q[i].SourceTheta, q[i].action);
+        }
+    });
+}
+
 double EnvironmentNAVXYTHETALATTICE::EuclideanDistance_m(int X1, int Y1, int X2, int Y2)
 {
     int sqdist = ((X1 - X2) * (X1 - X2) + (Y1 - Y2) * (Y1 - Y2));
@@ -1550,26 +2454,68 @@ void EnvironmentNAVXYTHETALATTICE::RemoveSourceFootprint(
 
 void EnvironmentNAVXYTHETALATTICE::EnsureHeuristicsUpdated(bool bGoalHeuristics)
 {
+    // the lazy searches are continued by GetGoalHeuristic and GetStartHeuristic
+    SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition = bLazyHeuristics ?
+            SBPL_2DGRIDSEARCH_TERM_CONDITION_GOALSETTLED : SBPL_2DGRIDSEARCH_TERM_CONDITION_TWOTIMESOPTPATH;
+
     if (bNeedtoRecomputeStartHeuristics && !bGoalHeuristics) {
         grid2Dsearchfromstart->search(
                 EnvNAVXYTHETALATCfg.Grid2D,
+                EnvNAVXYTHETALATCfg.Grid2DStride,
                 EnvNAVXYTHETALATCfg.cost_inscribed_thresh,
                 EnvNAVXYTHETALATCfg.StartX_c, EnvNAVXYTHETALATCfg.StartY_c,
                 EnvNAVXYTHETALATCfg.EndX_c, EnvNAVXYTHETALATCfg.EndY_c,
-                SBPL_2DGRIDSEARCH_TERM_CONDITION_TWOTIMESOPTPATH);
+                termination_condition);
         bNeedtoRecomputeStartHeuristics = false;
+        StartHeuristicsChangesV.clear();
         SBPL_PRINTF("2dsolcost_infullunits=%d\n", (int)(grid2Dsearchfromstart->getlowerboundoncostfromstart_inmm(EnvNAVXYTHETALATCfg.EndX_c, EnvNAVXYTHETALATCfg.EndY_c) / EnvNAVXYTHETALATCfg.nominalvel_mpersecs));
     }
+    else if (!StartHeuristicsChangesV.empty() && !bGoalHeuristics) {
+        grid2Dsearchfromstart->repair(
+                EnvNAVXYTHETALATCfg.Grid2D,
+                EnvNAVXYTHETALATCfg.Grid2DStride,
+                EnvNAVXYTHETALATCfg.cost_inscribed_thresh,
+                EnvNAVXYTHETALATCfg.StartX_c, EnvNAVXYTHETALATCfg.StartY_c,
+                EnvNAVXYTHETALATCfg.EndX_c, EnvNAVXYTHETALATCfg.EndY_c,
+                termination_condition,
+                StartHeuristicsChangesV);
+        StartHeuristicsChangesV.clear();
+    }
 
     if (bNeedtoRecomputeGoalHeuristics && bGoalHeuristics) {
-        grid2Dsearchfromgoal->search(
+        if (HeuristicCache) {
+            grid2Dsearchfromgoal->searchcached(
+                    HeuristicCache.get(),
+                    EnvNAVXYTHETALATCfg.Grid2DVersion,
+                    EnvNAVXYTHETALATCfg.Grid2D,
+                    EnvNAVXYTHETALATCfg.Grid2DStride,
+                    EnvNAVXYTHETALATCfg.cost_inscribed_thresh,
+                    EnvNAVXYTHETALATCfg.EndX_c, EnvNAVXYTHETALATCfg.EndY_c,
+                    EnvNAVXYTHETALATCfg.StartX_c, EnvNAVXYTHETALATCfg.StartY_c);
+        }
+        else {
+            grid2Dsearchfromgoal->search(
+                    EnvNAVXYTHETALATCfg.Grid2D,
+                    EnvNAVXYTHETALATCfg.Grid2DStride,
+                    EnvNAVXYTHETALATCfg.cost_inscribed_thresh,
+                    EnvNAVXYTHETALATCfg.EndX_c, EnvNAVXYTHETALATCfg.EndY_c,
+                    EnvNAVXYTHETALATCfg.StartX_c, EnvNAVXYTHETALATCfg.StartY_c,
+                    termination_condition);
+        }
+        bNeedtoRecomputeGoalHeuristics = false;
+        GoalHeuristicsChangesV.clear();
+        SBPL_PRINTF("2dsolcost_infullunits=%d\n", (int)(grid2Dsearchfromgoal->getlowerboundoncostfromstart_inmm(EnvNAVXYTHETALATCfg.StartX_c, EnvNAVXYTHETALATCfg.StartY_c) / EnvNAVXYTHETALATCfg.nominalvel_mpersecs));
+    }
+    else if (!GoalHeuristicsChangesV.empty() && bGoalHeuristics) {
+        grid2Dsearchfromgoal->repair(
                 EnvNAVXYTHETALATCfg.Grid2D,
+                EnvNAVXYTHETALATCfg.Grid2DStride,
                 EnvNAVXYTHETALATCfg.cost_inscribed_thresh,
                 EnvNAVXYTHETALATCfg.EndX_c, EnvNAVXYTHETALATCfg.EndY_c,
                 EnvNAVXYTHETALATCfg.StartX_c, EnvNAVXYTHETALATCfg.StartY_c,
-                SBPL_2DGRIDSEARCH_TERM_CONDITION_TWOTIMESOPTPATH);
-        bNeedtoRecomputeGoalHeuristics = false;
-        SBPL_PRINTF("2dsolcost_infullunits=%d\n", (int)(grid2Dsearchfromgoal->getlowerboundoncostfromstart_inmm(EnvNAVXYTHETALATCfg.StartX_c, EnvNAVXYTHETALATCfg.StartY_c) / EnvNAVXYTHETALATCfg.nominalvel_mpersecs));
+                termination_condition,
+                GoalHeuristicsChangesV);
+        GoalHeuristicsChangesV.clear();
     }
 }
 
@@ -1586,9 +2532,14 @@ void EnvironmentNAVXYTHETALATTICE::ComputeHeuristicValues()
             EnvNAVXYTHETALATCfg.EnvWidth_c, EnvNAVXYTHETALATCfg.EnvHeight_c,
             (float)EnvNAVXYTHETALATCfg.cellsize_m, blocksize, bucketsize);
 
-    // set OPEN type to sliding buckets
-    grid2Dsearchfromstart->setOPENdatastructure(SBPL_2DGRIDSEARCH_OPENTYPE_SLIDINGBUCKETS);
-    grid2Dsearchfromgoal->setOPENdatastructure(SBPL_2DGRIDSEARCH_OPENTYPE_SLIDINGBUCKETS);
+    // set OPEN type to sliding buckets, or to buckets expanded in parallel
+    // if the searches have more than one thread
+    SBPL_2DGRIDSEARCH_OPENTYPE OPENtype = (HeuristicThreads > 1) ?
+            SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS : SBPL_2DGRIDSEARCH_OPENTYPE_SLIDINGBUCKETS;
+    grid2Dsearchfromstart->setOPENdatastructure(OPENtype);
+    grid2Dsearchfromgoal->setOPENdatastructure(OPENtype);
+    grid2Dsearchfromstart->setnumthreads(HeuristicThreads);
+    grid2Dsearchfromgoal->setnumthreads(HeuristicThreads);
 
     SBPL_PRINTF("done\n");
 }
@@ -1636,7 +2587,7 @@ bool EnvironmentNAVXYTHETALATTICE::InitializeEnv(
     fclose(fCfg);
 
     if (sMotPrimFile != NULL) {
-        FILE* fMotPrim = fopen(sMotPrimFile, "r");
+        FILE* fMotPrim = fopen(sMotPrimFile, "rb");
         if (fMotPrim == NULL) {
             std::stringstream ss;
             ss << "ERROR: unable to open " << sMotPrimFile;
@@ -1760,7 +2711,7 @@ bool EnvironmentNAVXYTHETALATTICE::InitializeEnv(
     // TODO - need to set the tolerance as well
 
     if (sMotPrimFile != NULL) {
-        FILE* fMotPrim = fopen(sMotPrimFile, "r");
+        FILE* fMotPrim = fopen(sMotPrimFile, "rb");
         if (fMotPrim == NULL) {
             std::stringstream ss;
             ss << "ERROR: unable to open " << sMotPrimFile;
@@ -1811,6 +2762,8 @@ bool EnvironmentNAVXYTHETALATTICE::InitGeneral(
     // Initialize other parameters of the environment
     InitializeEnvConfig(motionprimitiveV, computeKernels);
 
+    ComputeObstacleMask();
+
     // initialize Environment
     InitializeEnvironment();
 
@@ -1879,80 +2832,326 @@ void EnvironmentNAVXYTHETALATTICE::GetSuccs(
 {
     GetSuccs(SourceStateID, SuccIDV, CostV, NULL);
 }
-void EnvironmentNAVXYTHETALATTICE::GetLazySuccs(
-    int SourceStateID,
-    std::vector<int>* SuccIDV,
-    std::vector<int>* CostV,
-    std::vector<bool>* isTrueCost)
+void EnvironmentNAVXYTHETALATTICE::GetLazySuccs(
+    int SourceStateID,
+    std::vector<int>* SuccIDV,
+    std::vector<int>* CostV,
+    std::vector<bool>* isTrueCost)
+{
+    GetLazySuccs(SourceStateID, SuccIDV, CostV, isTrueCost, NULL);
+}
+
+void EnvironmentNAVXYTHETALATTICE::GetSuccsWithUniqueIds(
+    int SourceStateID,
+    std::vector<int>* SuccIDV,
+    std::vector<int>* CostV)
+{
+    GetSuccsWithUniqueIds(SourceStateID, SuccIDV, CostV, NULL);
+}
+
+void EnvironmentNAVXYTHETALATTICE::GetLazySuccsWithUniqueIds(
+    int SourceStateID,
+    std::vector<int>* SuccIDV,
+    std::vector<int>* CostV,
+    std::vector<bool>* isTrueCost)
+{
+    GetLazySuccsWithUniqueIds(SourceStateID, SuccIDV, CostV, isTrueCost, NULL);
+}
+
+const EnvNAVXYTHETALATConfig_t* EnvironmentNAVXYTHETALATTICE::GetEnvNavConfig() const
+{
+    return &EnvNAVXYTHETALATCfg;
+}
+
+bool EnvironmentNAVXYTHETALATTICE::UpdateCost(
+    int x,
+    int y,
+    unsigned char newcost)
+{
+    DetachLatticeModel();
+
+    unsigned char oldcost = EnvNAVXYTHETALATCfg.Grid2DCell(x, y);
+    EnvNAVXYTHETALATCfg.Grid2DCell(x, y) = newcost;
+    if (ObstacleMask != NULL) {
+        unsigned long long& word = ObstacleMaskV[(size_t)y * ObstacleMaskStride + x / 64];
+        if (newcost >= EnvNAVXYTHETALATCfg.obsthresh) {
+            word |= 1ULL << (x % 64);
+        }
+        else {
+            word &= ~(1ULL << (x % 64));
+        }
+    }
+
+    if (newcost != oldcost) {
+        EnvNAVXYTHETALATCfg.Grid2DVersion = SBPL2DGridSearchCache::newmapversion();
+        AddHeuristicsChange(x, y);
+    }
+    else if (!bIncrementalHeuristics) {
+        bNeedtoRecomputeStartHeuristics = true;
+        bNeedtoRecomputeGoalHeuristics = true;
+    }
+
+    return true;
+}
+
+void EnvironmentNAVXYTHETALATTICE::HashGrid2D()
+{
+    EnvNAVXYTHETALATCfg.Grid2DVersion = SBPL2DGridSearchCache::computemapversion(
+            EnvNAVXYTHETALATCfg.Grid2D, EnvNAVXYTHETALATCfg.EnvWidth_c, EnvNAVXYTHETALATCfg.EnvHeight_c,
+            EnvNAVXYTHETALATCfg.Grid2DStride);
+}
+
+void EnvironmentNAVXYTHETALATTICE::AddHeuristicsChange(int x, int y)
+{
+    if (!bIncrementalHeuristics) {
+        bNeedtoRecomputeStartHeuristics = true;
+        bNeedtoRecomputeGoalHeuristics = true;
+        return;
+    }
+
+    // the 2D searches that are up to date get repaired around the cell,
+    // unless so much has changed that running them again is cheaper
+    size_t maxchanges = (size_t)EnvNAVXYTHETALATCfg.EnvWidth_c * EnvNAVXYTHETALATCfg.EnvHeight_c /
+            NAVXYTHETALAT_HEURISTICREPAIR_MAXFRACTION;
+    if (!bNeedtoRecomputeStartHeuristics) {
+        StartHeuristicsChangesV.push_back(sbpl_2Dcell_t(x, y));
+        bNeedtoRecomputeStartHeuristics = StartHeuristicsChangesV.size() > maxchanges;
+    }
+    if (!bNeedtoRecomputeGoalHeuristics) {
+        GoalHeuristicsChangesV.push_back(sbpl_2Dcell_t(x, y));
+        bNeedtoRecomputeGoalHeuristics = GoalHeuristicsChangesV.size() > maxchanges;
+    }
+}
+
+bool EnvironmentNAVXYTHETALATTICE::SetMap(const unsigned char* mapdata)
+{
+    // any cell may have changed
+    if (!SetMap(mapdata, std::vector<sbpl_2Dcell_t>())) {
+        return false;
+    }
+    bNeedtoRecomputeStartHeuristics = true;
+    bNeedtoRecomputeGoalHeuristics = true;
+
+    return true;
+}
+
+bool EnvironmentNAVXYTHETALATTICE::SetMap(
+    const unsigned char* mapdata,
+    const std::vector<sbpl_2Dcell_t>& changedcells)
+{
+    DetachLatticeModel();
+
+    // take the costmap back from the caller (see SetMapBuffer)
+    if (bExternalGrid2D) {
+        EnvNAVXYTHETALATCfg.Grid2DStride = EnvNAVXYTHETALATCfg.EnvWidth_c;
+        EnvNAVXYTHETALATCfg.Grid2D = AllocateGrid2D(
+                (size_t)EnvNAVXYTHETALATCfg.Grid2DStride * EnvNAVXYTHETALATCfg.EnvHeight_c);
+        bExternalGrid2D = false;
+    }
+
+    // mapdata has the same row-major layout as the internal costmap
+    if (EnvNAVXYTHETALATCfg.Grid2DStride == EnvNAVXYTHETALATCfg.EnvWidth_c) {
+        memcpy(EnvNAVXYTHETALATCfg.Grid2D, mapdata,
+               (size_t)EnvNAVXYTHETALATCfg.EnvWidth_c * EnvNAVXYTHETALATCfg.EnvHeight_c);
+    }
+    else {
+        for (int y = 0; y < EnvNAVXYTHETALATCfg.EnvHeight_c; y++) {
+            memcpy(&EnvNAVXYTHETALATCfg.Grid2DCell(0, y), mapdata + y * EnvNAVXYTHETALATCfg.EnvWidth_c,
+                   EnvNAVXYTHETALATCfg.EnvWidth_c);
+        }
+    }
+
+    if (ObstacleMask != NULL) {
+        ComputeObstacleMask();
+    }
+
+    HashGrid2D();
+    for (size_t i = 0; i < changedcells.size(); i++) {
+        AddHeuristicsChange(changedcells[i].x, changedcells[i].y);
+    }
+
+    return true;
+}
+
+bool EnvironmentNAVXYTHETALATTICE::SetMapBuffer(unsigned char* mapdata, int stride)
+{
+    // any cell may have changed
+    if (!SetMapBuffer(mapdata, stride, std::vector<sbpl_2Dcell_t>())) {
+        return false;
+    }
+    bNeedtoRecomputeStartHeuristics = true;
+    bNeedtoRecomputeGoalHeuristics = true;
+
+    return true;
+}
+
+bool EnvironmentNAVXYTHETALATTICE::SetMapBuffer(
+    unsigned char* mapdata,
+    int stride,
+    const std::vector<sbpl_2Dcell_t>& changedcells)
+{
+    if (mapdata == NULL || stride < EnvNAVXYTHETALATCfg.EnvWidth_c) {
+        SBPL_ERROR("ERROR: invalid costmap buffer (stride %d for width %d)\n",
+                   stride, EnvNAVXYTHETALATCfg.EnvWidth_c);
+        return false;
+    }
+
+    DetachLatticeModel();
+
+    if (EnvNAVXYTHETALATCfg.Grid2D != NULL && !bExternalGrid2D) {
+        FreeGrid2D(EnvNAVXYTHETALATCfg.Grid2D);
+    }
+    EnvNAVXYTHETALATCfg.Grid2D = mapdata;
+    EnvNAVXYTHETALATCfg.Grid2DStride = stride;
+    bExternalGrid2D = true;
+
+    if (ObstacleMask != NULL) {
+        ComputeObstacleMask();
+    }
+
+    HashGrid2D();
+    for (size_t i = 0; i < changedcells.size(); i++) {
+        AddHeuristicsChange(changedcells[i].x, changedcells[i].y);
+    }
+
+    return true;
+}
+
+void EnvironmentNAVXYTHETALATTICE::DetachLatticeModel()
+{
+    std::lock_guard<std::mutex> lock(LatticeModelMutex);
+    if (!LatticeModel) {
+        return;
+    }
+
+    // the costmap of the model is read-only, the environment gets a copy of
+    // its own that it can change
+    if (EnvNAVXYTHETALATCfg.Grid2D == LatticeModel->cfg.Grid2D) {
+        const unsigned char* modelgrid = LatticeModel->cfg.Grid2D;
+        const int modelstride = LatticeModel->cfg.Grid2DStride;
+        EnvNAVXYTHETALATCfg.Grid2D = AllocateGrid2D((size_t)modelstride * EnvNAVXYTHETALATCfg.EnvHeight_c);
+        memcpy(EnvNAVXYTHETALATCfg.Grid2D, modelgrid, (size_t)modelstride * EnvNAVXYTHETALATCfg.EnvHeight_c);
+        EnvNAVXYTHETALATCfg.Grid2DStride = modelstride;
+        bExternalGrid2D = false;
+    }
+    if (ObstacleMask != NULL && ObstacleMask == LatticeModel->obstaclemaskV.data()) {
+        ObstacleMaskV = LatticeModel->obstaclemaskV;
+        ObstacleMask = ObstacleMaskV.data();
+    }
+
+    LatticeModel.reset();
+}
+
+void EnvironmentNAVXYTHETALATTICE::ComputeObstacleMask()
 {
-    GetLazySuccs(SourceStateID, SuccIDV, CostV, isTrueCost, NULL);
+    const int width = EnvNAVXYTHETALATCfg.EnvWidth_c;
+    const int height = EnvNAVXYTHETALATCfg.EnvHeight_c;
+    ObstacleMaskStride = (width + 63) / 64 + 1;
+    ObstacleMaskV.assign((size_t)ObstacleMaskStride * height, 0);
+    for (int y = 0; y < height; y++) {
+        const unsigned char* costrow = &EnvNAVXYTHETALATCfg.Grid2DCell(0, y);
+        unsigned long long* maskrow = &ObstacleMaskV[(size_t)y * ObstacleMaskStride];
+        for (int x = 0; x < width; x++) {
+            if (costrow[x] >= EnvNAVXYTHETALATCfg.obsthresh) {
+                maskrow[x / 64] |= 1ULL << (x % 64);
+            }
+        }
+    }
+    ObstacleMask = ObstacleMaskV.data();
 }
 
-void EnvironmentNAVXYTHETALATTICE::GetSuccsWithUniqueIds(
-    int SourceStateID,
-    std::vector<int>* SuccIDV,
-    std::vector<int>* CostV)
+void EnvironmentNAVXYTHETALATTICE::PrintEnv_Config(FILE* fOut)
 {
-    GetSuccsWithUniqueIds(SourceStateID, SuccIDV, CostV, NULL);
+    // implement this if the planner needs to print out EnvNAVXYTHETALAT. configuration
+    throw SBPL_Exception("ERROR in EnvNAVXYTHETALAT... function: PrintEnv_Config is undefined");
 }
 
-void EnvironmentNAVXYTHETALATTICE::GetLazySuccsWithUniqueIds(
-    int SourceStateID,
-    std::vector<int>* SuccIDV,
-    std::vector<int>* CostV,
-    std::vector<bool>* isTrueCost)
+void EnvironmentNAVXYTHETALATTICE::Set2DBlockSize(int BlockSize)
 {
-    GetLazySuccsWithUniqueIds(SourceStateID, SuccIDV, CostV, isTrueCost, NULL);
+    blocksize = BlockSize;
 }
 
-const EnvNAVXYTHETALATConfig_t* EnvironmentNAVXYTHETALATTICE::GetEnvNavConfig() const
+void EnvironmentNAVXYTHETALATTICE::Set2DBucketSize(int BucketSize)
 {
-    return &EnvNAVXYTHETALATCfg;
+    bucketsize = BucketSize;
 }
 
-bool EnvironmentNAVXYTHETALATTICE::UpdateCost(
-    int x,
-    int y,
-    unsigned char newcost)
+void EnvironmentNAVXYTHETALATTICE::SetActionCostThreads(int numthreads, int minactions)
 {
-    EnvNAVXYTHETALATCfg.Grid2D[x][y] = newcost;
+    if (numthreads < 1) {
+        throw SBPL_Exception("ERROR: the number of action cost threads has to be at least 1");
+    }
 
-    bNeedtoRecomputeStartHeuristics = true;
-    bNeedtoRecomputeGoalHeuristics = true;
+    ActionCostMinBatch = __max(minactions, 1);
+    if (numthreads != GetActionCostThreads()) {
+        ActionCostWorkers.reset();
+        if (numthreads > 1) {
+            ActionCostWorkers.reset(new SBPLWorkerPool(numthreads - 1));
+        }
+    }
+}
 
-    return true;
+int EnvironmentNAVXYTHETALATTICE::GetActionCostThreads() const
+{
+    return ActionCostWorkers ? ActionCostWorkers->getnumworkers() + 1 : 1;
 }
 
-bool EnvironmentNAVXYTHETALATTICE::SetMap(const unsigned char* mapdata)
+void EnvironmentNAVXYTHETALATTICE::SetHeuristicThreads(int numthreads)
 {
-    int xind = -1, yind = -1;
+    if (numthreads < 1) {
+        throw SBPL_Exception("ERROR: the number of heuristic threads has to be at least 1");
+    }
+    if (numthreads == HeuristicThreads) {
+        return;
+    }
+    HeuristicThreads = numthreads;
 
-    for (xind = 0; xind < EnvNAVXYTHETALATCfg.EnvWidth_c; xind++) {
-        for (yind = 0; yind < EnvNAVXYTHETALATCfg.EnvHeight_c; yind++) {
-            EnvNAVXYTHETALATCfg.Grid2D[xind][yind] = mapdata[xind + yind * EnvNAVXYTHETALATCfg.EnvWidth_c];
+    // the searches exist once the environment is initialized
+    SBPL_2DGRIDSEARCH_OPENTYPE OPENtype = (HeuristicThreads > 1) ?
+            SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS : SBPL_2DGRIDSEARCH_OPENTYPE_SLIDINGBUCKETS;
+    SBPL2DGridSearch* searches[] = { grid2Dsearchfromstart, grid2Dsearchfromgoal };
+    for (int i = 0; i < 2; i++) {
+        if (searches[i] != NULL) {
+            searches[i]->setOPENdatastructure(OPENtype);
+            searches[i]->setnumthreads(HeuristicThreads);
         }
     }
+}
 
-    bNeedtoRecomputeStartHeuristics = true;
-    bNeedtoRecomputeGoalHeuristics = true;
-
-    return true;
+int EnvironmentNAVXYTHETALATTICE::GetHeuristicThreads() const
+{
+    return HeuristicThreads;
 }
 
-void EnvironmentNAVXYTHETALATTICE::PrintEnv_Config(FILE* fOut)
+void EnvironmentNAVXYTHETALATTICE::SetHeuristicCache(std::shared_ptr<SBPL2DGridSearchCache> cache)
 {
-    // implement this if the planner needs to print out EnvNAVXYTHETALAT. configuration
-    throw SBPL_Exception("ERROR in EnvNAVXYTHETALAT... function: PrintEnv_Config is undefined");
+    HeuristicCache = cache;
 }
 
-void EnvironmentNAVXYTHETALATTICE::Set2DBlockSize(int BlockSize)
+std::shared_ptr<SBPL2DGridSearchCache> EnvironmentNAVXYTHETALATTICE::GetHeuristicCache() const
 {
-    blocksize = BlockSize;
+    return HeuristicCache;
 }
 
-void EnvironmentNAVXYTHETALATTICE::Set2DBucketSize(int BucketSize)
+bool EnvironmentNAVXYTHETALATTICE::PrecomputeGoalHeuristics(int x, int y)
 {
-    bucketsize = BucketSize;
+    if (!HeuristicCache || grid2Dsearchfromgoal == NULL || !IsWithinMapCell(x, y)) {
+        return false;
+    }
+
+    grid2Dsearchfromgoal->searchcached(
+            HeuristicCache.get(),
+            EnvNAVXYTHETALATCfg.Grid2DVersion,
+            EnvNAVXYTHETALATCfg.Grid2D,
+            EnvNAVXYTHETALATCfg.Grid2DStride,
+            EnvNAVXYTHETALATCfg.cost_inscribed_thresh,
+            x, y,
+            EnvNAVXYTHETALATCfg.StartX_c, EnvNAVXYTHETALATCfg.StartY_c);
+
+    // the search now holds the distances to <x,y>, the ones to the goal are
+    // taken from the cache again when they are needed
+    bNeedtoRecomputeGoalHeuristics = true;
+    return true;
 }
 
 void EnvironmentNAVXYTHETALATTICE::PrintTimeStat(FILE* fOut) const
@@ -1968,10 +3167,10 @@ void EnvironmentNAVXYTHETALATTICE::PrintTimeStat(FILE* fOut) const
 bool EnvironmentNAVXYTHETALATTICE::IsObstacle(int x, int y)
 {
 #if DEBUG
-    SBPL_FPRINTF(fDeb, "Status of cell %d %d is queried. Its cost=%d\n", x,y,EnvNAVXYTHETALATCfg.Grid2D[x][y]);
+    SBPL_FPRINTF(fDeb, "Status of cell %d %d is queried. Its cost=%d\n", x,y,EnvNAVXYTHETALATCfg.Grid2DCell(x, y));
 #endif
 
-    return EnvNAVXYTHETALATCfg.Grid2D[x][y] >= EnvNAVXYTHETALATCfg.obsthresh;
+    return EnvNAVXYTHETALATCfg.Grid2DCell(x, y) >= EnvNAVXYTHETALATCfg.obsthresh;
 }
 
 void EnvironmentNAVXYTHETALATTICE::GetEnvParms(
@@ -2051,7 +3250,7 @@ bool EnvironmentNAVXYTHETALATTICE::PoseDiscToCont(
 
 unsigned char EnvironmentNAVXYTHETALATTICE::GetMapCost(int x, int y) const
 {
-    return EnvNAVXYTHETALATCfg.Grid2D[x][y];
+    return EnvNAVXYTHETALATCfg.Grid2DCell(x, y);
 }
 
 bool EnvironmentNAVXYTHETALATTICE::SetEnvParameter(
@@ -2086,6 +3285,28 @@ bool EnvironmentNAVXYTHETALATTICE::SetEnvParameter(
         }
         EnvNAVXYTHETALATCfg.obsthresh = (unsigned char)value;
     }
+    else if (strcmp(parameter, "action_cost_simd") == 0) {
+        // 0 makes GetActionCost use the scalar reductions only, otherwise
+        // AVX2 is used if the CPU supports it (the default)
+        bActionCostSIMD = value != 0 && CPUSupportsAVX2();
+    }
+    else if (strcmp(parameter, "footprint_bitmask") == 0) {
+        // 0 makes GetActionCost check the footprint cells one by one instead
+        // of against the packed obstacle mask (the default)
+        bFootprintBitmask = value != 0;
+    }
+    else if (strcmp(parameter, "incremental_heuristics") == 0) {
+        // 0 makes UpdateCost have the 2D heuristic searches re-executed
+        // instead of repaired around the changed cells (the default)
+        bIncrementalHeuristics = value != 0;
+    }
+    else if (strcmp(parameter, "lazy_heuristics") == 0) {
+        // 1 makes the 2D heuristic searches compute the distances of the
+        // cells when the heuristics of their states are first needed, instead
+        // of up to twice the distance between the start and the goal up front
+        // (the default)
+        bLazyHeuristics = value != 0;
+    }
     else {
         SBPL_ERROR("ERROR: invalid parameter %s\n", parameter);
         return false;
@@ -2105,6 +3326,18 @@ int EnvironmentNAVXYTHETALATTICE::GetEnvParameter(const char* parameter) const
     else if (strcmp(parameter, "cost_obsthresh") == 0) {
         return (int)EnvNAVXYTHETALATCfg.obsthresh;
     }
+    else if (strcmp(parameter, "action_cost_simd") == 0) {
+        return bActionCostSIMD ? 1 : 0;
+    }
+    else if (strcmp(parameter, "footprint_bitmask") == 0) {
+        return bFootprintBitmask ? 1 : 0;
+    }
+    else if (strcmp(parameter, "incremental_heuristics") == 0) {
+        return bIncrementalHeuristics ? 1 : 0;
+    }
+    else if (strcmp(parameter, "lazy_heuristics") == 0) {
+        return bLazyHeuristics ? 1 : 0;
+    }
     else {
         std::stringstream ss;
         ss << "ERROR: invalid parameter " << parameter;
@@ -2117,23 +3350,105 @@ EnvironmentNAVXYTHETALAT::~EnvironmentNAVXYTHETALAT()
     SBPL_PRINTF("destroying XYTHETALAT\n");
 
     // delete the states themselves first
-    for (int i = 0; i < (int)StateID2CoordTable.size(); i++) {
-        delete StateID2CoordTable.at(i);
-        StateID2CoordTable.at(i) = NULL;
+    for (size_t i = 0; i < HashEntryChunks.size(); i++) {
+        delete[] HashEntryChunks[i];
+        delete[] StateID2IndexChunks[i];
     }
+    HashEntryChunks.clear();
+    StateID2IndexChunks.clear();
     StateID2CoordTable.clear();
+    // the rows were freed with their chunks
+    StateID2IndexMapping.clear();
 
     // delete hashtable
     if (Coord2StateIDHashTable != NULL) {
-        delete[] Coord2StateIDHashTable;
+        FreeHashTable(Coord2StateIDHashTable);
         Coord2StateIDHashTable = NULL;
     }
+    if (OldCoord2StateIDHashTable != NULL) {
+        FreeHashTable(OldCoord2StateIDHashTable);
+        OldCoord2StateIDHashTable = NULL;
+    }
     if (Coord2StateIDHashTable_lookup != NULL) {
+        for (int i = 0; i < LookupTilesX * LookupTilesY; i++) {
+            delete[] Coord2StateIDHashTable_lookup[i];
+        }
         delete[] Coord2StateIDHashTable_lookup;
         Coord2StateIDHashTable_lookup = NULL;
     }
 }
 
+std::shared_ptr<const EnvNAVXYTHETALATLatticeModel> EnvironmentNAVXYTHETALAT::GetLatticeModel() const
+{
+    if (!EnvNAVXYTHETALAT.bInitialized) {
+        throw SBPL_Exception("ERROR: the environment is not initialized");
+    }
+
+    std::lock_guard<std::mutex> lock(LatticeModelMutex);
+    if (LatticeModel) {
+        return LatticeModel;
+    }
+
+    std::shared_ptr<EnvNAVXYTHETALATLatticeModel> model(new EnvNAVXYTHETALATLatticeModel());
+
+    // the configuration holds pointers to the costmap and the actions, the
+    // costmap is copied (the environment may change its own later on) and
+    // the actions are shared
+    model->cfg = EnvNAVXYTHETALATCfg;
+    const size_t gridsize = (size_t)EnvNAVXYTHETALATCfg.Grid2DStride * EnvNAVXYTHETALATCfg.EnvHeight_c;
+    model->cfg.Grid2D = AllocateGrid2D(gridsize);
+    memcpy(model->cfg.Grid2D, EnvNAVXYTHETALATCfg.Grid2D, gridsize);
+    model->actiontable = ActionTable;
+    if (ObstacleMask != NULL) {
+        model->obstaclemaskV.assign(ObstacleMask, ObstacleMask + (size_t)ObstacleMaskStride * EnvNAVXYTHETALATCfg.EnvHeight_c);
+        model->obstaclemaskstride = ObstacleMaskStride;
+    }
+
+    model->affectedsuccstatesV = affectedsuccstatesV;
+    model->affectedpredstatesV = affectedpredstatesV;
+    model->blocksize = blocksize;
+    model->bucketsize = bucketsize;
+    model->bUseNonUniformAngles = bUseNonUniformAngles;
+
+    LatticeModel = model;
+    return LatticeModel;
+}
+
+bool EnvironmentNAVXYTHETALAT::InitializeEnvFromModel(
+    std::shared_ptr<const EnvNAVXYTHETALATLatticeModel> model)
+{
+    if (!model) {
+        SBPL_ERROR("ERROR: no lattice model given\n");
+        return false;
+    }
+    if (EnvNAVXYTHETALAT.bInitialized) {
+        SBPL_ERROR("ERROR: the environment is already initialized\n");
+        return false;
+    }
+
+    // the costmap and the actions of the model are shared, the rest of the
+    // configuration is copied
+    EnvNAVXYTHETALATCfg = model->cfg;
+    bExternalGrid2D = true;
+    ActionTable = model->actiontable;
+    LatticeModel = model;
+    if (!model->obstaclemaskV.empty()) {
+        ObstacleMask = model->obstaclemaskV.data();
+        ObstacleMaskStride = model->obstaclemaskstride;
+    }
+
+    affectedsuccstatesV = model->affectedsuccstatesV;
+    affectedpredstatesV = model->affectedpredstatesV;
+    blocksize = model->blocksize;
+    bucketsize = model->bucketsize;
+    bUseNonUniformAngles = model->bUseNonUniformAngles;
+
+    InitializeEnvironment();
+    ComputeHeuristicValues();
+
+    return true;
+}
+
 void EnvironmentNAVXYTHETALAT::GetCoordFromState(
     int stateID, int& x, int& y, int& theta) const
 {
@@ -2146,9 +3461,9 @@ void EnvironmentNAVXYTHETALAT::GetCoordFromState(
 int EnvironmentNAVXYTHETALAT::GetStateFromCoord(int x, int y, int theta)
 {
     EnvNAVXYTHETALATHashEntry_t* OutHashEntry;
-    if ((OutHashEntry = (this->*GetHashEntry)(x, y, theta)) == NULL) {
+    if ((OutHashEntry = GetHashEntry(x, y, theta)) == NULL) {
         // have to create a new entry
-        OutHashEntry = (this->*CreateNewHashEntry)(x, y, theta);
+        OutHashEntry = CreateNewHashEntry(x, y, theta);
     }
     return OutHashEntry->stateID;
 }
@@ -2163,7 +3478,7 @@ void EnvironmentNAVXYTHETALAT::GetActionsFromStateIDPath(
     int targetx_c, targety_c, targettheta_c;
     int sourcex_c, sourcey_c, sourcetheta_c;
 
-    SBPL_PRINTF("checks=%ld\n", checks);
+    SBPL_PRINTF("checks=%ld\n", checks.load());
 
     action_list->clear();
 
@@ -2215,7 +3530,7 @@ void EnvironmentNAVXYTHETALAT::ConvertStateIDPathintoXYThetaPath(
     int targetx_c, targety_c, targettheta_c;
     int sourcex_c, sourcey_c, sourcetheta_c;
 
-    SBPL_PRINTF("checks=%ld\n", checks);
+    SBPL_PRINTF("checks=%ld\n", checks.load());
 
     xythetaPath->clear();
 
@@ -2283,7 +3598,7 @@ void EnvironmentNAVXYTHETALAT::ConvertStateIDPathintoXYThetaPath(
             int ntheta;
             ntheta = ContTheta2DiscNew(intermpt.theta);
 
-            SBPL_FPRINTF(fDeb, "%.3f %.3f %.3f (%d %d %d cost=%d) ", intermpt.x, intermpt.y, intermpt.theta, nx, ny, ntheta,  EnvNAVXYTHETALATCfg.Grid2D[nx][ny]);
+            SBPL_FPRINTF(fDeb, "%.3f %.3f %.3f (%d %d %d cost=%d) ", intermpt.x, intermpt.y, intermpt.theta, nx, ny, ntheta,  EnvNAVXYTHETALATCfg.Grid2DCell(nx, ny));
 
             if (ipind == 0) {
                 SBPL_FPRINTF(fDeb, "first (heur=%d)\n", GetStartHeuristic(sourceID));
@@ -2318,9 +3633,9 @@ int EnvironmentNAVXYTHETALAT::SetGoal(double x_m, double y_m, double theta_rad,
     }
 
     EnvNAVXYTHETALATHashEntry_t* OutHashEntry;
-    if ((OutHashEntry = (this->*GetHashEntry)(x, y, theta)) == NULL) {
+    if ((OutHashEntry = GetHashEntry(x, y, theta)) == NULL) {
         // have to create a new entry
-        OutHashEntry = (this->*CreateNewHashEntry)(x, y, theta);
+        OutHashEntry = CreateNewHashEntry(x, y, theta);
     }
 
     // need to recompute start heuristics?
@@ -2361,9 +3676,9 @@ int EnvironmentNAVXYTHETALAT::SetStart(double x_m, double y_m, double theta_rad,
     }
 
     EnvNAVXYTHETALATHashEntry_t* OutHashEntry;
-    if ((OutHashEntry = (this->*GetHashEntry)(x, y, theta)) == NULL) {
+    if ((OutHashEntry = GetHashEntry(x, y, theta)) == NULL) {
         // have to create a new entry
-        OutHashEntry = (this->*CreateNewHashEntry)(x, y, theta);
+        OutHashEntry = CreateNewHashEntry(x, y, theta);
     }
 
     // need to recompute start heuristics?
@@ -2413,6 +3728,162 @@ void EnvironmentNAVXYTHETALAT::PrintState(
     }
 }
 
+// takes the hash entry and the StateID2IndexMapping row of the next stateID
+// from the chunks, allocating a new chunk if all of them are in use
+EnvNAVXYTHETALATHashEntry_t* EnvironmentNAVXYTHETALAT::AllocateHashEntry(
+    int X, int Y, int Theta)
+{
+    int stateID = (int)StateID2CoordTable.size();
+    int chunk = stateID / NAVXYTHETALAT_STATECHUNKSIZE;
+    int offset = stateID % NAVXYTHETALAT_STATECHUNKSIZE;
+
+    if (chunk == (int)HashEntryChunks.size()) {
+        HashEntryChunks.push_back(new EnvNAVXYTHETALATHashEntry_t[NAVXYTHETALAT_STATECHUNKSIZE]);
+        StateID2IndexChunks.push_back(new int[NAVXYTHETALAT_STATECHUNKSIZE * NUMOFINDICES_STATEID2IND]);
+    }
+
+    EnvNAVXYTHETALATHashEntry_t* HashEntry = &HashEntryChunks[chunk][offset];
+    HashEntry->X = X;
+    HashEntry->Y = Y;
+    HashEntry->Theta = Theta;
+    HashEntry->iteration = 0;
+    HashEntry->stateID = stateID;
+
+    // insert into the tables
+    StateID2CoordTable.push_back(HashEntry);
+
+    // insert into and initialize the mappings
+    int* entry = &StateID2IndexChunks[chunk][offset * NUMOFINDICES_STATEID2IND];
+    for (int i = 0; i < NUMOFINDICES_STATEID2IND; i++) {
+        entry[i] = -1;
+    }
+    StateID2IndexMapping.push_back(entry);
+
+    if (HashEntry->stateID != (int)StateID2IndexMapping.size() - 1) {
+        throw SBPL_Exception("ERROR in Env... function: last state has incorrect stateID");
+    }
+
+    return HashEntry;
+}
+
+void EnvironmentNAVXYTHETALAT::ResetStates()
+{
+    if (Coord2StateIDHashTable_lookup != NULL) {
+        // only the entries of the created states need to be removed from
+        // the table, the pages stay allocated
+        for (size_t i = 0; i < StateID2CoordTable.size(); i++) {
+            EnvNAVXYTHETALATHashEntry_t* HashEntry = StateID2CoordTable[i];
+            *GetLookupSlot(HashEntry->X, HashEntry->Y, HashEntry->Theta, false) = NULL;
+        }
+    }
+    else {
+        // all the slots get emptied, so the table can be cleared in place
+        // and the slots not yet moved out of the old table dropped
+        memset(Coord2StateIDHashTable, 0, (size_t)HashTableSize * sizeof(EnvNAVXYTHETALATHashSlot_t));
+        HashTableCount = 0;
+        if (OldCoord2StateIDHashTable != NULL) {
+            FreeHashTable(OldCoord2StateIDHashTable);
+            OldCoord2StateIDHashTable = NULL;
+            OldHashTableSize = 0;
+            OldHashTableMigrated = 0;
+        }
+    }
+
+    // the chunks are kept and reused by the new states
+    StateID2CoordTable.clear();
+    StateID2IndexMapping.clear();
+
+    EnvNAVXYTHETALAT.startstateid = GetStateFromCoord(
+            EnvNAVXYTHETALATCfg.StartX_c, EnvNAVXYTHETALATCfg.StartY_c, EnvNAVXYTHETALATCfg.StartTheta);
+    EnvNAVXYTHETALAT.goalstateid = GetStateFromCoord(
+            EnvNAVXYTHETALATCfg.EndX_c, EnvNAVXYTHETALATCfg.EndY_c, EnvNAVXYTHETALATCfg.EndTheta);
+}
+
+// returns the slot holding key or the empty slot where it would be inserted
+static inline EnvNAVXYTHETALATHashSlot_t* FindHashSlot(
+    EnvNAVXYTHETALATHashSlot_t* table, int tablesize, unsigned long long key, unsigned int bin)
+{
+    for (;;) {
+        EnvNAVXYTHETALATHashSlot_t* line = table + bin;
+        for (int i = 0; i < NAVXYTHETALAT_HASHSLOTSPERLINE; i++) {
+            if (line[i].entry == NULL || line[i].key == key) {
+                return &line[i];
+            }
+        }
+        bin = (bin + NAVXYTHETALAT_HASHSLOTSPERLINE) & (tablesize - 1);
+    }
+}
+
+inline EnvNAVXYTHETALATHashEntry_t* EnvironmentNAVXYTHETALAT::GetHashEntry(int X, int Y, int Theta)
+{
+    if (Coord2StateIDHashTable_lookup != NULL) {
+        return GetHashEntry_lookup(X, Y, Theta);
+    }
+    return GetHashEntry_hash(X, Y, Theta);
+}
+
+inline EnvNAVXYTHETALATHashEntry_t* EnvironmentNAVXYTHETALAT::CreateNewHashEntry(int X, int Y, int Theta)
+{
+    if (Coord2StateIDHashTable_lookup != NULL) {
+        return CreateNewHashEntry_lookup(X, Y, Theta);
+    }
+    return CreateNewHashEntry_hash(X, Y, Theta);
+}
+
+void EnvironmentNAVXYTHETALAT::InsertHashSlot(
+    EnvNAVXYTHETALATHashSlot_t* table, int tablesize, unsigned long long key,
+    EnvNAVXYTHETALATHashEntry_t* entry)
+{
+    EnvNAVXYTHETALATHashSlot_t* slot = FindHashSlot(table, tablesize, key, GETHASHBIN(key, tablesize));
+#if DEBUG
+    if (slot->entry != NULL) {
+        throw SBPL_Exception("ERROR: creating hash entry for non-NULL hashentry");
+    }
+#endif
+    slot->key = key;
+    slot->entry = entry;
+}
+
+// doubles the hash table. Its slots are moved to the new table by the
+// following insertions instead of all at once
+void EnvironmentNAVXYTHETALAT::GrowHashTable()
+{
+    // a previous growth has to be complete before starting the next one
+    if (OldCoord2StateIDHashTable != NULL) {
+        MigrateHashSlots(OldHashTableSize);
+    }
+
+    OldCoord2StateIDHashTable = Coord2StateIDHashTable;
+    OldHashTableSize = HashTableSize;
+    OldHashTableMigrated = 0;
+
+    HashTableSize = 2 * HashTableSize;
+    Coord2StateIDHashTable = AllocateHashTable(HashTableSize);
+}
+
+// moves up to numslots slots of the old hash table into the current one and
+// frees the old table once all of them have been moved
+void EnvironmentNAVXYTHETALAT::MigrateHashSlots(int numslots)
+{
+    int end = __min(OldHashTableMigrated + numslots, OldHashTableSize);
+    for (int i = OldHashTableMigrated; i < end; i++) {
+        EnvNAVXYTHETALATHashSlot_t* slot = &OldCoord2StateIDHashTable[i];
+        if (slot->entry != NULL) {
+            InsertHashSlot(Coord2StateIDHashTable, HashTableSize, slot->key, slot->entry);
+        }
+    }
+    OldHashTableMigrated = end;
+
+    // lookups probe the old table until it is freed, so entries moved
+    // already are still found there
+    if (OldHashTableMigrated == OldHashTableSize) {
+        FreeHashTable(OldCoord2StateIDHashTable);
+        OldCoord2StateIDHashTable = NULL;
+        OldHashTableSize = 0;
+        OldHashTableMigrated = 0;
+    }
+}
+
 EnvNAVXYTHETALATHashEntry_t* EnvironmentNAVXYTHETALAT::GetHashEntry_lookup(
     int X, int Y, int Theta)
 {
@@ -2422,8 +3893,28 @@ EnvNAVXYTHETALATHashEntry_t* EnvironmentNAVXYTHETALAT::GetHashEntry_lookup(
     {
         return NULL;
     }
-    int index = XYTHETA2INDEX(X,Y,Theta);
-    return Coord2StateIDHashTable_lookup[index];
+    EnvNAVXYTHETALATHashEntry_t** page = Coord2StateIDHashTable_lookup[XY2LOOKUPTILE(X, Y)];
+    if (page == NULL) {
+        return NULL;
+    }
+    return page[XYTHETA2LOOKUPINDEX(X, Y, Theta)];
+}
+
+EnvNAVXYTHETALATHashEntry_t** EnvironmentNAVXYTHETALAT::GetLookupSlot(
+    int X, int Y, int Theta, bool allocate)
+{
+    EnvNAVXYTHETALATHashEntry_t**& page = Coord2StateIDHashTable_lookup[XY2LOOKUPTILE(X, Y)];
+    if (page == NULL) {
+        if (!allocate) {
+            return NULL;
+        }
+        int pagesize = NAVXYTHETALAT_LOOKUPTILESIZE * NAVXYTHETALAT_LOOKUPTILESIZE * EnvNAVXYTHETALATCfg.NumThetaDirs;
+        page = new EnvNAVXYTHETALATHashEntry_t*[pagesize];
+        for (int i = 0; i < pagesize; i++) {
+            page[i] = NULL;
+        }
+    }
+    return &page[XYTHETA2LOOKUPINDEX(X, Y, Theta)];
 }
 
 EnvNAVXYTHETALATHashEntry_t*
@@ -2433,33 +3924,25 @@ EnvironmentNAVXYTHETALAT::GetHashEntry_hash(int X, int Y, int Theta)
     clock_t currenttime = clock();
 #endif
 
-    int binid = GETHASHBIN(X, Y, Theta);
-
-#if DEBUG
-    if ((int)Coord2StateIDHashTable[binid].size() > 5) {
-        SBPL_FPRINTF(fDeb, "WARNING: Hash table has a bin %d (X=%d Y=%d) of size %d\n", binid, X, Y, (int)Coord2StateIDHashTable[binid].size());
-
-        PrintHashTableHist(fDeb);
+    unsigned long long key;
+    if (!PackHashKey(X, Y, Theta, &key)) {
+        return NULL;
     }
-#endif
 
-    // iterate over the states in the bin and select the perfect match
-    std::vector<EnvNAVXYTHETALATHashEntry_t*>* binV = &Coord2StateIDHashTable[binid];
-    for (int ind = 0; ind < (int)binV->size(); ind++) {
-        EnvNAVXYTHETALATHashEntry_t* hashentry = binV->at(ind);
-        if (hashentry->X == X && hashentry->Y == Y && hashentry->Theta == Theta) {
-#if TIME_DEBUG
-            time_gethash += clock()-currenttime;
-#endif
-            return hashentry;
-        }
+    // the table is never more than half full, so probing always ends at an
+    // empty slot if the state is not in it
+    EnvNAVXYTHETALATHashEntry_t* hashentry =
+            FindHashSlot(Coord2StateIDHashTable, HashTableSize, key, GETHASHBIN(key, HashTableSize))->entry;
+    if (hashentry == NULL && OldCoord2StateIDHashTable != NULL) {
+        hashentry = FindHashSlot(OldCoord2StateIDHashTable, OldHashTableSize, key,
+                                 GETHASHBIN(key, OldHashTableSize))->entry;
     }
 
 #if TIME_DEBUG
     time_gethash += clock()-currenttime;
 #endif
 
-    return NULL;
+    return hashentry;
 }
 
 EnvNAVXYTHETALATHashEntry_t*
@@ -2473,45 +3956,27 @@ EnvironmentNAVXYTHETALAT::CreateNewHashEntry_lookup(int X, int Y, int Theta)
     if (Theta < 0) {
         throw SBPL_Exception("Invalid negative cell angle");
     }
-    int i;
+
+    if (X >= EnvNAVXYTHETALATCfg.EnvWidth_c || Y >= EnvNAVXYTHETALATCfg.EnvHeight_c ||
+        Theta >= EnvNAVXYTHETALATCfg.NumThetaDirs)
+    {
+        throw SBPL_Exception("ERROR: cell coordinates out of the environment");
+    }
 
 #if TIME_DEBUG
     clock_t currenttime = clock();
 #endif
 
-    EnvNAVXYTHETALATHashEntry_t* HashEntry = new EnvNAVXYTHETALATHashEntry_t;
-
-    HashEntry->X = X;
-    HashEntry->Y = Y;
-    HashEntry->Theta = Theta;
-    HashEntry->iteration = 0;
-
-    HashEntry->stateID = StateID2CoordTable.size();
-
-    // insert into the tables
-    StateID2CoordTable.push_back(HashEntry);
-
-    int index = XYTHETA2INDEX(X,Y,Theta);
+    EnvNAVXYTHETALATHashEntry_t* HashEntry = AllocateHashEntry(X, Y, Theta);
 
-    int maxsize = EnvNAVXYTHETALATCfg.EnvWidth_c * EnvNAVXYTHETALATCfg.EnvHeight_c * EnvNAVXYTHETALATCfg.NumThetaDirs;
+    EnvNAVXYTHETALATHashEntry_t** slot = GetLookupSlot(X, Y, Theta, true);
 
 #if DEBUG
-    if (Coord2StateIDHashTable_lookup[index] != NULL) {
+    if (*slot != NULL) {
         throw SBPL_Exception("ERROR: creating hash entry for non-NULL hashentry");
     }
 #endif
-    Coord2StateIDHashTable_lookup[index] = HashEntry;
-
-    // insert into and initialize the mappings
-    int* entry = new int[NUMOFINDICES_STATEID2IND];
-    StateID2IndexMapping.push_back(entry);
-    for (i = 0; i < NUMOFINDICES_STATEID2IND; i++) {
-        StateID2IndexMapping[HashEntry->stateID][i] = -1;
-    }
-
-    if (HashEntry->stateID != (int)StateID2IndexMapping.size() - 1) {
-        throw SBPL_Exception("ERROR in Env... function: last state has incorrect stateID");
-    }
+    *slot = HashEntry;
 
 #if TIME_DEBUG
     time_createhash += clock()-currenttime;
@@ -2523,39 +3988,26 @@ EnvironmentNAVXYTHETALAT::CreateNewHashEntry_lookup(int X, int Y, int Theta)
 EnvNAVXYTHETALATHashEntry_t*
 EnvironmentNAVXYTHETALAT::CreateNewHashEntry_hash(int X, int Y, int Theta)
 {
-    int i;
+    unsigned long long key;
+    if (!PackHashKey(X, Y, Theta, &key)) {
+        throw SBPL_Exception("ERROR: cell coordinates out of range of the state hash table");
+    }
 
 #if TIME_DEBUG
     clock_t currenttime = clock();
 #endif
 
-    EnvNAVXYTHETALATHashEntry_t* HashEntry = new EnvNAVXYTHETALATHashEntry_t;
-
-    HashEntry->X = X;
-    HashEntry->Y = Y;
-    HashEntry->Theta = Theta;
-    HashEntry->iteration = 0;
-
-    HashEntry->stateID = StateID2CoordTable.size();
-
-    // insert into the tables
-    StateID2CoordTable.push_back(HashEntry);
-
-    // get the hash table bin
-    i = GETHASHBIN(HashEntry->X, HashEntry->Y, HashEntry->Theta);
+    EnvNAVXYTHETALATHashEntry_t* HashEntry = AllocateHashEntry(X, Y, Theta);
 
-    // insert the entry into the bin
-    Coord2StateIDHashTable[i].push_back(HashEntry);
+    InsertHashSlot(Coord2StateIDHashTable, HashTableSize, key, HashEntry);
+    HashTableCount++;
 
-    // insert into and initialize the mappings
-    int* entry = new int[NUMOFINDICES_STATEID2IND];
-    StateID2IndexMapping.push_back(entry);
-    for (i = 0; i < NUMOFINDICES_STATEID2IND; i++) {
-        StateID2IndexMapping[HashEntry->stateID][i] = -1;
+    // keep the load factor at most 1/2
+    if (OldCoord2StateIDHashTable != NULL) {
+        MigrateHashSlots(NAVXYTHETALAT_HASHMIGRATESTEP);
     }
-
-    if (HashEntry->stateID != (int)StateID2IndexMapping.size() - 1) {
-        throw SBPL_Exception("ERROR in Env... function: last state has incorrect stateID");
+    if (2 * HashTableCount > HashTableSize) {
+        GrowHashTable();
     }
 
 #if TIME_DEBUG
@@ -2593,28 +4045,41 @@ void EnvironmentNAVXYTHETALAT::GetSuccs(
     // get X, Y for the state
     EnvNAVXYTHETALATHashEntry_t* HashEntry = StateID2CoordTable[SourceStateID];
 
-    // iterate through actions
+    // evaluate the costs of the actions to valid cells first, as one batch
+    ActionCostQueriesV.clear();
     for (aind = 0; aind < EnvNAVXYTHETALATCfg.actionwidth; aind++) {
         EnvNAVXYTHETALATAction_t* nav3daction = &EnvNAVXYTHETALATCfg.ActionsV[(unsigned int)HashEntry->Theta][aind];
-        int newX = HashEntry->X + nav3daction->dX;
-        int newY = HashEntry->Y + nav3daction->dY;
-        int newTheta = normalizeDiscAngle(nav3daction->endtheta);
 
         // skip the invalid cells
-        if (!IsValidCell(newX, newY)) {
+        if (!IsValidCell(HashEntry->X + nav3daction->dX, HashEntry->Y + nav3daction->dY)) {
             continue;
         }
 
-        // get cost
-        int cost = GetActionCost(HashEntry->X, HashEntry->Y, HashEntry->Theta, nav3daction);
+        EnvNAVXYTHETALATActionCostQuery_t query;
+        query.SourceX = HashEntry->X;
+        query.SourceY = HashEntry->Y;
+        query.SourceTheta = HashEntry->Theta;
+        query.action = nav3daction;
+        ActionCostQueriesV.push_back(query);
+    }
+    GetActionCosts(&ActionCostQueriesV);
+
+    // then look up (or create) the successors in order
+    for (size_t qind = 0; qind < ActionCostQueriesV.size(); qind++) {
+        EnvNAVXYTHETALATAction_t* nav3daction = ActionCostQueriesV[qind].action;
+        int cost = ActionCostQueriesV[qind].cost;
         if (cost >= INFINITECOST) {
             continue;
         }
 
+        int newX = HashEntry->X + nav3daction->dX;
+        int newY = HashEntry->Y + nav3daction->dY;
+        int newTheta = normalizeDiscAngle(nav3daction->endtheta);
+
         EnvNAVXYTHETALATHashEntry_t* OutHashEntry;
-        if ((OutHashEntry = (this->*GetHashEntry)(newX, newY, newTheta)) == NULL) {
+        if ((OutHashEntry = GetHashEntry(newX, newY, newTheta)) == NULL) {
             // have to create a new entry
-            OutHashEntry = (this->*CreateNewHashEntry)(newX, newY, newTheta);
+            OutHashEntry = CreateNewHashEntry(newX, newY, newTheta);
         }
 
         SuccIDV->push_back(OutHashEntry->stateID);
@@ -2654,9 +4119,10 @@ void EnvironmentNAVXYTHETALAT::GetPreds(
     PredIDV->reserve(EnvNAVXYTHETALATCfg.PredActionsV[(unsigned int)HashEntry->Theta].size());
     CostV->reserve(EnvNAVXYTHETALATCfg.PredActionsV[(unsigned int)HashEntry->Theta].size());
 
-    // iterate through actions
+    // evaluate the costs of the actions from valid cells first, as one batch
     std::vector<EnvNAVXYTHETALATAction_t*>* actionsV = &EnvNAVXYTHETALATCfg.PredActionsV[(unsigned int)HashEntry->Theta];
-    for (aind = 0; aind < (int)EnvNAVXYTHETALATCfg.PredActionsV[(unsigned int)HashEntry->Theta].size(); aind++) {
+    ActionCostQueriesV.clear();
+    for (aind = 0; aind < (int)actionsV->size(); aind++) {
 
         EnvNAVXYTHETALATAction_t* nav3daction = actionsV->at(aind);
 
@@ -2676,20 +4142,30 @@ void EnvironmentNAVXYTHETALAT::GetPreds(
             continue;
         }
 
-        // get cost
-        int cost = GetActionCost(predX, predY, predTheta, nav3daction);
-        if (cost >= INFINITECOST) {
+        EnvNAVXYTHETALATActionCostQuery_t query;
+        query.SourceX = predX;
+        query.SourceY = predY;
+        query.SourceTheta = predTheta;
+        query.action = nav3daction;
+        ActionCostQueriesV.push_back(query);
+    }
+    GetActionCosts(&ActionCostQueriesV);
+
+    // then look up (or create) the predecessors in order
+    for (size_t qind = 0; qind < ActionCostQueriesV.size(); qind++) {
+        const EnvNAVXYTHETALATActionCostQuery_t& query = ActionCostQueriesV[qind];
+        if (query.cost >= INFINITECOST) {
             continue;
         }
 
         EnvNAVXYTHETALATHashEntry_t* OutHashEntry;
-        if ((OutHashEntry = (this->*GetHashEntry)(predX, predY, predTheta)) == NULL) {
+        if ((OutHashEntry = GetHashEntry(query.SourceX, query.SourceY, query.SourceTheta)) == NULL) {
             // have to create a new entry
-            OutHashEntry = (this->*CreateNewHashEntry)(predX, predY, predTheta);
+            OutHashEntry = CreateNewHashEntry(query.SourceX, query.SourceY, query.SourceTheta);
         }
 
         PredIDV->push_back(OutHashEntry->stateID);
-        CostV->push_back(cost);
+        CostV->push_back(query.cost);
     }
 
 #if TIME_DEBUG
@@ -2745,9 +4221,9 @@ void EnvironmentNAVXYTHETALAT::SetAllActionsandAllOutcomes(CMDPSTATE* state)
 #endif
 
         EnvNAVXYTHETALATHashEntry_t* OutHashEntry;
-        if ((OutHashEntry = (this->*GetHashEntry)(newX, newY, newTheta)) == NULL) {
+        if ((OutHashEntry = GetHashEntry(newX, newY, newTheta)) == NULL) {
             // have to create a new entry
-            OutHashEntry = (this->*CreateNewHashEntry)(newX, newY, newTheta);
+            OutHashEntry = CreateNewHashEntry(newX, newY, newTheta);
         }
         action->AddOutcome(OutHashEntry->stateID, cost, 1.0);
 
@@ -2780,7 +4256,7 @@ void EnvironmentNAVXYTHETALAT::GetPredsofChangedEdges(
             affectedcell.y = affectedcell.y + cell.y;
 
             // insert only if it was actually generated
-            affectedHashEntry = (this->*GetHashEntry)(affectedcell.x, affectedcell.y, affectedcell.theta);
+            affectedHashEntry = GetHashEntry(affectedcell.x, affectedcell.y, affectedcell.theta);
             if (affectedHashEntry != NULL && affectedHashEntry->iteration < iteration) {
                 preds_of_changededgesIDV->push_back(affectedHashEntry->stateID);
                 affectedHashEntry->iteration = iteration; // mark as already inserted
@@ -2815,7 +4291,7 @@ void EnvironmentNAVXYTHETALAT::GetSuccsofChangedEdges(
             affectedcell.y = affectedcell.y + cell.y;
 
             // insert only if it was actually generated
-            affectedHashEntry = (this->*GetHashEntry)(affectedcell.x, affectedcell.y, affectedcell.theta);
+            affectedHashEntry = GetHashEntry(affectedcell.x, affectedcell.y, affectedcell.theta);
             if (affectedHashEntry != NULL && affectedHashEntry->iteration < iteration) {
                 succs_of_changededgesIDV->push_back(affectedHashEntry->stateID);
                 // mark as already inserted
@@ -2829,46 +4305,50 @@ void EnvironmentNAVXYTHETALAT::InitializeEnvironment()
 {
     EnvNAVXYTHETALATHashEntry_t* HashEntry;
 
-    int maxsize = EnvNAVXYTHETALATCfg.EnvWidth_c * EnvNAVXYTHETALATCfg.EnvHeight_c * EnvNAVXYTHETALATCfg.NumThetaDirs;
+    long long maxsize = (long long)EnvNAVXYTHETALATCfg.EnvWidth_c * EnvNAVXYTHETALATCfg.EnvHeight_c *
+            EnvNAVXYTHETALATCfg.NumThetaDirs;
 
     if (maxsize <= SBPL_XYTHETALAT_MAXSTATESFORLOOKUP) {
         SBPL_PRINTF("environment stores states in lookup table\n");
 
-        Coord2StateIDHashTable_lookup = new EnvNAVXYTHETALATHashEntry_t*[maxsize];
-        for (int i = 0; i < maxsize; i++) {
+        // only the directory is allocated here, the pages on first use
+        LookupTilesX = (EnvNAVXYTHETALATCfg.EnvWidth_c + NAVXYTHETALAT_LOOKUPTILESIZE - 1) >> NAVXYTHETALAT_LOOKUPTILESHIFT;
+        LookupTilesY = (EnvNAVXYTHETALATCfg.EnvHeight_c + NAVXYTHETALAT_LOOKUPTILESIZE - 1) >> NAVXYTHETALAT_LOOKUPTILESHIFT;
+        Coord2StateIDHashTable_lookup = new EnvNAVXYTHETALATHashEntry_t**[LookupTilesX * LookupTilesY];
+        for (int i = 0; i < LookupTilesX * LookupTilesY; i++) {
             Coord2StateIDHashTable_lookup[i] = NULL;
         }
-        GetHashEntry = &EnvironmentNAVXYTHETALAT::GetHashEntry_lookup;
-        CreateNewHashEntry = &EnvironmentNAVXYTHETALAT::CreateNewHashEntry_lookup;
 
         // not using hash table
         HashTableSize = 0;
+        HashTableCount = 0;
         Coord2StateIDHashTable = NULL;
     }
     else {
         SBPL_PRINTF("environment stores states in hashtable\n");
 
         // initialize the map from Coord to StateID
-        HashTableSize = 4 * 1024 * 1024; // should be power of two
-        Coord2StateIDHashTable = new std::vector<EnvNAVXYTHETALATHashEntry_t*>[HashTableSize];
-        GetHashEntry = &EnvironmentNAVXYTHETALAT::GetHashEntry_hash;
-        CreateNewHashEntry = &EnvironmentNAVXYTHETALAT::CreateNewHashEntry_hash;
+        HashTableSize = NAVXYTHETALAT_HASHINITIALSIZE; // should be power of two
+        HashTableCount = 0;
+        Coord2StateIDHashTable = AllocateHashTable(HashTableSize);
 
-        // not using hash
+        // not using lookup table
         Coord2StateIDHashTable_lookup = NULL;
+        LookupTilesX = 0;
+        LookupTilesY = 0;
     }
 
     // initialize the map from StateID to Coord
     StateID2CoordTable.clear();
 
     // create start state
-    if (NULL == (HashEntry = (this->*GetHashEntry)(
+    if (NULL == (HashEntry = GetHashEntry(
             EnvNAVXYTHETALATCfg.StartX_c,
             EnvNAVXYTHETALATCfg.StartY_c,
             EnvNAVXYTHETALATCfg.StartTheta)))
     {
         // have to create a new entry
-        HashEntry = (this->*CreateNewHashEntry)(
+        HashEntry = CreateNewHashEntry(
                 EnvNAVXYTHETALATCfg.StartX_c,
                 EnvNAVXYTHETALATCfg.StartY_c,
                 EnvNAVXYTHETALATCfg.StartTheta);
@@ -2876,13 +4356,13 @@ void EnvironmentNAVXYTHETALAT::InitializeEnvironment()
     EnvNAVXYTHETALAT.startstateid = HashEntry->stateID;
 
     // create goal state
-    if ((HashEntry = (this->*GetHashEntry)(
+    if ((HashEntry = GetHashEntry(
             EnvNAVXYTHETALATCfg.EndX_c,
             EnvNAVXYTHETALATCfg.EndY_c,
             EnvNAVXYTHETALATCfg.EndTheta)) == NULL)
     {
         // have to create a new entry
-        HashEntry = (this->*CreateNewHashEntry)(
+        HashEntry = CreateNewHashEntry(
                 EnvNAVXYTHETALATCfg.EndX_c,
                 EnvNAVXYTHETALATCfg.EndY_c,
                 EnvNAVXYTHETALATCfg.EndTheta);
@@ -2895,39 +4375,38 @@ void EnvironmentNAVXYTHETALAT::InitializeEnvironment()
     EnvNAVXYTHETALAT.bInitialized = true;
 }
 
-// examples of hash functions: map state coordinates onto a hash value
-// #define GETHASHBIN(X, Y) (Y*WIDTH_Y+X)
-// here we have state coord: <X1, X2, X3, X4>
-unsigned int EnvironmentNAVXYTHETALAT::GETHASHBIN(
-    unsigned int X1,
-    unsigned int X2,
-    unsigned int Theta)
+// maps the packed state coordinates onto the first slot of the cache line
+// where probing starts
+unsigned int EnvironmentNAVXYTHETALAT::GETHASHBIN(unsigned long long key, int tablesize) const
 {
-    return inthash(inthash(X1) + (inthash(X2) << 1) + (inthash(Theta) << 2)) & (HashTableSize - 1);
+    return (unsigned int)inthash(key) & (tablesize - 1) & ~(NAVXYTHETALAT_HASHSLOTSPERLINE - 1);
 }
 
+// histogram of the number of slots probed to find each state
 void EnvironmentNAVXYTHETALAT::PrintHashTableHist(FILE* fOut)
 {
-    int s0 = 0, s1 = 0, s50 = 0, s100 = 0, s200 = 0, s300 = 0, slarge = 0;
+    int s1 = 0, s4 = 0, s16 = 0, s64 = 0, slarge = 0;
 
     for (int j = 0; j < HashTableSize; j++) {
-        if ((int)Coord2StateIDHashTable[j].size() == 0)
-            s0++;
-        else if ((int)Coord2StateIDHashTable[j].size() < 5)
+        EnvNAVXYTHETALATHashSlot_t* slot = &Coord2StateIDHashTable[j];
+        if (slot->entry == NULL) {
+            continue;
+        }
+        int bin = GETHASHBIN(slot->key, HashTableSize);
+        int probes = ((j - bin) & (HashTableSize - 1)) + 1;
+        if (probes <= 1)
             s1++;
-        else if ((int)Coord2StateIDHashTable[j].size() < 25)
-            s50++;
-        else if ((int)Coord2StateIDHashTable[j].size() < 50)
-            s100++;
-        else if ((int)Coord2StateIDHashTable[j].size() < 100)
-            s200++;
-        else if ((int)Coord2StateIDHashTable[j].size() < 400)
-            s300++;
+        else if (probes <= 4)
+            s4++;
+        else if (probes <= 16)
+            s16++;
+        else if (probes <= 64)
+            s64++;
         else
             slarge++;
     }
-    SBPL_FPRINTF(fOut, "hash table histogram: 0:%d, <5:%d, <25:%d, <50:%d, <100:%d, <400:%d, >400:%d\n", s0, s1, s50,
-                 s100, s200, s300, slarge);
+    SBPL_FPRINTF(fOut, "hash table of size %d with %d states, probes: 1:%d, <=4:%d, <=16:%d, <=64:%d, >64:%d\n",
+                 HashTableSize, HashTableCount, s1, s4, s16, s64, slarge);
 }
 
 int EnvironmentNAVXYTHETALAT::GetFromToHeuristic(int FromStateID, int ToStateID)
@@ -2971,7 +4450,11 @@ int EnvironmentNAVXYTHETALAT::GetGoalHeuristic(int stateID)
 
     EnvNAVXYTHETALATHashEntry_t* HashEntry = StateID2CoordTable[stateID];
     // computes distances from start state that is grid2D, so it is EndX_c EndY_c
-    int h2D = grid2Dsearchfromgoal->getlowerboundoncostfromstart_inmm(HashEntry->X, HashEntry->Y);
+    int h2D = bLazyHeuristics ?
+            grid2Dsearchfromgoal->getcostfromstart_inmm(
+                    EnvNAVXYTHETALATCfg.Grid2D, EnvNAVXYTHETALATCfg.Grid2DStride,
+                    EnvNAVXYTHETALATCfg.cost_inscribed_thresh, HashEntry->X, HashEntry->Y) :
+            grid2Dsearchfromgoal->getlowerboundoncostfromstart_inmm(HashEntry->X, HashEntry->Y);
     int hEuclid = (int)(NAVXYTHETALAT_COSTMULT_MTOMM *
             EuclideanDistance_m(HashEntry->X, HashEntry->Y, EnvNAVXYTHETALATCfg.EndX_c, EnvNAVXYTHETALATCfg.EndY_c));
 
@@ -2992,7 +4475,11 @@ int EnvironmentNAVXYTHETALAT::GetStartHeuristic(int stateID)
 #endif
 
     EnvNAVXYTHETALATHashEntry_t* HashEntry = StateID2CoordTable[stateID];
-    int h2D = grid2Dsearchfromstart->getlowerboundoncostfromstart_inmm(HashEntry->X, HashEntry->Y);
+    int h2D = bLazyHeuristics ?
+            grid2Dsearchfromstart->getcostfromstart_inmm(
+                    EnvNAVXYTHETALATCfg.Grid2D, EnvNAVXYTHETALATCfg.Grid2DStride,
+                    EnvNAVXYTHETALATCfg.cost_inscribed_thresh, HashEntry->X, HashEntry->Y) :
+            grid2Dsearchfromstart->getlowerboundoncostfromstart_inmm(HashEntry->X, HashEntry->Y);
     int hEuclid = (int)(NAVXYTHETALAT_COSTMULT_MTOMM *
             EuclideanDistance_m(EnvNAVXYTHETALATCfg.StartX_c, EnvNAVXYTHETALATCfg.StartY_c, HashEntry->X, HashEntry->Y));
 
@@ -3066,8 +4553,8 @@ void EnvironmentNAVXYTHETALAT::GetLazySuccs(
         // if we are supposed to return the action, then don't do lazy
         if (!actionV) {
             EnvNAVXYTHETALATHashEntry_t* OutHashEntry;
-            if ((OutHashEntry = (this->*GetHashEntry)(newX, newY, newTheta)) == NULL) {
-                OutHashEntry = (this->*CreateNewHashEntry)(newX, newY, newTheta);
+            if ((OutHashEntry = GetHashEntry(newX, newY, newTheta)) == NULL) {
+                OutHashEntry = CreateNewHashEntry(newX, newY, newTheta);
             }
             SuccIDV->push_back(OutHashEntry->stateID);
             CostV->push_back(nav3daction->cost);
@@ -3082,9 +4569,9 @@ void EnvironmentNAVXYTHETALAT::GetLazySuccs(
         }
 
         EnvNAVXYTHETALATHashEntry_t* OutHashEntry;
-        if ((OutHashEntry = (this->*GetHashEntry)(newX, newY, newTheta)) == NULL) {
+        if ((OutHashEntry = GetHashEntry(newX, newY, newTheta)) == NULL) {
             // have to create a new entry
-            OutHashEntry = (this->*CreateNewHashEntry)(newX, newY, newTheta);
+            OutHashEntry = CreateNewHashEntry(newX, newY, newTheta);
         }
 
         SuccIDV->push_back(OutHashEntry->stateID);
@@ -3117,7 +4604,7 @@ int EnvironmentNAVXYTHETALAT::GetTrueCost(int parentID, int childID)
         }
 
         EnvNAVXYTHETALATHashEntry_t* hash;
-        if ((hash = (this->*GetHashEntry)(newX, newY, newTheta)) == NULL) {
+        if ((hash = GetHashEntry(newX, newY, newTheta)) == NULL) {
             continue;
         }
         if (hash->stateID != toHash->stateID) {
@@ -3197,8 +4684,8 @@ void EnvironmentNAVXYTHETALAT::GetLazyPreds(
         }
 
         EnvNAVXYTHETALATHashEntry_t* OutHashEntry;
-        if ((OutHashEntry = (this->*GetHashEntry)(predX, predY, predTheta)) == NULL) {
-            OutHashEntry = (this->*CreateNewHashEntry)(predX, predY, predTheta);
+        if ((OutHashEntry = GetHashEntry(predX, predY, predTheta)) == NULL) {
+            OutHashEntry = CreateNewHashEntry(predX, predY, predTheta);
         }
 
         PredIDV->push_back(OutHashEntry->stateID);
@@ -3251,6 +4738,19 @@ void EnvironmentNAVXYTHETALAT::SetCollisionCellsForPrimitive(
     int motprimID,
     const std::vector<sbpl_2Dcell_t>& collisionCells)
 {
+    {
+        // the last lattice model made from this environment does not count
+        // if nobody else uses it
+        std::lock_guard<std::mutex> lock(LatticeModelMutex);
+        if (LatticeModel && LatticeModel.use_count() == 1 &&
+            LatticeModel->cfg.Grid2D != EnvNAVXYTHETALATCfg.Grid2D)
+        {
+            LatticeModel.reset();
+        }
+    }
+    if (ActionTable.use_count() > 1) {
+        throw SBPL_Exception("ERROR: the actions of this environment are shared with a lattice model");
+    }
     for (int aind = 0; aind < EnvNAVXYTHETALATCfg.actionwidth; aind++) {
          EnvNAVXYTHETALATAction_t* nav3daction = &EnvNAVXYTHETALATCfg.ActionsV[angle_c][aind];
          if (nav3daction->motprimID == motprimID) {
@@ -3258,6 +4758,7 @@ void EnvironmentNAVXYTHETALAT::SetCollisionCellsForPrimitive(
              for(int i = 0; i < collisionCells.size(); i++) {
                 nav3daction->intersectingcellsV.push_back(collisionCells.at(i));
              }
+             ComputeCollisionDataforAction(nav3daction);
              return;
          }
     }
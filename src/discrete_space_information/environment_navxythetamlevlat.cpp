@@ -41,8 +41,6 @@ static clock_t time_createhash = 0;
 static clock_t time_getsuccs = 0;
 #endif
 
-static long int checks = 0;
-
 //-----------------constructors/destructors-------------------------------
 
 EnvironmentNAVXYTHETAMLEVLAT::EnvironmentNAVXYTHETAMLEVLAT()
@@ -157,7 +155,7 @@ bool EnvironmentNAVXYTHETAMLEVLAT::IsObstacle(int X, int Y, int levind)
 // returns the maximum over all levels of the cost corresponding to the cell <x,y>
 unsigned char EnvironmentNAVXYTHETAMLEVLAT::GetMapCost(int X, int Y)
 {
-    unsigned char mapcost = EnvNAVXYTHETALATCfg.Grid2D[X][Y];
+    unsigned char mapcost = EnvNAVXYTHETALATCfg.Grid2DCell(X, Y);
 
     for (int levind = 0; levind < numofadditionalzlevs; levind++) {
         mapcost = __max(mapcost, AddLevelGrid2D[levind][X][Y]);
@@ -288,7 +286,7 @@ int EnvironmentNAVXYTHETAMLEVLAT::GetActionCostacrossAddLevels(int SourceX, int
         if (AddLevelFootprintPolygonV[levelind].size() > 1 && (int)maxcellcostateachlevel[levelind] >=
             AddLevel_cost_possibly_circumscribed_thresh[levelind])
         {
-            checks++;
+            checks.fetch_add(1, std::memory_order_relaxed);
 
             //get intersecting cells for this level
             vector<sbpl_2Dcell_t>* intersectingcellsV =
@@ -33,7 +33,12 @@
 #include <cstdio>
 #include <vector>
 #include <sstream>
+#include <string>
+#include <atomic>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
 
 #include <sbpl/discrete_space_information/environment.h>
 #include <sbpl/utils/utils.h>
@@ -46,7 +51,7 @@
 #define NAVXYTHETALAT_DXYWIDTH 8
 #define ENVNAVXYTHETALAT_DEFAULTOBSTHRESH 254	//see explanation of the value below
 //maximum number of states for storing them into lookup (as opposed to hash)
-#define SBPL_XYTHETALAT_MAXSTATESFORLOOKUP 100000000
+#define SBPL_XYTHETALAT_MAXSTATESFORLOOKUP 1000000000
 //definition of theta orientations
 //0 - is aligned with X-axis in the positive direction (1,0 in polar coordinates)
 //theta increases as we go counterclockwise
@@ -57,9 +62,61 @@
 #define NAVXYTHETALAT_DEFAULT_ACTIONWIDTH 5
 #define NAVXYTHETALAT_COSTMULT_MTOMM 1000
 
+// number of states whose hash entries and StateID2IndexMapping rows are
+// allocated together
+#define NAVXYTHETALAT_STATECHUNKSIZE 4096
+
+// side (in cells) of the square tiles of the lookup table, each tile gets its
+// page of NAVXYTHETALAT_LOOKUPTILESIZE^2*NumThetaDirs entries on first touch
+#define NAVXYTHETALAT_LOOKUPTILESHIFT 4
+#define NAVXYTHETALAT_LOOKUPTILESIZE (1 << NAVXYTHETALAT_LOOKUPTILESHIFT)
+
+// initial number of slots of the open-addressing hash table (power of two)
+#define NAVXYTHETALAT_HASHINITIALSIZE (64 * 1024)
+// number of slots of the hash table that share a cache line; probing goes
+// through all the slots of a line before moving to the next one
+#define NAVXYTHETALAT_HASHSLOTSPERLINE 4
+// number of slots moved from the old to the grown hash table per insertion
+#define NAVXYTHETALAT_HASHMIGRATESTEP 16
+
+// version of the on-disk motion primitive kernel cache, bump it whenever the
+// file layout or the way kernels are computed changes
+#define NAVXYTHETALAT_KERNELCACHE_VERSION 1
+
+// version of the binary motion primitive file format (see
+// WriteMotionPrimitivesBinary), bump it whenever the layout changes
+#define NAVXYTHETALAT_MPRIMBINARY_VERSION 1
+
+// alignment (in bytes) of the costmap buffer
+#define NAVXYTHETALAT_GRID2D_ALIGNMENT 64
+
+// number of cells GetActionCost reduces to a max before testing thresholds
+#define NAVXYTHETALAT_COLLISIONCHECK_BLOCKSIZE 8
+
+// expansions with fewer actions than this evaluate their action costs on the
+// searching thread alone (see SetActionCostThreads)
+#define NAVXYTHETALAT_DEFAULT_ACTIONCOSTMINBATCH 24
+
+// the 2D heuristic searches are rerun from scratch instead of being repaired
+// once more than 1/NAVXYTHETALAT_HEURISTICREPAIR_MAXFRACTION of the cells of
+// the map have changed
+#define NAVXYTHETALAT_HEURISTICREPAIR_MAXFRACTION 16
+
 class CMDPSTATE;
 class MDPConfig;
+class SBPLWorkerPool;
 class SBPL2DGridSearch;
+class SBPL2DGridSearchCache;
+
+// a row of the packed footprint of an action: bit i of the jth of its words
+// is the cell (dX + 64 * j + i, dY) relative to the source cell
+struct EnvNAVXYTHETALATMaskRow_t
+{
+    int dX;
+    int dY;
+    int firstword; // index of the first word in footprintmaskwordsV
+    int numofwords;
+};
 
 struct EnvNAVXYTHETALATAction_t
 {
@@ -70,7 +127,8 @@ struct EnvNAVXYTHETALATAction_t
     int endtheta;
     unsigned int cost;
 
-    // These are cells of a motion primitive, including footprint.
+    // These are cells of a motion primitive, including footprint. Ordered
+    // farthest-from-source first so that collisions are found early.
     std::vector<sbpl_2Dcell_t> intersectingcellsV;
 
     // Raw interposes from motion primitive
@@ -84,6 +142,35 @@ struct EnvNAVXYTHETALATAction_t
 
     double turning_radius;
 
+    // Bounding box (relative to the source cell) of the source cell, the end
+    // cell, interm3DcellsV and intersectingcellsV. If it lies inside the map,
+    // GetActionCost skips the per-cell bounds checks.
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+
+    // interm3DcellsV (last cell first) and intersectingcellsV as offsets from
+    // the source cell in a costmap whose stride is the width of the map, see
+    // GetActionCost
+    std::vector<int> interm2DoffsetsV;
+    std::vector<int> intersectingoffsetsV;
+
+    // intersectingcellsV packed into bit rows, tested against the obstacle
+    // mask of the environment, see GetActionCost
+    std::vector<EnvNAVXYTHETALATMaskRow_t> footprintmaskrowsV;
+    std::vector<unsigned long long> footprintmaskwordsV;
+};
+
+// the cost of action from the cell SourceX, SourceY, evaluated by
+// EnvironmentNAVXYTHETALATTICE::GetActionCosts
+struct EnvNAVXYTHETALATActionCostQuery_t
+{
+    int SourceX;
+    int SourceY;
+    int SourceTheta;
+    EnvNAVXYTHETALATAction_t* action;
+    int cost;
 };
 
 struct EnvNAVXYTHETALATHashEntry_t
@@ -96,6 +183,13 @@ struct EnvNAVXYTHETALATHashEntry_t
 
 };
 
+// slot of the open-addressing hash table; empty slots have a NULL entry
+struct EnvNAVXYTHETALATHashSlot_t
+{
+    unsigned long long key; // packed <X, Y, Theta>
+    EnvNAVXYTHETALATHashEntry_t* entry;
+};
+
 struct SBPL_xytheta_mprimitive
 {
     int motprimID;
@@ -119,6 +213,27 @@ struct EnvironmentNAVXYTHETALAT_t
     //any additional variables
 };
 
+// hash of a discrete <x, y, theta> cell
+struct EnvNAVXYTHETALATCellHash
+{
+    size_t operator()(const sbpl_xy_theta_cell_t& cell) const
+    {
+        return ((size_t)(unsigned int)cell.x * 73856093u) ^ ((size_t)(unsigned int)cell.y * 19349663u) ^
+               ((size_t)(unsigned int)cell.theta * 83492791u);
+    }
+};
+
+// cells covered by the robot footprint at one discrete theta, relative to the
+// cell of the robot, and their bounding box
+struct EnvNAVXYTHETALATFootprint_t
+{
+    std::vector<sbpl_2Dcell_t> cells;
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+};
+
 //configuration parameters
 struct EnvNAVXYTHETALATConfig_t
 {
@@ -131,7 +246,18 @@ struct EnvNAVXYTHETALATConfig_t
     int EndX_c;
     int EndY_c;
     int EndTheta;
-    unsigned char** Grid2D;
+
+    // costmap, stored row-major in a single buffer aligned to
+    // NAVXYTHETALAT_GRID2D_ALIGNMENT bytes: the cost of cell (x, y) is
+    // Grid2D[y * Grid2DStride + x]
+    unsigned char* Grid2D;
+    int Grid2DStride;
+    // the version of the contents of Grid2D for the heuristic cache, a hash of
+    // them once a whole costmap is taken and a new one after UpdateCost
+    unsigned long long Grid2DVersion;
+
+    unsigned char& Grid2DCell(int x, int y) { return Grid2D[y * Grid2DStride + x]; }
+    unsigned char Grid2DCell(int x, int y) const { return Grid2D[y * Grid2DStride + x]; }
 
     std::vector<double> ThetaDirs;
     double StartTheta_rad;
@@ -180,11 +306,73 @@ struct EnvNAVXYTHETALATConfig_t
     std::vector<SBPL_xytheta_mprimitive> mprimV;
 
     std::vector<sbpl_2Dpt_t> FootprintPolygon;
+    //FootprintCellsV[theta] - footprint cells of the robot at theta
+    std::vector<EnvNAVXYTHETALATFootprint_t> FootprintCellsV;
 
     double expansion_angle_lower_limit;  // If graph node angle is below this, do not expand it (limit possible orientations)
     double expansion_angle_upper_limit; // If graph node angle is above this, do not expand it (limit possible orientations)
 };
 
+// owner of the actions of a lattice, EnvNAVXYTHETALATConfig_t::ActionsV and
+// PredActionsV point into it. It is shared by an environment, the lattice
+// models made from it and the environments that search those.
+struct EnvNAVXYTHETALATActionTable_t
+{
+    explicit EnvNAVXYTHETALATActionTable_t(int numthetadirs);
+    ~EnvNAVXYTHETALATActionTable_t();
+
+    int NumThetaDirs;
+    EnvNAVXYTHETALATAction_t** ActionsV;
+    std::vector<EnvNAVXYTHETALATAction_t*>* PredActionsV;
+
+private:
+    EnvNAVXYTHETALATActionTable_t(const EnvNAVXYTHETALATActionTable_t&);
+    EnvNAVXYTHETALATActionTable_t& operator=(const EnvNAVXYTHETALATActionTable_t&);
+};
+
+/**
+ * \brief the read-only part of an EnvironmentNAVXYTHETALAT: a snapshot of its
+ *        costmap, its actions with their collision kernels and the data
+ *        derived from them.
+ *
+ * It never changes once made, so any number of threads can search it at once
+ * through their own environments (see
+ * EnvironmentNAVXYTHETALAT::InitializeEnvFromModel), which only hold the
+ * state table and the heuristics of their searches. Those environments share
+ * the costmap and the actions of the model instead of copying them, and keep
+ * the model alive.
+ */
+class EnvNAVXYTHETALATLatticeModel
+{
+public:
+    ~EnvNAVXYTHETALATLatticeModel();
+
+    /**
+     * \brief the configuration of the lattice, Grid2D is the snapshot of the
+     *        costmap and the start and the goal are the ones the environment
+     *        had when the model was made
+     */
+    const EnvNAVXYTHETALATConfig_t& getconfig() const { return cfg; }
+
+private:
+    friend class EnvironmentNAVXYTHETALATTICE;
+    friend class EnvironmentNAVXYTHETALAT;
+
+    EnvNAVXYTHETALATLatticeModel();
+    EnvNAVXYTHETALATLatticeModel(const EnvNAVXYTHETALATLatticeModel&);
+    EnvNAVXYTHETALATLatticeModel& operator=(const EnvNAVXYTHETALATLatticeModel&);
+
+    EnvNAVXYTHETALATConfig_t cfg; // Grid2D is owned by the model
+    std::shared_ptr<EnvNAVXYTHETALATActionTable_t> actiontable;
+    std::vector<unsigned long long> obstaclemaskV; // of cfg.Grid2D
+    int obstaclemaskstride;
+    std::vector<sbpl_xy_theta_cell_t> affectedsuccstatesV;
+    std::vector<sbpl_xy_theta_cell_t> affectedpredstatesV;
+    int blocksize;
+    int bucketsize;
+    bool bUseNonUniformAngles;
+};
+
 class EnvNAVXYTHETALAT_InitParms
 {
 public:
@@ -244,6 +432,25 @@ public:
      */
     virtual bool SetEnvParameter(const char* parameter, int value);
 
+    /**
+     * \brief sets the directory where the motion primitive kernels computed
+     *        by InitializeEnv are cached. The cache files are keyed by a hash
+     *        of the motion primitives, the footprint and the cellsize, so
+     *        environments with the same ones load the kernels instead of
+     *        recomputing them. Has to be called before InitializeEnv; an
+     *        empty directory disables the cache (the default)
+     */
+    virtual void SetKernelCacheDirectory(const char* directory);
+
+    /**
+     * \brief writes the motion primitives of the environment to filename in
+     *        the binary format. InitializeEnv recognizes binary files by
+     *        their header and loads them with a single read instead of
+     *        parsing text, so this converts a text .mprim file once it has
+     *        been loaded
+     */
+    virtual bool WriteMotionPrimitivesBinary(const char* filename) const;
+
     /**
      * \brief returns the value of specific parameter - see function body for the list of parameters
      */
@@ -311,11 +518,51 @@ public:
     virtual void Set2DBlockSize(int BlockSize);
 
     /**
-     * @brief Set2DBucketSize Set the initial size of the CSlidingBuckets used for the fringe priority list
+     * @brief Set2DBucketSize Set the initial size of the sliding buckets used for the fringe priority list
      * @param BucketSize
      */
     virtual void Set2DBucketSize(int BucketSize);
 
+    /**
+     * \brief evaluates the action costs of an expansion on numthreads threads
+     *        (the searching one included) when it has at least minactions
+     *        actions, the successors and their states are still created by
+     *        the searching thread alone. The extra threads poll for work
+     *        while the search runs, so numthreads should not exceed the free
+     *        cores. 1 evaluates the costs serially (the default).
+     */
+    virtual void SetActionCostThreads(int numthreads, int minactions = NAVXYTHETALAT_DEFAULT_ACTIONCOSTMINBATCH);
+
+    int GetActionCostThreads() const;
+
+    /**
+     * \brief runs the 2D searches that compute the heuristics on numthreads
+     *        threads (the searching one included), which pays off on large
+     *        maps. 1 runs them serially (the default).
+     */
+    virtual void SetHeuristicThreads(int numthreads);
+
+    int GetHeuristicThreads() const;
+
+    /**
+     * \brief shares the goal distances computed by the 2D heuristic search
+     *        from the goal with the environments holding the same cache (NULL
+     *        stops caching). A goal whose distances are in the cache for the
+     *        current map costs no search, the cached distances are for all
+     *        the cells, so computing them costs more than the usual search.
+     */
+    virtual void SetHeuristicCache(std::shared_ptr<SBPL2DGridSearchCache> cache);
+
+    std::shared_ptr<SBPL2DGridSearchCache> GetHeuristicCache() const;
+
+    /**
+     * \brief computes the goal distances for the goal cell <x,y> and adds
+     *        them to the heuristic cache, for instance for the goals of the
+     *        coming queries while the robot is idle. Returns false if there
+     *        is no cache or the cell is outside of the map.
+     */
+    virtual bool PrecomputeGoalHeuristics(int x, int y);
+
     virtual double DiscTheta2ContNew(int theta) const;
 
     virtual int ContTheta2DiscNew(double theta) const;
@@ -377,10 +624,31 @@ public:
 
     /**
      * \brief re-setting the whole 2D map
-     *        transform from linear array mapdata to the 2D matrix used internally: Grid2D[x][y] = mapdata[x+y*width]
+     *        mapdata is copied into the row-major costmap used internally: Grid2D[x+y*stride] = mapdata[x+y*width]
      */
     virtual bool SetMap(const unsigned char* mapdata);
 
+    /**
+     * \brief same as SetMap(mapdata) for a map that differs from the current
+     *        one only in changedcells, which lets the 2D searches of the
+     *        heuristics be repaired instead of run again (see UpdateCost)
+     */
+    virtual bool SetMap(const unsigned char* mapdata, const std::vector<sbpl_2Dcell_t>& changedcells);
+
+    /**
+     * \brief makes the environment use an externally owned costmap without
+     *        copying it. Cell <x,y> is mapdata[x+y*stride]. The buffer has to
+     *        outlive the environment or be replaced (by SetMap or another
+     *        SetMapBuffer) before it is freed. UpdateCost writes into it.
+     */
+    virtual bool SetMapBuffer(unsigned char* mapdata, int stride);
+
+    /**
+     * \brief same as SetMapBuffer(mapdata, stride) for a map that differs
+     *        from the current one only in changedcells (see SetMap)
+     */
+    virtual bool SetMapBuffer(unsigned char* mapdata, int stride, const std::vector<sbpl_2Dcell_t>& changedcells);
+
     /**
      * \brief this function fill in Predecessor/Successor states of edges whose costs changed
      *        It takes in an array of cells whose traversability changed, and
@@ -404,11 +672,18 @@ public:
 
     /**
      * \brief returns false if robot intersects obstacles or lies outside of
-     *        the map. Note this is pretty expensive operation since it computes the
-     *        footprint of the robot based on its x,y,theta
+     *        the map. Uses the footprint cells precomputed for each theta once
+     *        the environment is initialized
      */
     virtual bool IsValidConfiguration(int X, int Y, int Theta) const;
 
+    /**
+     * \brief checks IsValidConfiguration for each of the configurations, valid
+     *        gets one entry per configuration
+     */
+    virtual void IsValidConfigurations(const std::vector<sbpl_xy_theta_cell_t>& configurations,
+                                       std::vector<bool>* valid) const;
+
     /**
      * \brief returns environment parameters. Useful for creating a copy environment
      */
@@ -483,22 +758,94 @@ public:
 protected:
     virtual int GetActionCost(int SourceX, int SourceY, int SourceTheta, EnvNAVXYTHETALATAction_t* action);
 
+    // sets the cost of every query with GetActionCost, spread over the
+    // action cost threads if there are enough queries. GetActionCost must
+    // only read the environment (and count checks).
+    void GetActionCosts(std::vector<EnvNAVXYTHETALATActionCostQuery_t>* queries);
+
     //member data
     EnvNAVXYTHETALATConfig_t EnvNAVXYTHETALATCfg;
     EnvironmentNAVXYTHETALAT_t EnvNAVXYTHETALAT;
     std::vector<sbpl_xy_theta_cell_t> affectedsuccstatesV; //arrays of states whose outgoing actions cross cell 0,0
     std::vector<sbpl_xy_theta_cell_t> affectedpredstatesV; //arrays of states whose incoming actions cross cell 0,0
+    //the states of affectedsuccstatesV/affectedpredstatesV, used to deduplicate them while they are computed
+    std::unordered_set<sbpl_xy_theta_cell_t, EnvNAVXYTHETALATCellHash> affectedsuccstatesS;
+    std::unordered_set<sbpl_xy_theta_cell_t, EnvNAVXYTHETALATCellHash> affectedpredstatesS;
     int iteration;
+    std::atomic<long int> checks; // number of footprint collision checks, kept per environment for concurrent use
     int blocksize; // 2D block size
     int bucketsize; // 2D bucket size
 
     bool bUseNonUniformAngles;
 
+    // directory of the motion primitive kernel cache, empty if disabled
+    std::string KernelCacheDirectory;
+
+    // set when EnvNAVXYTHETALATCfg.Grid2D is owned by the caller (see SetMapBuffer)
+    bool bExternalGrid2D;
+
+    // owner of EnvNAVXYTHETALATCfg.ActionsV and PredActionsV, shared with the
+    // lattice models made from this environment
+    std::shared_ptr<EnvNAVXYTHETALATActionTable_t> ActionTable;
+
+    // the lattice model that matches the current costmap: the one this
+    // environment searches (see EnvironmentNAVXYTHETALAT::InitializeEnvFromModel)
+    // or the last one made by EnvironmentNAVXYTHETALAT::GetLatticeModel. Any
+    // change of the costmap drops it.
+    mutable std::shared_ptr<const EnvNAVXYTHETALATLatticeModel> LatticeModel;
+    mutable std::mutex LatticeModelMutex;
+
+    // called before the costmap changes
+    void DetachLatticeModel();
+
+    // bit x % 64 of word y * ObstacleMaskStride + x / 64 is set if cell <x,y>
+    // is an obstacle (its cost is at least obsthresh). It follows the changes
+    // made by UpdateCost, SetMap and SetMapBuffer but not writes to an
+    // external costmap buffer. Every row ends with a spare zero word so that
+    // 64 bits can be read starting at any cell of the map.
+    std::vector<unsigned long long> ObstacleMaskV;
+    const unsigned long long* ObstacleMask; // ObstacleMaskV or the mask of LatticeModel, NULL if not computed
+    int ObstacleMaskStride;
+
+    // set when GetActionCost checks the footprint against ObstacleMask (see
+    // the footprint_bitmask parameter)
+    bool bFootprintBitmask;
+
+    void ComputeObstacleMask();
+
+    // set when GetActionCost reduces the costs of the cells with AVX2 gathers
+    // (see the action_cost_simd parameter), on CPUs that support it
+    bool bActionCostSIMD;
+
+    // the threads that help evaluate the action costs of wide expansions and
+    // the minimum number of actions to use them for (see SetActionCostThreads)
+    std::unique_ptr<SBPLWorkerPool> ActionCostWorkers;
+    int ActionCostMinBatch;
+    std::vector<EnvNAVXYTHETALATActionCostQuery_t> ActionCostQueriesV; // scratch of GetSuccs and GetPreds
+
     //2D search for heuristic computations
     bool bNeedtoRecomputeStartHeuristics; //set whenever grid2Dsearchfromstart needs to be re-executed
     bool bNeedtoRecomputeGoalHeuristics; //set whenever grid2Dsearchfromgoal needs to be re-executed
+    // cells whose cost has changed since grid2Dsearchfromstart and
+    // grid2Dsearchfromgoal last ran, the searches are repaired from them
+    // instead of being re-executed (see the incremental_heuristics parameter)
+    bool bIncrementalHeuristics;
+    // set when the 2D searches only run until the start (goal) cell has its
+    // distance and go on from there for the cells the heuristics are asked
+    // for (see the lazy_heuristics parameter)
+    bool bLazyHeuristics;
+    std::vector<sbpl_2Dcell_t> StartHeuristicsChangesV;
+    std::vector<sbpl_2Dcell_t> GoalHeuristicsChangesV;
+
+    // records that the cost of cell <x,y> has changed for the 2D searches
+    void AddHeuristicsChange(int x, int y);
+    // sets Grid2DVersion to the hash of the costmap
+    void HashGrid2D();
     SBPL2DGridSearch* grid2Dsearchfromstart; //computes h-values that estimate distances from start x,y to all cells
     SBPL2DGridSearch* grid2Dsearchfromgoal; //computes h-values that estimate distances to goal x,y from all cells
+    int HeuristicThreads; // the threads grid2Dsearchfromstart and grid2Dsearchfromgoal run on
+    // goal distances shared with other environments (see SetHeuristicCache)
+    std::shared_ptr<SBPL2DGridSearchCache> HeuristicCache;
 
     virtual void ReadConfiguration(FILE* fCfg);
 
@@ -542,9 +889,19 @@ protected:
 
     virtual void ComputeReplanningData();
     virtual void ComputeReplanningDataforAction(EnvNAVXYTHETALATAction_t* action);
+    void AddAffectedStates(const sbpl_xy_theta_cell_t& predcell3d, const sbpl_xy_theta_cell_t& succcell3d);
+
+    unsigned long long ComputeKernelCacheKey(const std::vector<SBPL_xytheta_mprimitive>* motionprimitiveV) const;
+    std::string GetKernelCacheFilename(unsigned long long key) const;
+    bool LoadKernelCache(const std::string& filename, unsigned long long key);
+    bool SaveKernelCache(const std::string& filename, unsigned long long key) const;
+    virtual void ComputeCollisionDataforAction(EnvNAVXYTHETALATAction_t* action);
+    virtual void PrecomputeFootprintCells();
 
     virtual bool ReadMotionPrimitives(FILE* fMotPrims);
+    virtual bool ReadMotionPrimitivesBinary(FILE* fMotPrims);
     virtual bool ReadinMotionPrimitive(SBPL_xytheta_mprimitive* pMotPrim, FILE* fIn);
+    virtual bool CheckMotionPrimitive(const SBPL_xytheta_mprimitive* pMotPrim) const;
     virtual bool ReadinCell(sbpl_xy_theta_cell_t* cell, FILE* fIn);
     virtual bool ReadinPose(sbpl_xy_theta_pt_t* pose, FILE* fIn);
 
@@ -557,12 +914,37 @@ public:
     EnvironmentNAVXYTHETALAT()
     {
         HashTableSize = 0;
+        HashTableCount = 0;
         Coord2StateIDHashTable = NULL;
+        OldHashTableSize = 0;
+        OldHashTableMigrated = 0;
+        OldCoord2StateIDHashTable = NULL;
         Coord2StateIDHashTable_lookup = NULL;
+        LookupTilesX = 0;
+        LookupTilesY = 0;
     }
 
     ~EnvironmentNAVXYTHETALAT();
 
+    /**
+     * \brief returns the read-only lattice model of the environment. It is
+     *        made on the first call and reused until the costmap changes, so
+     *        it costs one copy of the costmap per change. The environment
+     *        must be initialized and must not be changed by another thread
+     *        during the call.
+     */
+    std::shared_ptr<const EnvNAVXYTHETALATLatticeModel> GetLatticeModel() const;
+
+    /**
+     * \brief initializes the environment to search model, e.g. on another
+     *        thread than the other environments searching it. The costmap,
+     *        the actions and their kernels are shared with model instead of
+     *        copied, the states and the heuristics are the environment's own.
+     *        UpdateCost and SetMap give the environment a costmap of its own
+     *        first, the model itself never changes.
+     */
+    virtual bool InitializeEnvFromModel(std::shared_ptr<const EnvNAVXYTHETALATLatticeModel> model);
+
     /**
      * \brief sets start in meters/radians
      */
@@ -681,35 +1063,72 @@ public:
 
     const EnvNAVXYTHETALATHashEntry_t* GetStateEntry(int state_id) const;
 
+    /**
+     * \brief removes all the states but the start and the goal, which get
+     *        stateIDs 0 and 1 again. The memory of the removed states is kept
+     *        and reused. Planners that use the environment have to be
+     *        re-created afterwards.
+     */
+    virtual void ResetStates();
+
     /*
      * Return collision pixels for an action
      */
     virtual void GetCollisionCellsForPrimitive(int SourceTheta, int motprimID, std::vector<sbpl_2Dcell_t>* collisionCells) const;
     /*
-     * Set collision pixels for an action
+     * Set collision pixels for an action (not allowed once the actions are
+     * shared with a lattice model that is still in use, see GetLatticeModel)
      */
     virtual void SetCollisionCellsForPrimitive(int SourceTheta, int motprimID, const std::vector<sbpl_2Dcell_t>& collisionCells);
 
 
 protected:
-    //hash table of size x_size*y_size. Maps from coords to stateId
+    //open-addressing hash table, maps from packed coords to the hash entry.
+    //When it grows, the slots of the previous table are moved over a few at
+    //a time by the following insertions, lookups check both tables meanwhile.
     int HashTableSize;
-    std::vector<EnvNAVXYTHETALATHashEntry_t*>* Coord2StateIDHashTable;
+    int HashTableCount;
+    EnvNAVXYTHETALATHashSlot_t* Coord2StateIDHashTable;
+    int OldHashTableSize;
+    int OldHashTableMigrated;
+    EnvNAVXYTHETALATHashSlot_t* OldCoord2StateIDHashTable;
     //vector that maps from stateID to coords
     std::vector<EnvNAVXYTHETALATHashEntry_t*> StateID2CoordTable;
 
-    EnvNAVXYTHETALATHashEntry_t** Coord2StateIDHashTable_lookup;
+    //lookup table: a directory of LookupTilesX*LookupTilesY tiles, each with
+    //its page of entries indexed by <x, y, theta> inside the tile. Pages are
+    //allocated when the first state inside the tile is created.
+    EnvNAVXYTHETALATHashEntry_t*** Coord2StateIDHashTable_lookup;
+    int LookupTilesX;
+    int LookupTilesY;
+
+    //returns the entry slot of the state in the lookup table, NULL if its page
+    //is not allocated and allocate is false
+    EnvNAVXYTHETALATHashEntry_t** GetLookupSlot(int X, int Y, int Theta, bool allocate);
+
+    //hash entries and StateID2IndexMapping rows of the states, allocated in
+    //chunks of NAVXYTHETALAT_STATECHUNKSIZE states that are never freed before destruction
+    std::vector<EnvNAVXYTHETALATHashEntry_t*> HashEntryChunks;
+    std::vector<int*> StateID2IndexChunks;
+
+    EnvNAVXYTHETALATHashEntry_t* AllocateHashEntry(int X, int Y, int Theta);
+
+    //returns the first slot of the hash table of size tablesize to probe for key
+    unsigned int GETHASHBIN(unsigned long long key, int tablesize) const;
 
-    virtual unsigned int GETHASHBIN(unsigned int X, unsigned int Y, unsigned int Theta);
+    EnvNAVXYTHETALATHashEntry_t* GetHashEntry_hash(int X, int Y, int Theta);
+    EnvNAVXYTHETALATHashEntry_t* CreateNewHashEntry_hash(int X, int Y, int Theta);
+    EnvNAVXYTHETALATHashEntry_t* GetHashEntry_lookup(int X, int Y, int Theta);
+    EnvNAVXYTHETALATHashEntry_t* CreateNewHashEntry_lookup(int X, int Y, int Theta);
 
-    virtual EnvNAVXYTHETALATHashEntry_t* GetHashEntry_hash(int X, int Y, int Theta);
-    virtual EnvNAVXYTHETALATHashEntry_t* CreateNewHashEntry_hash(int X, int Y, int Theta);
-    virtual EnvNAVXYTHETALATHashEntry_t* GetHashEntry_lookup(int X, int Y, int Theta);
-    virtual EnvNAVXYTHETALATHashEntry_t* CreateNewHashEntry_lookup(int X, int Y, int Theta);
+    //use the lookup table if it is allocated and the hash table otherwise
+    EnvNAVXYTHETALATHashEntry_t* GetHashEntry(int X, int Y, int Theta);
+    EnvNAVXYTHETALATHashEntry_t* CreateNewHashEntry(int X, int Y, int Theta);
 
-    //pointers to functions
-    EnvNAVXYTHETALATHashEntry_t* (EnvironmentNAVXYTHETALAT::*GetHashEntry)(int X, int Y, int Theta);
-    EnvNAVXYTHETALATHashEntry_t* (EnvironmentNAVXYTHETALAT::*CreateNewHashEntry)(int X, int Y, int Theta);
+    void InsertHashSlot(EnvNAVXYTHETALATHashSlot_t* table, int tablesize, unsigned long long key,
+                        EnvNAVXYTHETALATHashEntry_t* entry);
+    void GrowHashTable();
+    void MigrateHashSlots(int numslots);
 
     virtual void InitializeEnvironment();
 
@@ -55,6 +55,7 @@
 #include <sbpl/planners/adplanner.h>
 #include <sbpl/planners/ANAplanner.h>
 #include <sbpl/planners/araplanner.h>
+#include <sbpl/planners/batchplanner.h>
 #include <sbpl/planners/mhaplanner.h>
 #include <sbpl/planners/planner.h>
 #include <sbpl/planners/ppcpplanner.h>
@@ -62,6 +63,7 @@
 #include <sbpl/planners/viplanner.h>
 #include <sbpl/planners/lazyARA.h>
 #include <sbpl/utils/2Dgridsearch.h>
+#include <sbpl/utils/deadline.h>
 #include <sbpl/utils/heap.h>
 #include <sbpl/utils/list.h>
 #include <sbpl/utils/key.h>
@@ -71,6 +73,7 @@
 #include <sbpl/utils/sbpl_bfs_2d.h>
 #include <sbpl/utils/sbpl_bfs_3d.h>
 #include <sbpl/utils/utils.h>
+#include <sbpl/utils/workerpool.h>
 
 #endif
 
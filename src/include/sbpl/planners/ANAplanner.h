@@ -12,6 +12,7 @@
 #include <cstdio>
 #include <ctime>
 #include <sbpl/planners/planner.h>
+#include <sbpl/utils/deadline.h>
 #include <sbpl/utils/mdp.h>
 
 //---configuration----
@@ -193,7 +194,7 @@ private:
 
     unsigned int searchexpands;
     int MaxMemoryCounter;
-    clock_t TimeStarted;
+    SBPLDeadline deadline; //started at the beginning of each search
     FILE *fDeb;
 
     void Initialize_searchinfo(CMDPSTATE* state, anaSearchStateSpace_t* pSearchStateSpace);
@@ -33,6 +33,8 @@
 #include <cstdio>
 #include <ctime>
 #include <sbpl/planners/planner.h>
+#include <sbpl/utils/deadline.h>
+#include <sbpl/utils/heap.h>
 #include <sbpl/utils/key.h>
 #include <sbpl/utils/mdp.h>
 
@@ -47,7 +49,6 @@
 //---------------------
 #define AD_INCONS_LIST_ID 0
 
-class CHeap;
 class CList;
 class DiscreteSpaceInformation;
 class MDPConfig;
@@ -111,7 +112,7 @@ typedef struct ADSEARCHSTATESPACE
 {
     double eps;
     double eps_satisfied;
-    CHeap* heap;
+    CDaryHeap* heap;
     CList* inconslist;
     short unsigned int searchiteration;
     short unsigned int callnumber;
@@ -248,9 +249,11 @@ public:
     virtual void get_search_stats(std::vector<PlannerStats>* s);
 
     /**
-     * \brief constructor
+     * \brief constructor, heaparity is the arity of the OPEN heap
+     *        (see CDaryHeap)
      */
-    ADPlanner(DiscreteSpaceInformation* environment, bool bForwardSearch);
+    ADPlanner(DiscreteSpaceInformation* environment, bool bForwardSearch,
+              int heaparity = SBPL_OPEN_HEAP_ARITY);
 
     /**
      * \brief destructor
@@ -269,12 +272,13 @@ protected:
 
     bool bforwardsearch;
     bool bsearchuntilfirstsolution; //if true, then search until first solution (see planner.h for search modes)
+    int heaparity; //arity of the OPEN heap
 
     ADSearchStateSpace_t* pSearchStateSpace_;
 
     unsigned int searchexpands;
     int MaxMemoryCounter;
-    clock_t TimeStarted;
+    SBPLDeadline deadline; //started at the beginning of each search
     FILE *fDeb;
 
     //member functions
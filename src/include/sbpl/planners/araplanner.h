@@ -34,6 +34,8 @@
 #include <ctime>
 #include <vector>
 #include <sbpl/planners/planner.h>
+#include <sbpl/utils/deadline.h>
+#include <sbpl/utils/heap.h>
 #include <sbpl/utils/mdp.h>
 
 //---configuration----
@@ -47,7 +49,6 @@
 //---------------------
 #define ARA_INCONS_LIST_ID 0
 
-class CHeap;
 class CList;
 class DiscreteSpaceInformation;
 class MDPConfig;
@@ -112,7 +113,8 @@ typedef struct ARASEARCHSTATESPACE
 {
     double eps;
     double eps_satisfied;
-    CHeap* heap;
+    CDaryHeap* heap;
+    CBucketHeap* bucketheap; //used for OPEN instead of heap if not NULL
     CList* inconslist;
     short unsigned int searchiteration;
     short unsigned int callnumber;
@@ -192,6 +194,14 @@ public:
      */
     virtual int set_search_mode(bool bSearchUntilFirstSolution);
 
+    /**
+     * \brief selects the data structure used for OPEN: the d-ary heap
+     *        (default) or a bucket queue over the integer f-values (see
+     *        CBucketHeap), which makes insertions and expansions O(1) but
+     *        breaks ties between equal f-values last in first out
+     */
+    virtual void set_OPEN_type(SBPL_OPENTYPE OPENtype);
+
     /**
      * \brief returns the suboptimality bound on the currently found solution
      */
@@ -236,9 +246,11 @@ public:
     double compute_suboptimality();
 
     /**
-     * \brief constructor
+     * \brief constructor, heaparity is the arity of the OPEN heap
+     *        (see CDaryHeap)
      */
-    ARAPlanner(DiscreteSpaceInformation* environment, bool bforwardsearch);
+    ARAPlanner(DiscreteSpaceInformation* environment, bool bforwardsearch,
+               int heaparity = SBPL_OPEN_HEAP_ARITY);
 
     /**
      * \brief destructor
@@ -290,12 +302,14 @@ protected:
     bool bforwardsearch; //if true, then search proceeds forward, otherwise backward
 
     bool bsearchuntilfirstsolution; //if true, then search until first solution only (see planner.h for search modes)
+    int heaparity; //arity of the OPEN heap
+    SBPL_OPENTYPE OPENtype;
 
     ARASearchStateSpace_t* pSearchStateSpace_;
 
     unsigned int searchexpands;
     int MaxMemoryCounter;
-    clock_t TimeStarted;
+    SBPLDeadline deadline; //started at the beginning of each search
     FILE *fDeb;
 
     //member functions
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2008, Maxim Likhachev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Carnegie Mellon University nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __BATCHPLANNER_H_
+#define __BATCHPLANNER_H_
+
+#include <vector>
+#include <sbpl/discrete_space_information/environment_navxythetalat.h>
+#include <sbpl/planners/planner.h>
+
+/**
+ * \brief the outcome of one query of BatchPlanner
+ */
+struct BatchPlanResult
+{
+    //1 if a path was found, 0 if not and -1 if the start or the goal is invalid
+    int status;
+    int cost;
+    double eps; //suboptimality bound of the path
+    double time; //seconds spent on the query
+    int expands;
+    std::vector<sbpl_xy_theta_pt_t> xythetaPath; //with the intermediate poses of the actions
+    std::vector<sbpl_xy_theta_cell_t> xythetaCellPath; //the states after the start
+};
+
+/**
+ * \brief solves many start/goal queries against one environment with ARA*,
+ *        spread over a pool of threads
+ *
+ * Every thread searches the lattice model of the environment (see
+ * EnvironmentNAVXYTHETALAT::GetLatticeModel) through an environment of its
+ * own, which shares the costmap, actions and kernels of the model and keeps
+ * its states and heuristics between the queries it solves within one call to
+ * plan(). The environment must not be changed while plan() gets its model;
+ * changes made in between two calls are seen by the next one.
+ */
+class BatchPlanner
+{
+public:
+    /**
+     * \brief numthreads of 0 uses one thread per hardware thread
+     */
+    BatchPlanner(const EnvironmentNAVXYTHETALAT* environment, bool bforwardsearch, int numthreads = 0);
+
+    /**
+     * \brief plans from starts[i] to goals[i] (in meters/radians) for every
+     *        i, each query with the parameters in params (max_time is per
+     *        query). Once params.cancel_token is cancelled the running
+     *        queries return their best path so far and the others are
+     *        skipped with status 0. Returns the number of paths found.
+     */
+    int plan(const std::vector<sbpl_xy_theta_pt_t>& starts, const std::vector<sbpl_xy_theta_pt_t>& goals,
+             const ReplanParams& params, bool check_collisions, std::vector<BatchPlanResult>* results);
+
+    int getnumthreads() const { return numthreads; }
+
+private:
+    const EnvironmentNAVXYTHETALAT* environment;
+    bool bforwardsearch;
+    int numthreads;
+
+    void planquery(EnvironmentNAVXYTHETALAT* replica, const sbpl_xy_theta_pt_t& start,
+                   const sbpl_xy_theta_pt_t& goal, const ReplanParams& params, bool check_collisions,
+                   BatchPlanResult* result);
+};
+
+#endif
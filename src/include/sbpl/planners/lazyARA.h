@@ -106,7 +106,9 @@ public:
         params.initial_eps = initialsolution_eps;
     }
 
-    LazyARAPlanner(DiscreteSpaceInformation* environment, bool bforwardsearch);
+    // heaparity is the arity of the OPEN heap (see CDaryHeap)
+    LazyARAPlanner(DiscreteSpaceInformation* environment, bool bforwardsearch,
+                   int heaparity = SBPL_OPEN_HEAP_ARITY);
     ~LazyARAPlanner();
 
     virtual void get_search_stats(std::vector<PlannerStats>* s);
@@ -142,7 +144,7 @@ public:
 protected:
 
     // data structures (open and incons lists)
-    CHeap heap;
+    CDaryHeap heap;
     std::vector<LazyARAState*> incons;
     std::vector<LazyARAState*> states;
 
@@ -158,7 +160,7 @@ protected:
     double eps;
     double eps_satisfied;
     int search_expands;
-    clock_t TimeStarted;
+    SBPLDeadline deadline;
     short unsigned int search_iteration;
     short unsigned int replan_number;
     bool use_repair_time;
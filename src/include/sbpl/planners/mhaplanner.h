@@ -32,6 +32,7 @@
 
 #include <sbpl/heuristics/heuristic.h>
 #include <sbpl/planners/planner.h>
+#include <sbpl/utils/deadline.h>
 #include <sbpl/utils/heap.h>
 
 struct MHASearchState
@@ -61,7 +62,8 @@ public:
             DiscreteSpaceInformation* environment,
             Heuristic* hanchor,
             Heuristic** heurs,
-            int hcount);
+            int hcount,
+            int heaparity = SBPL_OPEN_HEAP_ARITY);
 
     virtual ~MHAPlanner();
 
@@ -176,6 +178,7 @@ private:
 
     int m_num_expansions;   ///< current number of expansion
     double m_elapsed;       ///< current amount of seconds
+    SBPLDeadline m_deadline; ///< started at the beginning of each search
 
     int m_call_number;
 
@@ -184,12 +187,15 @@ private:
 
     std::vector<MHASearchState*> m_search_states;
 
-    CHeap* m_open; ///< sequence of (m_hcount + 1) open lists
+    CDaryHeap** m_open; ///< sequence of (m_hcount + 1) open lists
 
     bool check_params(const ReplanParams& params);
 
     bool time_limit_reached() const;
 
+    // runs the search set up by replan
+    int search(std::vector<int>* solution_stateIDs_V, int* solcost);
+
     int num_heuristics() const { return m_hcount + 1; }
     MHASearchState* get_state(int state_id);
     void init_state(MHASearchState* state, size_t mha_state_idx, int state_id);
@@ -201,7 +207,7 @@ private:
     void expand(MHASearchState* state, int hidx);
     MHASearchState* state_from_open_state(AbstractSearchState* open_state);
     int compute_heuristic(int state_id, int hidx);
-    int get_minf(CHeap& pq) const;
+    int get_minf(CDaryHeap& pq) const;
     void insert_or_update(MHASearchState* state, int hidx, int f);
 
     void extract_path(std::vector<int>* solution_path, int* solcost);
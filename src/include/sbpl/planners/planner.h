@@ -71,6 +71,8 @@ class DiscreteSpaceInformation;
  */
 class StateChangeQuery;
 
+class SBPLCancelToken;
+
 /**
  * \brief a parameter class for planners
  */
@@ -89,6 +91,7 @@ public:
         dec_eps = 0.2;
         return_first_solution = false;
         repair_time = -1;
+        cancel_token = NULL;
     }
 
     /**
@@ -130,6 +133,15 @@ public:
      *        longer amount of time (maxTime) to get the first solution. 
      */
     double repair_time;
+
+    /**
+     * \brief if not NULL, the planner polls this token (see
+     *        sbpl/utils/deadline.h) while it searches and stops as if it ran
+     *        out of time once another thread cancels it, also when
+     *        return_first_solution is set. The token is only used for the
+     *        duration of the replan() call. By default this is NULL.
+     */
+    const SBPLCancelToken* cancel_token;
 };
 
 class PlannerStats
@@ -33,6 +33,7 @@
 #include <cstdio>
 #include <ctime>
 #include <sbpl/planners/planner.h>
+#include <sbpl/utils/deadline.h>
 #include <sbpl/utils/heap.h>
 #include <sbpl/utils/key.h>
 #include <sbpl/utils/mdp.h>
@@ -399,7 +400,7 @@ private:
     unsigned int highlevel_searchexpands;
     unsigned int lowlevel_searchexpands;
     int MaxMemoryCounter;
-    clock_t TimeStarted;
+    SBPLDeadline deadline; //started at the beginning of each search
     FILE *fDeb;
 
     //member functions
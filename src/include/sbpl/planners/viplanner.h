@@ -33,6 +33,7 @@
 #include <cstdio>
 #include <ctime>
 #include <sbpl/planners/planner.h>
+#include <sbpl/utils/deadline.h>
 #include <sbpl/utils/mdp.h>
 
 #define MDP_ERRDELTA 0.01
@@ -115,7 +116,7 @@ protected:
 
     virtual void PrintStatHeader(FILE* fOut);
 
-    virtual void PrintStat(FILE* fOut, clock_t starttime);
+    virtual void PrintStat(FILE* fOut, const SBPLDeadline& deadline);
 
     virtual void PrintPolicy(FILE* fPolicy);
 
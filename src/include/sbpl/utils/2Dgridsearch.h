@@ -31,6 +31,12 @@
 #define __2DGRIDSEARCH_H_
 
 #include <cstdlib>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 #include <sbpl/planners/planner.h>
 #include <sbpl/utils/key.h>
 #include <sbpl/utils/utils.h>
@@ -39,9 +45,11 @@
 
 #define SBPL_2DSEARCH_OPEN_LIST_ID 0
 
-// Forward declaration needed to allow instance of CIntHeap*
-class CIntHeap;
-class CSlidingBucket;
+//the smallest bucket whose states SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS
+//expands on all its threads, smaller ones are expanded by the calling thread
+#define SBPL_2DGRIDSEARCH_PARALLELMINBUCKET 256
+
+class SBPLWorkerPool;
 
 enum SBPL_2DGRIDSEARCH_TERM_CONDITION
 {
@@ -49,40 +57,153 @@ enum SBPL_2DGRIDSEARCH_TERM_CONDITION
     SBPL_2DGRIDSEARCH_TERM_CONDITION_20PERCENTOVEROPTPATH,
     SBPL_2DGRIDSEARCH_TERM_CONDITION_TWOTIMESOPTPATH,
     SBPL_2DGRIDSEARCH_TERM_CONDITION_THREETIMESOPTPATH,
-    SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS
+    SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS,
+    //Dijkstra's search (unlike SBPL_2DGRIDSEARCH_TERM_CONDITION_OPTPATHFOUND)
+    //up to the goal, meant to be continued by
+    //SBPL2DGridSearch::getcostfromstart_inmm
+    SBPL_2DGRIDSEARCH_TERM_CONDITION_GOALSETTLED
 };
 
 enum SBPL_2DGRIDSEARCH_OPENTYPE
 {
-    SBPL_2DGRIDSEARCH_OPENTYPE_HEAP, SBPL_2DGRIDSEARCH_OPENTYPE_SLIDINGBUCKETS
+    SBPL_2DGRIDSEARCH_OPENTYPE_HEAP, SBPL_2DGRIDSEARCH_OPENTYPE_SLIDINGBUCKETS,
+    //buckets as wide as the cheapest transition, each expanded at once on the
+    //threads set with SBPL2DGridSearch::setnumthreads
+    SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS
 };
 
 //#define SBPL_2DGRIDSEARCH_HEUR2D(x,y)  ((int)(1000*cellSize_m_*sqrt((double)((x-goalX_)*(x-goalX_)+(y-goalY_)*(y-goalY_)))))
 #define SBPL_2DGRIDSEARCH_HEUR2D(x,y)  ((int)(1000*cellSize_m_*__max(abs(x-goalX_),abs(y-goalY_))))
 
 /**
- * \brief search state corresponding to each 2D cell
+ * \brief OPEN list of SBPL2DGridSearch: a binary heap of (key, cell index)
+ *        pairs. The key of a cell is lowered by inserting it again, the pair
+ *        with the old key stays behind and is skipped by the search.
  */
-class SBPL_2DGridSearchState : public AbstractSearchState
+class SBPL2DGridSearchHeap
 {
 public:
+    typedef std::pair<int, int> entry_t;
+
+    bool emptyheap() const { return heap_.empty(); }
+    int getminheap() const { return heap_.front().second; }
+    int getminkeyheap() const { return heap_.front().first; }
+    void insertheap(int index, int key);
+    int deleteminheap();
+    void makeemptyheap() { heap_.clear(); }
+
     /**
-     * \brief coordinates
+     * \brief all the pairs, in no particular order
      */
-    int x, y;
+    const std::vector<entry_t>& getentries() const { return heap_; }
+
+private:
+    //the pair with the smallest key first
+    std::vector<entry_t> heap_;
+};
+
+/**
+ * \brief OPEN list of SBPL2DGridSearch for keys that span fewer than
+ *        numofbuckets values at a time: the cell indices in a bucket per
+ *        key, with the buckets reused cyclically. The key of a cell is lowered
+ *        by inserting it again, as with SBPL2DGridSearchHeap.
+ */
+class SBPL2DGridSearchBuckets
+{
+public:
+    SBPL2DGridSearchBuckets(int numofbuckets, int initialbucketsize);
+
+    bool empty() const { return numofelements_ == 0; }
+    int getminkey();
+    int getminelement();
+    int popminelement();
+    void insert(int index, int key);
+    void reset();
 
     /**
-     * \brief search relevant data
+     * \brief appends all the (key, cell index) pairs to entries
      */
-    int g;
+    void getentries(std::vector<SBPL2DGridSearchHeap::entry_t>* entries) const;
+
+private:
+    //moves minkey_ to the first bucket that has elements left
+    void recomputemin();
+
+    std::vector<std::vector<int> > buckets_;
+    int initialbucketsize_;
+    //the key of the last popped element (no smaller one can be inserted),
+    //the key of the first bucket with elements and the index of its first
+    //element that has not been popped
+    int firstkey_;
+    int minkey_;
+    size_t minelement_;
+    long numofelements_;
+};
+
+/**
+ * \brief the values of SBPL2DGridSearch searches over all cells, kept for
+ *        reuse by any number of searches (and threads)
+ *
+ * A set of values (a field) is looked up by its start cell and by the
+ * version of the map it was computed on (combined with the parameters of the
+ * search by SBPL2DGridSearch::searchcached). computemapversion() hashes the
+ * contents of a map, so that maps with the same costs share their fields even
+ * across environments. A map that is changed a cell at a time can take a
+ * version from newmapversion() instead, which is unique within the process,
+ * until it is hashed again. The least recently used field is dropped once
+ * there are more than maxfields of them.
+ */
+class SBPL2DGridSearchCache
+{
+public:
+    explicit SBPL2DGridSearchCache(int maxfields);
+
     /**
-     * \brief iteration at which the state was accessed (generated) last
+     * \brief returns a map version that has not been returned before (and is
+     *        never returned by computemapversion)
      */
-    int iterationaccessed;
+    static unsigned long long newmapversion();
 
-public:
-    SBPL_2DGridSearchState() { iterationaccessed = 0; }
-    ~SBPL_2DGridSearchState() { }
+    /**
+     * \brief returns the map version of the width x height costs of Grid2D
+     *        (row-major, stride bytes per row), a 64-bit hash of them
+     */
+    static unsigned long long computemapversion(const unsigned char* Grid2D, int width, int height, int stride);
+
+    /**
+     * \brief returns the values (row-major, one per cell of the search) of
+     *        the search from <x,y> over the map with mapversion or NULL
+     */
+    std::shared_ptr<const std::vector<int> > getfield(unsigned long long mapversion, int x, int y);
+
+    /**
+     * \brief adds the values of the search from <x,y> over the map with mapversion
+     */
+    void addfield(unsigned long long mapversion, int x, int y, const std::shared_ptr<const std::vector<int> >& values);
+
+    /**
+     * \brief drops all the fields
+     */
+    void clear();
+
+    int getnumfields() const;
+    int getmaxfields() const { return maxfields_; }
+
+private:
+    struct Field
+    {
+        unsigned long long mapversion;
+        int x, y;
+        std::shared_ptr<const std::vector<int> > values;
+    };
+
+    int maxfields_;
+    //the most recently used field first
+    std::list<Field> fields_;
+    mutable std::mutex mutex_;
+
+    SBPL2DGridSearchCache(const SBPL2DGridSearchCache&);
+    SBPL2DGridSearchCache& operator=(const SBPL2DGridSearchCache&);
 };
 
 /**
@@ -97,7 +218,7 @@ public:
      * @param height_y grid height
      * @param cellsize_m resolution
      * @param downsample edge length of block in main grid that corresponds to a single cell in this grid
-     * @param initial_dynamic_bucket_size Initial dynamic bucket size, set to 0 for fixed size
+     * @param initial_dynamic_bucket_size Initial size of the sliding buckets, set to 0 for max(1000, width + height)
      */
     SBPL2DGridSearch(int width_x, int height_y, float cellsize_m, int downsample=1, int initial_dynamic_bucket_size=32);
     ~SBPL2DGridSearch()
@@ -112,6 +233,14 @@ public:
      */
     bool setOPENdatastructure(SBPL_2DGRIDSEARCH_OPENTYPE OPENtype);
 
+    /**
+     * \brief the number of threads (the calling one included) the searches
+     *        with SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS expand on
+     */
+    void setnumthreads(int numthreads);
+
+    int getnumthreads() const { return numthreads_; }
+
     /**
      * \brief destroys the search and clears all memory
      */
@@ -126,10 +255,37 @@ public:
      *       start to goal. termination_condition specifies when to stop the search.
      *       In particular, one may specify to run it until OPEN is empty. In this
      *       case, the values of all states will be computed.
+     * \note Grid2D is row-major: the cost of cell <x,y> is Grid2D[y*stride+x].
      */
-    bool search(unsigned char** Grid2D, unsigned char obsthresh, int startx_c, int starty_c, int goalx_c, int goaly_c,
+    bool search(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int startx_c, int starty_c, int goalx_c, int goaly_c,
                 SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition);
 
+    /**
+     * \brief brings the values of the last search up to date after the costs
+     *        of changedcells (cells of Grid2D) have changed, in the manner of
+     *        LPA*: the values that depended on a changed cell are invalidated
+     *        and recomputed from the rest, and the search is continued from
+     *        its OPEN list until termination_condition holds again.
+     * \note Only the values of Dijkstra's searches (any termination condition
+     *       but SBPL_2DGRIDSEARCH_TERM_CONDITION_OPTPATHFOUND) from the same
+     *       start and with the same obsthresh can be repaired, otherwise it
+     *       falls back to search(). The goal may differ from the last one.
+     */
+    bool repair(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int startx_c, int starty_c, int goalx_c,
+                int goaly_c, SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition,
+                const std::vector<sbpl_2Dcell_t>& changedcells);
+
+    /**
+     * \brief computes the values of all the cells
+     *        (SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS) or takes them from
+     *        cache if it has them, in which case they are only copied. New
+     *        values are added to cache. mapversion identifies the costs of
+     *        Grid2D (see SBPL2DGridSearchCache), the fields are also told
+     *        apart by obsthresh, the downsampling and the cell size.
+     */
+    bool searchcached(SBPL2DGridSearchCache* cache, unsigned long long mapversion, const unsigned char* Grid2D,
+                      int stride, unsigned char obsthresh, int startx_c, int starty_c, int goalx_c, int goaly_c);
+
     /**
      * \brief print all the values
      */
@@ -147,20 +303,28 @@ public:
             int h = SBPL_2DGRIDSEARCH_HEUR2D(x,y);
             //the logic is that if s wasn't expanded, then g(s) + h(s) >=
             //maxcomputed_fval => g(s) >= maxcomputed_fval - h(s)
-            return ((searchStates2D_[x][y].iterationaccessed == iteration_ &&
-                    searchStates2D_[x][y].g + h <= largestcomputedoptf_)      ? searchStates2D_[x][y].g :
-                    largestcomputedoptf_ < INFINITECOST                       ? largestcomputedoptf_ - h :
-                                                                                INFINITECOST);
+            int g = getg(getcellindex(x, y));
+            return ((g + h <= largestcomputedoptf_)     ? g :
+                    largestcomputedoptf_ < INFINITECOST ? largestcomputedoptf_ - h :
+                                                          INFINITECOST);
         }
         else {
             //Dijkstra's search
             //the logic is that if s wasn't expanded, then g(s) >= maxcomputed_fval => g(s) >= maxcomputed_fval - h(s)
-            return ((searchStates2D_[x][y].iterationaccessed == iteration_ &&
-                    searchStates2D_[x][y].g <= largestcomputedoptf_) ? searchStates2D_[x][y].g :
-                    largestcomputedoptf_);
+            return __min(getg(getcellindex(x, y)), largestcomputedoptf_);
         }
     }
 
+    /**
+     * \brief returns the distance from the start to <x,y>, continuing the
+     *        last Dijkstra's search (or repair) as far as it takes to compute
+     *        it. Grid2D has to hold the costs the last search ran with. The
+     *        values of heuristic searches
+     *        (SBPL_2DGRIDSEARCH_TERM_CONDITION_OPTPATHFOUND) are not
+     *        continued, getlowerboundoncostfromstart_inmm is returned for them.
+     */
+    int getcostfromstart_inmm(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int x, int y);
+
     /**
      * \brief returns largest optimal g-value computed by search - a lower
      *        bound on the state values of unexpanded states
@@ -173,27 +337,59 @@ private:
         return (x >= 0 && y >= 0 && x < width_ && y < height_);
     }
 
+    //the index of cell <x,y> in g_: the cells are kept in blocks of 8x8, row
+    //by row within a block and the blocks row by row
+    inline int getcellindex(int x, int y)
+    {
+        return ((((y >> 3) * widthinblocks_ + (x >> 3)) << 6) | ((y & 7) << 3) | (x & 7));
+    }
+    inline int getcellx(int index) { return ((((index >> 6) % widthinblocks_) << 3) | (index & 7)); }
+    inline int getcelly(int index) { return ((((index >> 6) / widthinblocks_) << 3) | ((index >> 3) & 7)); }
+
+    //the g-value of a cell, INFINITECOST unless the current search has set it
+    inline int getg(int index)
+    {
+        return (blockiteration_[index >> 6] == iteration_) ? g_[index].load(std::memory_order_relaxed) :
+                                                             INFINITECOST;
+    }
+    inline void setg(int index, int g)
+    {
+        if (blockiteration_[index >> 6] != iteration_) initializeblock(index >> 6);
+        g_[index].store(g, std::memory_order_relaxed);
+    }
+
     void computedxy();
-    inline void initializeSearchState2D(SBPL_2DGridSearchState* state2D);
-    bool createSearchStates2D(void);
+    float computetermfactor(SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition);
+    void initializeblock(int block);
+    inline void dropstaleOPENentries(bool usehvalues);
+    inline int computeedgecost(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int x, int y, int dir);
+    inline int computebestcostfromknown(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int index,
+                                        int largestknownf);
+    inline void expandstateinheap(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int index);
+    int takeOPENstates(std::vector<int>* openstates);
+    bool createSearchGrid2D(void);
 
     /// Pointer to getCost function appropriate for resample size
-    unsigned char (*getCost)(unsigned char**, int, int, int);
+    unsigned char (*getCost)(const unsigned char*, int, int, int, int);
 
-    bool search_withheap(unsigned char** Grid2D, unsigned char obsthresh, int startx_c, int starty_c, int goalx_c,
+    bool search_withheap(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int startx_c, int starty_c, int goalx_c,
                          int goaly_c, SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition);
-    bool search_exp(unsigned char** Grid2D, unsigned char obsthresh, int startx_c, int starty_c, int goalx_c,
-                    int goaly_c);
-    bool search_withbuckets(unsigned char** Grid2D, unsigned char obsthresh, int startx_c, int starty_c, int goalx_c,
-                            int goaly_c);
-    bool search_withslidingbuckets(unsigned char** Grid2D, unsigned char obsthresh, int startx_c, int starty_c,
+    bool search_withslidingbuckets(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int startx_c, int starty_c,
                                    int goalx_c, int goaly_c, SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition);
+    bool search_withparallelbuckets(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int startx_c,
+                                    int starty_c, int goalx_c, int goaly_c,
+                                    SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition);
 
     //2D search data
     int initial_dynamic_bucket_size_;
-    CSlidingBucket* OPEN2DBLIST_;
-    CIntHeap* OPEN2D_;
-    SBPL_2DGridSearchState** searchStates2D_;
+    SBPL2DGridSearchBuckets* OPEN2DBLIST_;
+    SBPL2DGridSearchHeap OPEN2D_;
+    //the g-values of the cells (see getcellindex) and the search iteration
+    //at which each block of them was set last, the g-values of a block from
+    //an earlier iteration are all INFINITECOST (see getg)
+    std::atomic<int>* g_;
+    int* blockiteration_;
+    int widthinblocks_, heightinblocks_;
     int dx_[SBPL_2DGRIDSEARCH_NUMOF2DDIRS];
     int dy_[SBPL_2DGRIDSEARCH_NUMOF2DDIRS];
     //the intermediate cells through which the actions go 
@@ -208,6 +404,10 @@ private:
     //OPEN data structure type
     SBPL_2DGRIDSEARCH_OPENTYPE OPENtype_;
 
+    //the threads of the parallel search
+    int numthreads_;
+    SBPLWorkerPool* workers_;
+
     //start and goal configurations
     int startX_, startY_;
     int goalX_, goalY_;
@@ -227,6 +427,15 @@ private:
 
     //termination criterion used in the search
     SBPL_2DGRIDSEARCH_TERM_CONDITION term_condition_usedlast;
+
+    //set when the values of the last search can be repaired, with the
+    //obstacle threshold it used
+    bool repairable_;
+    unsigned char obsthreshusedlast_;
+
+    //set when the OPEN list of the last search is in OPEN2D_ (otherwise it is
+    //in OPEN2DBLIST_)
+    bool openinheap_;
 };
 
 #endif
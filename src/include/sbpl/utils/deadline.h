@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2008, Maxim Likhachev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Carnegie Mellon University nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __DEADLINE_H_
+#define __DEADLINE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+//the number of calls to SBPLDeadline::expired() between two reads of the clock
+#define SBPL_DEADLINE_CHECKINTERVAL 16
+
+/**
+ * \brief a flag another thread can raise to stop a planning call early
+ *
+ * It is passed to the planners through ReplanParams::cancel_token. A search
+ * that sees it raised stops as if its time had run out and returns the best
+ * solution it has so far. The token stays raised until reset(), so it can be
+ * raised before replan() is called.
+ */
+class SBPLCancelToken
+{
+public:
+    SBPLCancelToken() : flag(false) { }
+
+    /**
+     * \brief asks the planning calls that poll this token to stop, safe to
+     *        call from any thread
+     */
+    void cancel() { flag.store(true, std::memory_order_relaxed); }
+
+    /**
+     * \brief lowers the flag so that the token can be reused
+     */
+    void reset() { flag.store(false, std::memory_order_relaxed); }
+
+    bool cancelled() const { return flag.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> flag;
+
+    SBPLCancelToken(const SBPLCancelToken&);
+    SBPLCancelToken& operator=(const SBPLCancelToken&);
+};
+
+/**
+ * \brief the time budget of a planning call, measured on the monotonic wall
+ *        clock
+ *
+ * clock() counts the processor time of the whole process, which runs ahead of
+ * the elapsed time while other threads are busy and behind it while the
+ * planner is descheduled, so all the planners time their searches with this
+ * instead. expired() is meant to be called once per expansion and only reads
+ * the clock every SBPL_DEADLINE_CHECKINTERVAL calls.
+ */
+class SBPLDeadline
+{
+public:
+    SBPLDeadline() : canceltoken(NULL)
+    {
+        start();
+    }
+
+    /**
+     * \brief makes expired() also return true once token is cancelled (NULL
+     *        detaches the current token), start() keeps the token
+     */
+    void setcanceltoken(const SBPLCancelToken* token) { canceltoken = token; }
+
+    /**
+     * \brief returns true if the attached token has been cancelled
+     */
+    bool cancelled() const { return canceltoken != NULL && canceltoken->cancelled(); }
+
+    /**
+     * \brief restarts the clock
+     */
+    void start()
+    {
+        starttime = std::chrono::steady_clock::now();
+        elapsedsecs = 0;
+        calls = 0;
+    }
+
+    /**
+     * \brief returns the seconds since start()
+     */
+    double getelapsedsecs() const
+    {
+        elapsedsecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - starttime).count();
+        calls = 0;
+        return elapsedsecs;
+    }
+
+    /**
+     * \brief returns true once allocatedsecs have passed since start() or
+     *        the token is cancelled, in between two reads of the clock the
+     *        last reading is used (the token is checked on every call)
+     */
+    bool expired(double allocatedsecs) const
+    {
+        if (cancelled()) {
+            return true;
+        }
+        if (++calls >= SBPL_DEADLINE_CHECKINTERVAL) {
+            getelapsedsecs();
+        }
+        return elapsedsecs >= allocatedsecs;
+    }
+
+private:
+    std::chrono::steady_clock::time_point starttime;
+    const SBPLCancelToken* canceltoken;
+    mutable double elapsedsecs;
+    mutable int calls;
+};
+
+#endif
@@ -30,6 +30,7 @@
 #ifndef __HEAP_H_
 #define __HEAP_H_
 
+#include <vector>
 #include <sbpl/planners/planner.h>
 #include <sbpl/utils/key.h>
 
@@ -37,6 +38,30 @@
 #define HEAPSIZE 20000000 
 #define HEAPSIZE_INIT 5000
 
+//the arity of the OPEN lists of ARA*, AD*, MHA* and LazyARA unless given to
+//their constructors; 2 orders the states exactly like the binary CHeap
+#ifndef SBPL_OPEN_HEAP_ARITY
+#define SBPL_OPEN_HEAP_ARITY 2
+#endif
+
+//the largest arity supported by CDaryHeap
+#define DARYHEAP_MAXARITY 16
+//alignment (in bytes) of the groups of siblings in CDaryHeap
+#define DARYHEAP_ALIGNMENT 64
+
+//the number of buckets CBucketHeap starts with and the default largest
+//number it grows to (both have to be powers of two)
+#define BUCKETHEAP_MINNUMBUCKETS 256
+#define BUCKETHEAP_NUMBUCKETS 65536
+
+/**
+ * \brief the data structures a planner can use for OPEN
+ */
+enum SBPL_OPENTYPE
+{
+    SBPL_OPENTYPE_HEAP, SBPL_OPENTYPE_BUCKETQUEUE
+};
+
 struct HEAPELEMENT
 {
     AbstractSearchState *heapstate;
@@ -87,6 +112,174 @@ private:
     void sizecheck();
 };
 
+/**
+ * \brief a d-ary heap with the same interface as CHeap
+ *
+ * The states and the keys are kept in separate arrays laid out so that the
+ * children of an element are next to each other on as few cache lines as
+ * possible, and only the first keysize entries of each key are stored and
+ * compared (planners that order OPEN by f alone pass 1). The arity has to be
+ * a power of two; an arity of 2 gives the same order as CHeap.
+ */
+class CDaryHeap
+{
+    //data
+public:
+    int percolates; //for counting purposes
+    int currentsize;
+    int allocated;
+
+    //constructors
+public:
+    CDaryHeap(int arity = SBPL_OPEN_HEAP_ARITY, int keysize = KEY_SIZE);
+    ~CDaryHeap();
+
+    //functions
+public:
+    bool emptyheap();
+    bool fullheap();
+    bool inheap(AbstractSearchState *AbstractSearchState);
+    CKey getkeyheap(AbstractSearchState *AbstractSearchState);
+    void makeemptyheap();
+    void insertheap(AbstractSearchState *AbstractSearchState, CKey key);
+    void deleteheap(AbstractSearchState *AbstractSearchState);
+    void updateheap(AbstractSearchState *AbstractSearchState, CKey NewKey);
+    AbstractSearchState *getminheap();
+    AbstractSearchState *getminheap(CKey& ReturnKey);
+    CKey getminkeyheap();
+    AbstractSearchState *deleteminheap();
+    void makeheap();
+    void insert_unsafe(AbstractSearchState* state, CKey key);
+    void updateheap_unsafe(AbstractSearchState* AbstractSearchState, CKey NewKey);
+    void deleteheap_unsafe(AbstractSearchState* AbstractSearchState);
+
+    int getarity() const { return 1 << aritylog; }
+    int getkeysize() const { return keysize; }
+
+    /**
+     * \brief returns the state at index (1 to currentsize) of the heap array
+     */
+    AbstractSearchState *getstateheap(int index) { return states[index]; }
+
+    /**
+     * \brief sets the key of the state at index without reordering the heap,
+     *        makeheap() has to be called once all the keys are set
+     */
+    void setkeyheap_unsafe(int index, CKey key);
+
+private:
+    int aritylog; //arity = 1 << aritylog
+    int keysize;
+    char* statesbuffer;
+    char* keysbuffer;
+    AbstractSearchState** states;
+    long int* keys; //keysize entries per element
+
+    template <int KEYSIZE>
+    void percolatedown(int hole, AbstractSearchState* state, const long int* key);
+    template <int KEYSIZE>
+    void percolateup(int hole, AbstractSearchState* state, const long int* key);
+    void percolatedown(int hole, AbstractSearchState* state, const long int* key);
+    void percolateup(int hole, AbstractSearchState* state, const long int* key);
+    void percolateupordown(int hole, AbstractSearchState* state, const long int* key);
+
+    bool keyless(const long int* key1, const long int* key2) const;
+    CKey getkey(int index) const;
+    void allocate(int size);
+    void growheap();
+    void sizecheck();
+};
+
+struct BUCKETHEAPELEMENT
+{
+    AbstractSearchState *heapstate;
+    long int key;
+    int bucketindex; //index within its bucket (or within the overflow)
+};
+
+typedef struct BUCKETHEAPELEMENT bucketheapelement;
+
+/**
+ * \brief a bucket queue ordered by the integer key[0] with the same interface
+ *        as CDaryHeap, insert and update are O(1) and deletemin is amortized
+ *        O(1) as long as the keys in OPEN span less than numofbuckets
+ *
+ * Every key in the window [windowstart, windowstart + numofbuckets) has its
+ * own bucket, larger keys are kept unordered in an overflow that is spread
+ * into the buckets once they run empty. The buckets are doubled, up to
+ * maxnumofbuckets, while the keys in OPEN span more than the window. Keys do
+ * not have to be monotone (the successors of a state expanded with eps > 1 can
+ * have smaller keys than it), a key below the window moves the window and
+ * reinserts all the elements.
+ * States with equal keys are returned last in first out and the other
+ * entries of the keys are not stored (getkeyheap() returns them as 0).
+ */
+class CBucketHeap
+{
+    //data
+public:
+    int currentsize;
+
+    //constructors
+public:
+    CBucketHeap(int maxnumofbuckets = BUCKETHEAP_NUMBUCKETS);
+    ~CBucketHeap();
+
+    //functions
+public:
+    bool emptyheap();
+    bool fullheap();
+    bool inheap(AbstractSearchState *AbstractSearchState);
+    CKey getkeyheap(AbstractSearchState *AbstractSearchState);
+    void makeemptyheap();
+    void insertheap(AbstractSearchState *AbstractSearchState, CKey key);
+    void deleteheap(AbstractSearchState *AbstractSearchState);
+    void updateheap(AbstractSearchState *AbstractSearchState, CKey NewKey);
+    AbstractSearchState *getminheap();
+    AbstractSearchState *getminheap(CKey& ReturnKey);
+    CKey getminkeyheap();
+    AbstractSearchState *deleteminheap();
+    void makeheap();
+
+    int getnumofbuckets() const { return numofbuckets; }
+
+    /**
+     * \brief returns the state at index (1 to currentsize), the order is
+     *        arbitrary
+     */
+    AbstractSearchState *getstateheap(int index) { return elements[index].heapstate; }
+
+    /**
+     * \brief sets the key of the state at index without moving it to its
+     *        bucket, makeheap() has to be called once all the keys are set
+     */
+    void setkeyheap_unsafe(int index, CKey key) { elements[index].key = key.key[0]; }
+
+private:
+    int numofbuckets;
+    int maxnumofbuckets;
+    std::vector<std::vector<int> > buckets; //indices into elements, key K is in bucket K & (numofbuckets - 1)
+    std::vector<int> overflow; //indices into elements with keys past the window
+    std::vector<bucketheapelement> elements; //element 0 is unused as in CHeap
+    long int windowstart;
+    long int minkey; //no bucket below this key is used
+    int bucketedsize; //number of elements in the buckets
+
+    std::vector<int>& getbucket(long int key) { return buckets[key & (numofbuckets - 1)]; }
+    std::vector<int>& getcontainer(long int key)
+    {
+        return key >= windowstart + numofbuckets ? overflow : getbucket(key);
+    }
+    void place(int index);
+    void unplace(int index);
+    void removeelement(int index);
+    void setwindow(long int key);
+    void clearbuckets();
+    void rebuild(long int lowestkey);
+    void growbuckets();
+    bool findmin();
+};
+
 struct HEAPINTELEMENT
 {
     AbstractSearchState *heapstate;
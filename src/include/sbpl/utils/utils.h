@@ -302,6 +302,14 @@ void get_2d_footprint_cells(std::vector<sbpl_2Dpt_t> polygon, std::vector<sbpl_2
 void get_2d_footprint_cells(std::vector<sbpl_2Dpt_t> polygon, std::set<sbpl_2Dcell_t>* cells, sbpl_xy_theta_pt_t pose,
                             double res);
 
+/**
+ * \brief appends to changedcells every cell <x,y> whose cost differs between
+ *        the two row-major maps (cell <x,y> is at map[y*stride+x]). Rows are
+ *        compared 16 cells at a time with SSE2 if available.
+ */
+void get_changed_cells(const unsigned char* oldmap, int oldstride, const unsigned char* newmap, int newstride,
+                       int width, int height, std::vector<sbpl_2Dcell_t>* changedcells);
+
 void writePlannerStats(std::vector<PlannerStats> s, FILE* fout);
 
 #if 0
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2008, Maxim Likhachev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Carnegie Mellon University nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __WORKERPOOL_H_
+#define __WORKERPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//the number of times an idle worker checks for a new job before it sleeps
+#define SBPL_WORKERPOOL_SPINCOUNT 20000
+
+/**
+ * \brief a few threads that run short parallel loops for the thread that owns
+ *        the pool
+ *
+ * It is meant for work that is too small to start threads for, e.g. the
+ * action costs of a single expansion: the workers keep polling for the next
+ * loop for a while after finishing one, so back to back loops do not pay for
+ * waking them up. Idle workers that waited SBPL_WORKERPOOL_SPINCOUNT polls go
+ * to sleep until the next loop.
+ */
+class SBPLWorkerPool
+{
+public:
+    /**
+     * \brief starts numworkers threads, run() uses them in addition to the
+     *        calling thread
+     */
+    explicit SBPLWorkerPool(int numworkers);
+    ~SBPLWorkerPool();
+
+    int getnumworkers() const { return (int)workers.size(); }
+
+    /**
+     * \brief calls fn(i) for every i in [0, n) on the workers and the calling
+     *        thread and returns once all the calls are done. The first
+     *        exception thrown by fn is rethrown after that. Only one thread
+     *        may call run() at a time.
+     */
+    void run(int n, const std::function<void(int)>& fn);
+
+private:
+    std::vector<std::thread> workers;
+
+    //the job of the current run(), only taken under mutex and NULL once the
+    //loop is finished so that late workers can not pick it up
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    const std::function<void(int)>* job;
+    int jobsize;
+    int numsleeping;
+    bool bstop;
+    std::exception_ptr error;
+
+    std::atomic<unsigned int> generation; //incremented by every run()
+    std::atomic<int> next; //next index of the loop to call
+    std::atomic<int> done; //calls of the loop finished
+    std::atomic<int> active; //workers that took the job and still use it
+
+    void work();
+    void runjob(const std::function<void(int)>& fn, int n);
+
+    SBPLWorkerPool(const SBPLWorkerPool&);
+    SBPLWorkerPool& operator=(const SBPLWorkerPool&);
+};
+
+#endif
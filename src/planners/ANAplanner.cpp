@@ -338,8 +338,7 @@ int anaPlanner::ImprovePath(anaSearchStateSpace_t* pSearchStateSpace, double Max
     //expand states until done
     minkey.key[0] = -(pSearchStateSpace->heap->getminkeyheap().key[0]);
     CKey oldkey = minkey;
-    while (!pSearchStateSpace->heap->emptyheap() &&
-           (clock() - TimeStarted) < MaxNumofSecs * (double)CLOCKS_PER_SEC)
+    while (!pSearchStateSpace->heap->emptyheap() && !deadline.expired(MaxNumofSecs))
            //&& goalkey > minkey && minkey.key[0] <= INFINITECOST
     {
         /*if(minkey.key[0] < 10) {
@@ -354,7 +353,7 @@ int anaPlanner::ImprovePath(anaSearchStateSpace_t* pSearchStateSpace, double Max
             pSearchStateSpace->G = state->g;
             //minkey.key[0] =
             //printf("search exited with a solution for eps=%.3f\n", pSearchStateSpace->eps);
-            //printf("eps=%f time_elapsed=%.3f\n", pSearchStateSpace->eps, double(clock()-TimeStarted)/CLOCKS_PER_SEC);
+            //printf("eps=%f time_elapsed=%.3f\n", pSearchStateSpace->eps, deadline.getelapsedsecs());
 
             searchexpands += expands;
             return 1;// so that it does not declare it as run out of time
@@ -366,7 +365,7 @@ int anaPlanner::ImprovePath(anaSearchStateSpace_t* pSearchStateSpace, double Max
         if (e_val < pSearchStateSpace->eps) { // && e_val>=ana_FINAL_EPS
             pSearchStateSpace->eps = minkey.key[0];
             //if(save - e_val > 0.01)
-            //printf("eps=%f time_elapsed=%.6f\n", pSearchStateSpace->eps, double(clock()-TimeStarted)/CLOCKS_PER_SEC);
+            //printf("eps=%f time_elapsed=%.6f\n", pSearchStateSpace->eps, deadline.getelapsedsecs());
         }
 
 #if DEBUG
@@ -445,7 +444,7 @@ int anaPlanner::ImprovePath(anaSearchStateSpace_t* pSearchStateSpace, double Max
         retv = 0;
     }
     else {
-        //printf("eps=%.3f time=%.3f\n", pSearchStateSpace->eps, double(clock() - TimeStarted)/CLOCKS_PER_SEC);
+        //printf("eps=%.3f time=%.3f\n", pSearchStateSpace->eps, deadline.getelapsedsecs());
         retv = 3;
     }
 
@@ -860,7 +859,7 @@ vector<int> anaPlanner::GetSearchPath(anaSearchStateSpace_t* pSearchStateSpace,
 bool anaPlanner::Search(anaSearchStateSpace_t* pSearchStateSpace, vector<int>& pathIds, int & PathCost,
                         bool bFirstSolution, bool bOptimalSolution, double MaxNumofSecs)
 {
-    TimeStarted = clock();
+    deadline.start();
     searchexpands = 0;
 
 #if DEBUG
@@ -885,13 +884,13 @@ bool anaPlanner::Search(anaSearchStateSpace_t* pSearchStateSpace, vector<int>& p
 
     //the main loop of ana*
     int prevexpands = 0;
-    clock_t loop_time;
+    double loop_time;
 
     // CHANGE MADE TO WHILE LOOP to account for open.empty() == FALSE
     while (!pSearchStateSpace->heap->emptyheap() && pSearchStateSpace->eps_satisfied > ana_FINAL_EPS &&
-           (clock() - TimeStarted) < MaxNumofSecs * (double)CLOCKS_PER_SEC)
+           deadline.getelapsedsecs() < MaxNumofSecs)
     {
-        loop_time = clock();
+        loop_time = deadline.getelapsedsecs();
         //decrease eps for all subsequent iterations
         /*if(fabs(pSearchStateSpace->eps_satisfied - pSearchStateSpace->eps) < ERR_EPS && !bFirstSolution)
          {
@@ -922,7 +921,7 @@ bool anaPlanner::Search(anaSearchStateSpace_t* pSearchStateSpace, vector<int>& p
         anaState* state;
         CKey key;
         CHeap* open = pSearchStateSpace->heap;
-        //printf("states expanded: %d\t states considered: %d\t time elapsed: %f\n",searchexpands - prevexpands, pSearchStateSpace->heap->currentsize, double(clock() - TimeStarted)/CLOCKS_PER_SEC);
+        //printf("states expanded: %d\t states considered: %d\t time elapsed: %f\n",searchexpands - prevexpands, pSearchStateSpace->heap->currentsize, deadline.getelapsedsecs());
 
         double epsprime = 1.0;
         for (int j = 1; j <= open->currentsize;) {
@@ -949,7 +948,7 @@ bool anaPlanner::Search(anaSearchStateSpace_t* pSearchStateSpace, vector<int>& p
 
 #if DEBUG
         fprintf(fDeb, "eps=%f expands=%d g(searchgoal)=%d time=%.3f\n", pSearchStateSpace->eps_satisfied, searchexpands - prevexpands,
-            ((anaState*)pSearchStateSpace->searchgoalstate->PlannerSpecificData)->g,double(clock()-loop_time)/CLOCKS_PER_SEC);
+            ((anaState*)pSearchStateSpace->searchgoalstate->PlannerSpecificData)->g,deadline.getelapsedsecs() - loop_time);
         PrintSearchState((anaState*)pSearchStateSpace->searchgoalstate->PlannerSpecificData, fDeb);
 #endif
         prevexpands = searchexpands;
@@ -40,11 +40,12 @@ using namespace std;
 
 //-----------------------------------------------------------------------------------------------------
 
-ADPlanner::ADPlanner(DiscreteSpaceInformation* environment, bool bForwardSearch)
+ADPlanner::ADPlanner(DiscreteSpaceInformation* environment, bool bForwardSearch, int heaparity)
 {
     environment_ = environment;
 
     bforwardsearch = bForwardSearch;
+    this->heaparity = heaparity;
 
     bsearchuntilfirstsolution = false;
     finitial_eps = AD_DEFAULT_INITIAL_EPS;
@@ -494,9 +495,8 @@ int ADPlanner::ComputePath(ADSearchStateSpace_t* pSearchStateSpace, double MaxNu
     CKey oldkey = minkey;
     while (!pSearchStateSpace->heap->emptyheap() && minkey.key[0] < INFINITECOST &&
            (goalkey > minkey || searchgoalstate->g > searchgoalstate->v) &&
-           (clock() - TimeStarted) < MaxNumofSecs * (double)CLOCKS_PER_SEC &&
-               (pSearchStateSpace->eps_satisfied == INFINITECOST ||
-               (clock() - TimeStarted) < repair_time * (double)CLOCKS_PER_SEC))
+           !deadline.expired(MaxNumofSecs) &&
+               (pSearchStateSpace->eps_satisfied == INFINITECOST || !deadline.expired(repair_time)))
     {
         //get the state
         state = (ADState*)pSearchStateSpace->heap->deleteminheap();
@@ -623,7 +623,7 @@ void ADPlanner::BuildNewOPENList(ADSearchStateSpace_t* pSearchStateSpace)
 {
     ADState *state;
     CKey key;
-    CHeap* pheap = pSearchStateSpace->heap;
+    CDaryHeap* pheap = pSearchStateSpace->heap;
     CList* pinconslist = pSearchStateSpace->inconslist;
 
     //move incons into open
@@ -649,7 +649,7 @@ void ADPlanner::Reevaluatefvals(ADSearchStateSpace_t* pSearchStateSpace)
 {
     CKey key;
     int i;
-    CHeap* pheap = pSearchStateSpace->heap;
+    CDaryHeap* pheap = pSearchStateSpace->heap;
 
 #if DEBUG
     SBPL_FPRINTF(fDeb, "re-computing heap priorities\n");
@@ -657,8 +657,8 @@ void ADPlanner::Reevaluatefvals(ADSearchStateSpace_t* pSearchStateSpace)
 
     //recompute priorities for states in OPEN and reorder it
     for (i = 1; i <= pheap->currentsize; ++i) {
-        ADState* state = (ADState*)pheap->heap[i].heapstate;
-        pheap->heap[i].key = ComputeKey(state);
+        ADState* state = (ADState*)pheap->getstateheap(i);
+        pheap->setkeyheap_unsafe(i, ComputeKey(state));
     }
     pheap->makeheap();
 
@@ -680,9 +680,9 @@ void ADPlanner::Reevaluatehvals(ADSearchStateSpace_t* pSearchStateSpace)
 int ADPlanner::CreateSearchStateSpace(ADSearchStateSpace_t* pSearchStateSpace)
 {
     //create a heap
-    pSearchStateSpace->heap = new CHeap;
+    pSearchStateSpace->heap = new CDaryHeap(heaparity, KEY_SIZE);
     pSearchStateSpace->inconslist = new CList;
-    MaxMemoryCounter += sizeof(CHeap);
+    MaxMemoryCounter += sizeof(CDaryHeap);
     MaxMemoryCounter += sizeof(CList);
 
     pSearchStateSpace->searchgoalstate = NULL;
@@ -1092,7 +1092,7 @@ bool ADPlanner::Search(ADSearchStateSpace_t* pSearchStateSpace, vector<int>& pat
                        bool bFirstSolution, bool bOptimalSolution, double MaxNumofSecs)
 {
     CKey key;
-    TimeStarted = clock();
+    deadline.start();
     searchexpands = 0;
     double old_repair_time = repair_time;
     if (!use_repair_time) repair_time = MaxNumofSecs;
@@ -1126,13 +1126,14 @@ bool ADPlanner::Search(ADSearchStateSpace_t* pSearchStateSpace, vector<int>& pat
     //the main loop of AD*
     stats.clear();
     int prevexpands = 0;
-    clock_t loop_time;
+    double loop_time;
     while (pSearchStateSpace->eps_satisfied > final_epsilon &&
-           (clock() - TimeStarted) < MaxNumofSecs * (double)CLOCKS_PER_SEC &&
+           !deadline.cancelled() &&
+           deadline.getelapsedsecs() < MaxNumofSecs &&
                (pSearchStateSpace->eps_satisfied == INFINITECOST ||
-               (clock() - TimeStarted) < repair_time * (double)CLOCKS_PER_SEC))
+               deadline.getelapsedsecs() < repair_time))
     {
-        loop_time = clock();
+        loop_time = deadline.getelapsedsecs();
         //it will be a new search iteration
         if (pSearchStateSpace->searchiteration == 0) pSearchStateSpace->searchiteration++;
 
@@ -1163,7 +1164,7 @@ bool ADPlanner::Search(ADSearchStateSpace_t* pSearchStateSpace, vector<int>& pat
                     ((ADState*)pSearchStateSpace->searchgoalstate->PlannerSpecificData)->g);
 
         if (pSearchStateSpace->eps_satisfied == finitial_eps && pSearchStateSpace->eps == finitial_eps) {
-            finitial_eps_planning_time = double(clock() - loop_time) / CLOCKS_PER_SEC;
+            finitial_eps_planning_time = deadline.getelapsedsecs() - loop_time;
             num_of_expands_initial_solution = searchexpands - prevexpands;
         }
 
@@ -1171,7 +1172,7 @@ bool ADPlanner::Search(ADSearchStateSpace_t* pSearchStateSpace, vector<int>& pat
             PlannerStats tempStat;
             tempStat.eps = pSearchStateSpace->eps_satisfied;
             tempStat.expands = searchexpands - prevexpands;
-            tempStat.time = double(clock() - loop_time) / CLOCKS_PER_SEC;
+            tempStat.time = deadline.getelapsedsecs() - loop_time;
             tempStat.cost = ((ADState*)pSearchStateSpace->searchgoalstate->PlannerSpecificData)->g;
             stats.push_back(tempStat);
         }
@@ -1214,9 +1215,9 @@ bool ADPlanner::Search(ADSearchStateSpace_t* pSearchStateSpace, vector<int>& pat
         ret = true;
     }
 
-    SBPL_PRINTF("total expands this call = %d, planning time = %.3f secs, solution cost=%d\n", searchexpands, (clock()
-        - TimeStarted) / ((double)CLOCKS_PER_SEC), solcost);
-    final_eps_planning_time = (clock() - TimeStarted) / ((double)CLOCKS_PER_SEC);
+    SBPL_PRINTF("total expands this call = %d, planning time = %.3f secs, solution cost=%d\n", searchexpands,
+                deadline.getelapsedsecs(), solcost);
+    final_eps_planning_time = deadline.getelapsedsecs();
     final_eps = pSearchStateSpace->eps_satisfied;
 
     //SBPL_FPRINTF(fStat, "%d %d\n", searchexpands, solcost);
@@ -1309,7 +1310,12 @@ int ADPlanner::replan(vector<int>* solution_stateIDs_V, ReplanParams params, int
     bsearchuntilfirstsolution = params.return_first_solution;
     use_repair_time = params.repair_time > 0;
     repair_time = params.repair_time;
-    return replan(params.max_time, solution_stateIDs_V, solcost);
+
+    //the token is only polled during this call
+    deadline.setcanceltoken(params.cancel_token);
+    int ret = replan(params.max_time, solution_stateIDs_V, solcost);
+    deadline.setcanceltoken(NULL);
+    return ret;
 }
 
 //returns 1 if found a solution, and 0 otherwise
@@ -42,9 +42,67 @@
 
 using namespace std;
 
-ARAPlanner::ARAPlanner(DiscreteSpaceInformation* environment, bool bSearchForward)
+//OPEN is either the heap or the bucket queue of the search state space
+static inline bool OPENempty(ARASearchStateSpace_t* pSearchStateSpace)
+{
+    if (pSearchStateSpace->bucketheap) return pSearchStateSpace->bucketheap->emptyheap();
+    return pSearchStateSpace->heap->emptyheap();
+}
+
+static inline int OPENsize(ARASearchStateSpace_t* pSearchStateSpace)
+{
+    if (pSearchStateSpace->bucketheap) return pSearchStateSpace->bucketheap->currentsize;
+    return pSearchStateSpace->heap->currentsize;
+}
+
+static inline AbstractSearchState* OPENstate(ARASearchStateSpace_t* pSearchStateSpace, int index)
+{
+    if (pSearchStateSpace->bucketheap) return pSearchStateSpace->bucketheap->getstateheap(index);
+    return pSearchStateSpace->heap->getstateheap(index);
+}
+
+static inline void OPENinsertorupdate(ARASearchStateSpace_t* pSearchStateSpace, AbstractSearchState* state,
+                                      CKey key)
+{
+    if (pSearchStateSpace->bucketheap) {
+        if (state->heapindex != 0)
+            pSearchStateSpace->bucketheap->updateheap(state, key);
+        else
+            pSearchStateSpace->bucketheap->insertheap(state, key);
+    }
+    else {
+        if (state->heapindex != 0)
+            pSearchStateSpace->heap->updateheap(state, key);
+        else
+            pSearchStateSpace->heap->insertheap(state, key);
+    }
+}
+
+static inline CKey OPENgetminkey(ARASearchStateSpace_t* pSearchStateSpace)
+{
+    if (pSearchStateSpace->bucketheap) return pSearchStateSpace->bucketheap->getminkeyheap();
+    return pSearchStateSpace->heap->getminkeyheap();
+}
+
+static inline AbstractSearchState* OPENdeletemin(ARASearchStateSpace_t* pSearchStateSpace)
+{
+    if (pSearchStateSpace->bucketheap) return pSearchStateSpace->bucketheap->deleteminheap();
+    return pSearchStateSpace->heap->deleteminheap();
+}
+
+static inline void OPENmakeempty(ARASearchStateSpace_t* pSearchStateSpace)
+{
+    if (pSearchStateSpace->bucketheap)
+        pSearchStateSpace->bucketheap->makeemptyheap();
+    else
+        pSearchStateSpace->heap->makeemptyheap();
+}
+
+ARAPlanner::ARAPlanner(DiscreteSpaceInformation* environment, bool bSearchForward, int heaparity)
 {
     bforwardsearch = bSearchForward;
+    this->heaparity = heaparity;
+    OPENtype = SBPL_OPENTYPE_HEAP;
 
     environment_ = environment;
 
@@ -275,10 +333,7 @@ void ARAPlanner::UpdatePreds(ARAState* state, ARASearchStateSpace_t* pSearchStat
             if (predstate->iterationclosed != pSearchStateSpace->searchiteration) {
                 key.key[0] = predstate->g + (int)(pSearchStateSpace->eps * predstate->h);
                 //key.key[1] = predstate->h;
-                if (predstate->heapindex != 0)
-                    pSearchStateSpace->heap->updateheap(predstate, key);
-                else
-                    pSearchStateSpace->heap->insertheap(predstate, key);
+                OPENinsertorupdate(pSearchStateSpace, predstate, key);
             }
             //take care of incons list
             else if (predstate->listelem[ARA_INCONS_LIST_ID] == NULL) {
@@ -321,10 +376,7 @@ void ARAPlanner::UpdateSuccs(ARAState* state, ARASearchStateSpace_t* pSearchStat
 
                 //key.key[1] = succstate->h;
 
-                if (succstate->heapindex != 0)
-                    pSearchStateSpace->heap->updateheap(succstate, key);
-                else
-                    pSearchStateSpace->heap->insertheap(succstate, key);
+                OPENinsertorupdate(pSearchStateSpace, succstate, key);
             }
             //take care of incons list
             else if (succstate->listelem[ARA_INCONS_LIST_ID] == NULL) {
@@ -367,15 +419,14 @@ int ARAPlanner::ImprovePath(ARASearchStateSpace_t* pSearchStateSpace, double Max
     //goalkey.key[1] = searchgoalstate->h;
 
     //expand states until done
-    minkey = pSearchStateSpace->heap->getminkeyheap();
+    minkey = OPENgetminkey(pSearchStateSpace);
     CKey oldkey = minkey;
-    while (!pSearchStateSpace->heap->emptyheap() && minkey.key[0] < INFINITECOST && goalkey > minkey &&
-           (clock() - TimeStarted) < MaxNumofSecs * (double)CLOCKS_PER_SEC &&
-               (pSearchStateSpace->eps_satisfied == INFINITECOST ||
-               (clock() - TimeStarted) < repair_time * (double)CLOCKS_PER_SEC))
+    while (!OPENempty(pSearchStateSpace) && minkey.key[0] < INFINITECOST && goalkey > minkey &&
+           !deadline.expired(MaxNumofSecs) &&
+               (pSearchStateSpace->eps_satisfied == INFINITECOST || !deadline.expired(repair_time)))
     {
         //get the state
-        state = (ARAState*)pSearchStateSpace->heap->deleteminheap();
+        state = (ARAState*)OPENdeletemin(pSearchStateSpace);
 
 #if DEBUG
         SBPL_FPRINTF(fDeb, "expanding state(%d): h=%d g=%u key=%u v=%u iterc=%d callnuma=%d expands=%d (g(goal)=%u)\n",
@@ -422,7 +473,7 @@ int ARAPlanner::ImprovePath(ARASearchStateSpace_t* pSearchStateSpace, double Max
             UpdateSuccs(state, pSearchStateSpace);
 
         //recompute minkey
-        minkey = pSearchStateSpace->heap->getminkeyheap();
+        minkey = OPENgetminkey(pSearchStateSpace);
 
         //recompute goalkey if necessary
         if (goalkey.key[0] != (int)searchgoalstate->g) {
@@ -442,15 +493,15 @@ int ARAPlanner::ImprovePath(ARASearchStateSpace_t* pSearchStateSpace, double Max
     }
 
     int retv = 1;
-    if (searchgoalstate->g == INFINITECOST && pSearchStateSpace->heap->emptyheap()) {
+    if (searchgoalstate->g == INFINITECOST && OPENempty(pSearchStateSpace)) {
         SBPL_PRINTF("solution does not exist: search exited because heap is empty\n");
         retv = 0;
     }
-    else if (!pSearchStateSpace->heap->emptyheap() && goalkey > minkey) {
+    else if (!OPENempty(pSearchStateSpace) && goalkey > minkey) {
         SBPL_PRINTF("search exited because it ran out of time\n");
         retv = 2;
     }
-    else if (searchgoalstate->g == INFINITECOST && !pSearchStateSpace->heap->emptyheap()) {
+    else if (searchgoalstate->g == INFINITECOST && !OPENempty(pSearchStateSpace)) {
         SBPL_PRINTF("solution does not exist: search exited because all candidates for expansion have "
                     "infinite heuristics\n");
         retv = 0;
@@ -471,7 +522,6 @@ void ARAPlanner::BuildNewOPENList(ARASearchStateSpace_t* pSearchStateSpace)
 {
     ARAState *state;
     CKey key;
-    CHeap* pheap = pSearchStateSpace->heap;
     CList* pinconslist = pSearchStateSpace->inconslist;
 
     //move incons into open
@@ -483,7 +533,7 @@ void ARAPlanner::BuildNewOPENList(ARASearchStateSpace_t* pSearchStateSpace)
         //key.key[1] = state->h;
 
         //insert into OPEN
-        pheap->insertheap(state, key);
+        OPENinsertorupdate(pSearchStateSpace, state, key);
         //remove from INCONS
         pinconslist->remove(state, ARA_INCONS_LIST_ID);
     }
@@ -493,15 +543,21 @@ void ARAPlanner::Reevaluatefvals(ARASearchStateSpace_t* pSearchStateSpace)
 {
     CKey key;
     int i;
-    CHeap* pheap = pSearchStateSpace->heap;
 
     //recompute priorities for states in OPEN and reorder it
-    for (i = 1; i <= pheap->currentsize; ++i) {
-        ARAState* state = (ARAState*)pheap->heap[i].heapstate;
-        pheap->heap[i].key.key[0] = state->g + (int)(pSearchStateSpace->eps * state->h);
-        //pheap->heap[i].key.key[1] = state->h;
+    for (i = 1; i <= OPENsize(pSearchStateSpace); ++i) {
+        ARAState* state = (ARAState*)OPENstate(pSearchStateSpace, i);
+        key.key[0] = state->g + (int)(pSearchStateSpace->eps * state->h);
+        //key.key[1] = state->h;
+        if (pSearchStateSpace->bucketheap)
+            pSearchStateSpace->bucketheap->setkeyheap_unsafe(i, key);
+        else
+            pSearchStateSpace->heap->setkeyheap_unsafe(i, key);
     }
-    pheap->makeheap();
+    if (pSearchStateSpace->bucketheap)
+        pSearchStateSpace->bucketheap->makeheap();
+    else
+        pSearchStateSpace->heap->makeheap();
 
     pSearchStateSpace->bReevaluatefvals = false;
 }
@@ -521,9 +577,15 @@ void ARAPlanner::Reevaluatehvals(ARASearchStateSpace_t* pSearchStateSpace)
 int ARAPlanner::CreateSearchStateSpace(ARASearchStateSpace_t* pSearchStateSpace)
 {
     //create a heap
-    pSearchStateSpace->heap = new CHeap;
+    //OPEN is ordered by f alone, so only the first key is stored
+    pSearchStateSpace->heap = new CDaryHeap(heaparity, 1);
+    pSearchStateSpace->bucketheap = NULL;
+    if (OPENtype == SBPL_OPENTYPE_BUCKETQUEUE) {
+        pSearchStateSpace->bucketheap = new CBucketHeap;
+        MaxMemoryCounter += sizeof(CBucketHeap);
+    }
     pSearchStateSpace->inconslist = new CList;
-    MaxMemoryCounter += sizeof(CHeap);
+    MaxMemoryCounter += sizeof(CDaryHeap);
     MaxMemoryCounter += sizeof(CList);
 
     pSearchStateSpace->searchgoalstate = NULL;
@@ -546,6 +608,12 @@ void ARAPlanner::DeleteSearchStateSpace(ARASearchStateSpace_t* pSearchStateSpace
         pSearchStateSpace->heap = NULL;
     }
 
+    if (pSearchStateSpace->bucketheap != NULL) {
+        pSearchStateSpace->bucketheap->makeemptyheap();
+        delete pSearchStateSpace->bucketheap;
+        pSearchStateSpace->bucketheap = NULL;
+    }
+
     if (pSearchStateSpace->inconslist != NULL) {
         pSearchStateSpace->inconslist->makeemptylist(ARA_INCONS_LIST_ID);
         delete pSearchStateSpace->inconslist;
@@ -569,7 +637,7 @@ void ARAPlanner::DeleteSearchStateSpace(ARASearchStateSpace_t* pSearchStateSpace
 //needs to be done before deleting states
 int ARAPlanner::ResetSearchStateSpace(ARASearchStateSpace_t* pSearchStateSpace)
 {
-    pSearchStateSpace->heap->makeemptyheap();
+    OPENmakeempty(pSearchStateSpace);
     pSearchStateSpace->inconslist->makeemptylist(ARA_INCONS_LIST_ID);
 
     return 1;
@@ -592,7 +660,7 @@ void ARAPlanner::ReInitializeSearchStateSpace(ARASearchStateSpace_t* pSearchStat
         pSearchStateSpace->callnumber,pSearchStateSpace->searchiteration );
 #endif
 
-    pSearchStateSpace->heap->makeemptyheap();
+    OPENmakeempty(pSearchStateSpace);
     pSearchStateSpace->inconslist->makeemptylist(ARA_INCONS_LIST_ID);
 
     //reset
@@ -615,7 +683,7 @@ void ARAPlanner::ReInitializeSearchStateSpace(ARASearchStateSpace_t* pSearchStat
     //insert start state into the heap
     key.key[0] = (long int)(pSearchStateSpace->eps * startstateinfo->h);
     //key.key[1] = startstateinfo->h;
-    pSearchStateSpace->heap->insertheap(startstateinfo, key);
+    OPENinsertorupdate(pSearchStateSpace, startstateinfo, key);
 
     pSearchStateSpace->bReinitializeSearchStateSpace = false;
     pSearchStateSpace->bReevaluatefvals = false;
@@ -624,7 +692,7 @@ void ARAPlanner::ReInitializeSearchStateSpace(ARASearchStateSpace_t* pSearchStat
 //very first initialization
 int ARAPlanner::InitializeSearchStateSpace(ARASearchStateSpace_t* pSearchStateSpace)
 {
-    if (pSearchStateSpace->heap->currentsize != 0 || pSearchStateSpace->inconslist->currentsize != 0) {
+    if (OPENsize(pSearchStateSpace) != 0 || pSearchStateSpace->inconslist->currentsize != 0) {
         throw SBPL_Exception("ERROR in InitializeSearchStateSpace: heap or list is not empty");
     }
 
@@ -900,7 +968,7 @@ bool ARAPlanner::Search(ARASearchStateSpace_t* pSearchStateSpace, vector<int>& p
                         bool bFirstSolution, bool bOptimalSolution, double MaxNumofSecs)
 {
     CKey key;
-    TimeStarted = clock();
+    deadline.start();
     searchexpands = 0;
     num_of_expands_initial_solution = -1;
     double old_repair_time = repair_time;
@@ -935,13 +1003,14 @@ bool ARAPlanner::Search(ARASearchStateSpace_t* pSearchStateSpace, vector<int>& p
     //the main loop of ARA*
     stats.clear();
     int prevexpands = 0;
-    clock_t loop_time;
+    double loop_time;
     while (pSearchStateSpace->eps_satisfied > final_epsilon &&
-           (clock() - TimeStarted) < MaxNumofSecs * (double)CLOCKS_PER_SEC &&
+           !deadline.cancelled() &&
+           deadline.getelapsedsecs() < MaxNumofSecs &&
                (pSearchStateSpace->eps_satisfied == INFINITECOST ||
-               (clock() - TimeStarted) < repair_time * (double)CLOCKS_PER_SEC))
+               deadline.getelapsedsecs() < repair_time))
     {
-        loop_time = clock();
+        loop_time = deadline.getelapsedsecs();
         //decrease eps for all subsequent iterations
         if (fabs(pSearchStateSpace->eps_satisfied - pSearchStateSpace->eps) < ERR_EPS && !bFirstSolution) {
             pSearchStateSpace->eps = pSearchStateSpace->eps - dec_eps;
@@ -974,10 +1043,10 @@ bool ARAPlanner::Search(ARASearchStateSpace_t* pSearchStateSpace, vector<int>& p
         SBPL_PRINTF("eps=%f expands=%d g(searchgoal)=%d time=%.3f\n", pSearchStateSpace->eps_satisfied,
                     searchexpands - prevexpands,
                     ((ARAState*)pSearchStateSpace->searchgoalstate->PlannerSpecificData)->g,
-                    double(clock() - loop_time) / CLOCKS_PER_SEC);
+                    deadline.getelapsedsecs() - loop_time);
 
         if (pSearchStateSpace->eps_satisfied == finitial_eps && pSearchStateSpace->eps == finitial_eps) {
-            finitial_eps_planning_time = double(clock() - loop_time) / CLOCKS_PER_SEC;
+            finitial_eps_planning_time = deadline.getelapsedsecs() - loop_time;
             num_of_expands_initial_solution = searchexpands - prevexpands;
         }
 
@@ -985,7 +1054,7 @@ bool ARAPlanner::Search(ARASearchStateSpace_t* pSearchStateSpace, vector<int>& p
             PlannerStats tempStat;
             tempStat.eps = pSearchStateSpace->eps_satisfied;
             tempStat.expands = searchexpands - prevexpands;
-            tempStat.time = double(clock() - loop_time) / CLOCKS_PER_SEC;
+            tempStat.time = deadline.getelapsedsecs() - loop_time;
             tempStat.cost = ((ARAState*)pSearchStateSpace->searchgoalstate->PlannerSpecificData)->g;
             stats.push_back(tempStat);
         }
@@ -994,7 +1063,7 @@ bool ARAPlanner::Search(ARASearchStateSpace_t* pSearchStateSpace, vector<int>& p
         SBPL_FPRINTF(fDeb, "eps=%f expands=%d g(searchgoal)=%d time=%.3f\n", pSearchStateSpace->eps_satisfied,
                      searchexpands - prevexpands,
                      ((ARAState*)pSearchStateSpace->searchgoalstate->PlannerSpecificData)->g,
-                     double(clock()-loop_time)/CLOCKS_PER_SEC);
+                     deadline.getelapsedsecs() - loop_time);
         PrintSearchState((ARAState*)pSearchStateSpace->searchgoalstate->PlannerSpecificData, fDeb);
 #endif
         prevexpands = searchexpands;
@@ -1031,8 +1100,8 @@ bool ARAPlanner::Search(ARASearchStateSpace_t* pSearchStateSpace, vector<int>& p
     }
 
     SBPL_PRINTF("total expands this call = %d, planning time = %.3f secs, solution cost=%d\n",
-                searchexpands, (clock() - TimeStarted) / ((double)CLOCKS_PER_SEC), solcost);
-    final_eps_planning_time = (clock() - TimeStarted) / ((double)CLOCKS_PER_SEC);
+                searchexpands, deadline.getelapsedsecs(), solcost);
+    final_eps_planning_time = deadline.getelapsedsecs();
     final_eps = pSearchStateSpace->eps_satisfied;
     //SBPL_FPRINTF(fStat, "%d %d\n", searchexpands, solcost);
 
@@ -1055,7 +1124,12 @@ int ARAPlanner::replan(vector<int>* solution_stateIDs_V, ReplanParams params, in
     bsearchuntilfirstsolution = params.return_first_solution;
     use_repair_time = params.repair_time > 0;
     repair_time = params.repair_time;
-    return replan(params.max_time, solution_stateIDs_V, solcost);
+
+    //the token is only polled during this call
+    deadline.setcanceltoken(params.cancel_token);
+    int ret = replan(params.max_time, solution_stateIDs_V, solcost);
+    deadline.setcanceltoken(NULL);
+    return ret;
 }
 
 //returns 1 if found a solution, and 0 otherwise
@@ -1194,6 +1268,35 @@ int ARAPlanner::set_search_mode(bool bSearchUntilFirstSolution)
     return 1;
 }
 
+void ARAPlanner::set_OPEN_type(SBPL_OPENTYPE OPENtype)
+{
+    SBPL_PRINTF("planner: OPEN type set to %d\n", OPENtype);
+
+    this->OPENtype = OPENtype;
+    if ((OPENtype == SBPL_OPENTYPE_BUCKETQUEUE) == (pSearchStateSpace_->bucketheap != NULL)) {
+        return;
+    }
+
+    //move the states that are in OPEN over to the new data structure
+    if (OPENtype == SBPL_OPENTYPE_BUCKETQUEUE) {
+        CBucketHeap* bucketheap = new CBucketHeap;
+        while (!pSearchStateSpace_->heap->emptyheap()) {
+            CKey key = pSearchStateSpace_->heap->getminkeyheap();
+            bucketheap->insertheap(pSearchStateSpace_->heap->deleteminheap(), key);
+        }
+        pSearchStateSpace_->bucketheap = bucketheap;
+    }
+    else {
+        CBucketHeap* bucketheap = pSearchStateSpace_->bucketheap;
+        while (!bucketheap->emptyheap()) {
+            CKey key = bucketheap->getminkeyheap();
+            pSearchStateSpace_->heap->insertheap(bucketheap->deleteminheap(), key);
+        }
+        delete bucketheap;
+        pSearchStateSpace_->bucketheap = NULL;
+    }
+}
+
 void ARAPlanner::print_searchpath(FILE* fOut)
 {
     PrintSearchPath(pSearchStateSpace_, fOut);
@@ -1235,11 +1338,11 @@ double ARAPlanner::compute_suboptimality()
     // list
     int openListMin = std::numeric_limits<int>::max();
     if (pSearchStateSpace_->heap) {
-        for (int i = 1; i < pSearchStateSpace_->heap->currentsize; i++) {
+        for (int i = 1; i < OPENsize(pSearchStateSpace_); i++) {
             AbstractSearchState* abstractState =
-                    pSearchStateSpace_->heap->heap[i].heapstate;
+                    OPENstate(pSearchStateSpace_, i);
             if (!abstractState) {
-                SBPL_ERROR("heap element with keys %d and %d has NULL AbstractSearchState\n", (int)pSearchStateSpace_->heap->heap[i].key[0], (int)pSearchStateSpace_->heap->heap[i].key[1]);
+                SBPL_ERROR("heap element %d has NULL AbstractSearchState\n", i);
                 continue; // return -1.0 ?
             }
 
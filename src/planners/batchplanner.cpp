@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2008, Maxim Likhachev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Carnegie Mellon University nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sbpl/planners/batchplanner.h>
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <sbpl/planners/araplanner.h>
+#include <sbpl/utils/deadline.h>
+#include <sbpl/utils/key.h>
+#include <sbpl/utils/mdpconfig.h>
+#include <sbpl/utils/utils.h>
+
+BatchPlanner::BatchPlanner(const EnvironmentNAVXYTHETALAT* environment, bool bforwardsearch, int numthreads)
+{
+    this->environment = environment;
+    this->bforwardsearch = bforwardsearch;
+    if (numthreads <= 0) {
+        numthreads = __max(1, (int)std::thread::hardware_concurrency());
+    }
+    this->numthreads = numthreads;
+}
+
+void BatchPlanner::planquery(
+    EnvironmentNAVXYTHETALAT* replica,
+    const sbpl_xy_theta_pt_t& start,
+    const sbpl_xy_theta_pt_t& goal,
+    const ReplanParams& params,
+    bool check_collisions,
+    BatchPlanResult* result)
+{
+    SBPLDeadline deadline;
+    result->status = 0;
+    result->cost = INFINITECOST;
+    result->eps = INFINITECOST;
+    result->expands = 0;
+    result->xythetaPath.clear();
+    result->xythetaCellPath.clear();
+
+    if (replica->SetStart(start.x, start.y, start.theta, check_collisions) < 0 ||
+        replica->SetGoal(goal.x, goal.y, goal.theta, check_collisions) < 0)
+    {
+        result->status = -1;
+        result->time = deadline.getelapsedsecs();
+        return;
+    }
+
+    //drop the states of the previous query, the start and the goal are kept
+    //and so are their heuristics if they did not change
+    replica->ResetStates();
+
+    MDPConfig MDPCfg;
+    replica->InitializeMDPCfg(&MDPCfg);
+
+    std::vector<int> solution_stateIDs_V;
+    {
+        ARAPlanner planner(replica, bforwardsearch);
+        planner.set_start(MDPCfg.startstateid);
+        planner.set_goal(MDPCfg.goalstateid);
+        result->status = planner.replan(&solution_stateIDs_V, params, &result->cost);
+        result->eps = planner.get_solution_eps();
+        result->expands = planner.get_n_expands();
+    }
+
+    if (result->status == 1) {
+        replica->ConvertStateIDPathintoXYThetaPath(&solution_stateIDs_V, &result->xythetaPath);
+        for (int j = 1; j < (int)solution_stateIDs_V.size(); j++) {
+            sbpl_xy_theta_cell_t xytheta_cell;
+            replica->GetCoordFromState(solution_stateIDs_V[j], xytheta_cell.x, xytheta_cell.y, xytheta_cell.theta);
+            result->xythetaCellPath.push_back(xytheta_cell);
+        }
+    }
+    result->time = deadline.getelapsedsecs();
+}
+
+int BatchPlanner::plan(
+    const std::vector<sbpl_xy_theta_pt_t>& starts,
+    const std::vector<sbpl_xy_theta_pt_t>& goals,
+    const ReplanParams& params,
+    bool check_collisions,
+    std::vector<BatchPlanResult>* results)
+{
+    if (starts.size() != goals.size()) {
+        throw SBPL_Exception("ERROR: the number of starts and goals differ");
+    }
+
+    const int numofqueries = (int)starts.size();
+    results->resize(numofqueries);
+    for (int i = 0; i < numofqueries; i++) {
+        (*results)[i].status = 0;
+        (*results)[i].cost = INFINITECOST;
+        (*results)[i].eps = INFINITECOST;
+        (*results)[i].time = 0;
+        (*results)[i].expands = 0;
+        (*results)[i].xythetaPath.clear();
+        (*results)[i].xythetaCellPath.clear();
+    }
+    if (numofqueries == 0) {
+        return 0;
+    }
+
+    //an environment per thread searching the lattice model of the
+    //environment, the model is only remade when the costmap changed since the
+    //last call. They are created up front so that the threads only read the
+    //model.
+    std::shared_ptr<const EnvNAVXYTHETALATLatticeModel> model = environment->GetLatticeModel();
+    const int numofthreads = __min(numthreads, numofqueries);
+    std::vector<std::unique_ptr<EnvironmentNAVXYTHETALAT> > replicas(numofthreads);
+    for (int t = 0; t < numofthreads; t++) {
+        replicas[t].reset(new EnvironmentNAVXYTHETALAT());
+        if (!replicas[t]->InitializeEnvFromModel(model)) {
+            throw SBPL_Exception("ERROR: could not create an environment for the lattice model");
+        }
+        //queries to the same goal share its distances
+        replicas[t]->SetHeuristicCache(environment->GetHeuristicCache());
+    }
+
+    //the queries are handed out one at a time, so threads that get the easy
+    //ones take more of them
+    std::atomic<int> next(0);
+    //the first exception thrown by a query, rethrown once all threads stopped
+    std::exception_ptr error;
+    std::mutex errormutex;
+    auto worker = [&](int t) {
+        EnvironmentNAVXYTHETALAT* replica = replicas[t].get();
+        for (int i = next++; i < numofqueries; i = next++) {
+            if (params.cancel_token != NULL && params.cancel_token->cancelled()) {
+                break;
+            }
+            try {
+                planquery(replica, starts[i], goals[i], params, check_collisions, &(*results)[i]);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(errormutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next = numofqueries;
+                break;
+            }
+        }
+    };
+
+    if (numofthreads <= 1) {
+        worker(0);
+    }
+    else {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numofthreads; t++) {
+            threads.push_back(std::thread(worker, t));
+        }
+        for (size_t t = 0; t < threads.size(); t++) {
+            threads[t].join();
+        }
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    int numofpaths = 0;
+    for (int i = 0; i < numofqueries; i++) {
+        if ((*results)[i].status == 1) {
+            numofpaths++;
+        }
+    }
+    return numofpaths;
+}
@@ -34,8 +34,10 @@ using namespace std;
 
 LazyARAPlanner::LazyARAPlanner(
     DiscreteSpaceInformation* environment,
-    bool bSearchForward)
+    bool bSearchForward,
+    int heaparity)
 :
+    heap(heaparity, 1), // OPEN is ordered by f alone
     params(0.0)
 {
     bforwardsearch = bSearchForward;
@@ -402,23 +404,29 @@ vector<int> LazyARAPlanner::GetSearchPath(int& solcost)
 
 bool LazyARAPlanner::outOfTime()
 {
+    // a cancelled search stops regardless of the time limits
+    if (deadline.cancelled()) {
+        SBPL_DEBUG("search cancelled");
+        return true;
+    }
     // if we are supposed to run until the first solution, then we are never out
     // of time
     if (params.return_first_solution) {
         return false;
     }
-    double time_used = double(clock() - TimeStarted) / CLOCKS_PER_SEC;
-    if (time_used >= params.max_time) {
+    bool out_of_max_time = deadline.expired(params.max_time);
+    bool out_of_repair_time = use_repair_time && eps_satisfied != INFINITECOST &&
+            deadline.expired(params.repair_time);
+    if (out_of_max_time) {
         SBPL_DEBUG("out of max time");
     }
-    if (use_repair_time && eps_satisfied != INFINITECOST && time_used >= params.repair_time) {
+    if (out_of_repair_time) {
         SBPL_DEBUG("used all repair time...");
     }
     // we are out of time if:
     // we used up the max time limit OR
     // we found some solution and used up the minimum time limit
-    return time_used >= params.max_time ||
-            (use_repair_time && eps_satisfied != INFINITECOST && time_used >= params.repair_time);
+    return out_of_max_time || out_of_repair_time;
 }
 
 void LazyARAPlanner::initializeSearch()
@@ -465,7 +473,7 @@ void LazyARAPlanner::initializeSearch()
 bool LazyARAPlanner::Search(vector<int>& pathIds, int& PathCost)
 {
     CKey key;
-    TimeStarted = clock();
+    deadline.start();
 
     initializeSearch();
 
@@ -473,7 +481,7 @@ bool LazyARAPlanner::Search(vector<int>& pathIds, int& PathCost)
     while (eps_satisfied > params.final_eps && !outOfTime()) {
 
         // run weighted A*
-        clock_t before_time = clock();
+        double before_time = deadline.getelapsedsecs();
         int before_expands = search_expands;
         // ImprovePath returns:
         // 1 if the solution is found
@@ -485,7 +493,7 @@ bool LazyARAPlanner::Search(vector<int>& pathIds, int& PathCost)
             eps_satisfied = eps;
         }
         int delta_expands = search_expands - before_expands;
-        double delta_time = double(clock() - before_time) / CLOCKS_PER_SEC;
+        double delta_time = deadline.getelapsedsecs() - before_time;
 
         // print the bound, expands, and time for that iteration
         SBPL_DEBUG("bound=%f expands=%d cost=%d time=%.3f", eps_satisfied, delta_expands, goal_state->g, delta_time);
@@ -524,9 +532,9 @@ bool LazyARAPlanner::Search(vector<int>& pathIds, int& PathCost)
     }
 
     SBPL_DEBUG("solution found");
-    clock_t before_reconstruct = clock();
+    double before_reconstruct = deadline.getelapsedsecs();
     pathIds = GetSearchPath(PathCost);
-    reconstructTime = double(clock() - before_reconstruct) / CLOCKS_PER_SEC;
+    reconstructTime = deadline.getelapsedsecs() - before_reconstruct;
     totalTime = totalPlanTime + reconstructTime;
 
     return true;
@@ -552,8 +560,9 @@ void LazyARAPlanner::prepareNextSearchIteration()
 
     // recompute priorities for states in OPEN and reorder it
     for (int i = 1; i <= heap.currentsize; ++i){
-        LazyARAState* state = (LazyARAState*)heap.heap[i].heapstate;
-        heap.heap[i].key.key[0] = state->g + int(eps * state->h);
+        LazyARAState* state = (LazyARAState*)heap.getstateheap(i);
+        key.key[0] = state->g + int(eps * state->h);
+        heap.setkeyheap_unsafe(i, key);
     }
     heap.makeheap();
 
@@ -576,6 +585,8 @@ int LazyARAPlanner::replan(
     int* solcost)
 {
     params.max_time = allocated_time_sec;
+    // the cancel token of an earlier call is not kept
+    params.cancel_token = NULL;
     return replan(solution_stateIDs_V, params, solcost);
 }
 
@@ -620,7 +631,11 @@ int LazyARAPlanner::replan(
     // plan
     vector<int> pathIds;
     int PathCost = 0;
+    //the token is only polled during this call
+    deadline.setcanceltoken(params.cancel_token);
     bool solnFound = Search(pathIds, PathCost);
+    deadline.setcanceltoken(NULL);
+    params.cancel_token = NULL;
     SBPL_DEBUG("total expands=%d planning time=%.3f reconstruct path time=%.3f total time=%.3f solution cost=%d", totalExpands, totalPlanTime, reconstructTime, totalTime, goal_state->g);
 
     // copy the solution
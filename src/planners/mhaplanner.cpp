@@ -31,21 +31,16 @@
 
 #include <assert.h>
 #include <stdlib.h>
-#include <time.h>
 #include <algorithm>
 
 #include <sbpl/utils/key.h>
 
-static double GetTime()
-{
-    return (double)clock() / (double)CLOCKS_PER_SEC;
-}
-
 MHAPlanner::MHAPlanner(
     DiscreteSpaceInformation* environment,
     Heuristic* hanchor,
     Heuristic** heurs,
-    int hcount)
+    int hcount,
+    int heaparity)
 :
     SBPLPlanner(),
 //    environment_(environment),
@@ -68,7 +63,11 @@ MHAPlanner::MHAPlanner(
 {
     environment_ = environment;
 
-    m_open = new CHeap[hcount + 1];
+    // the open lists are ordered by f alone, so only the first key is stored
+    m_open = new CDaryHeap*[hcount + 1];
+    for (int i = 0; i < hcount + 1; ++i) {
+        m_open[i] = new CDaryHeap(heaparity, 1);
+    }
 
     // Overwrite default members for ReplanParams to represent a single optimal
     // search
@@ -90,6 +89,9 @@ MHAPlanner::~MHAPlanner()
 {
     clear();
 
+    for (int i = 0; i < num_heuristics(); ++i) {
+        delete m_open[i];
+    }
     delete[] m_open;
 }
 
@@ -130,6 +132,8 @@ int MHAPlanner::replan(
 {
     ReplanParams params = m_params;
     params.max_time = allocated_time_sec;
+    // the cancel token of an earlier call is not kept
+    params.cancel_token = NULL;
     return replan(solution_stateIDs_V, params, solcost);
 }
 
@@ -176,11 +180,18 @@ int MHAPlanner::replan(
     // reset time limits
     m_num_expansions = 0;
     m_elapsed = 0.0;
+    m_deadline.start();
 
-    double start_time, end_time;
-
-    start_time = GetTime();
+    //the token is only polled during this call
+    m_deadline.setcanceltoken(m_params.cancel_token);
+    int ret = search(solution_stateIDs_V, solcost);
+    m_deadline.setcanceltoken(NULL);
+    m_params.cancel_token = NULL;
+    return ret;
+}
 
+int MHAPlanner::search(std::vector<int>* solution_stateIDs_V, int* solcost)
+{
     ++m_call_number;
     reinit_state(m_goal_state);
     reinit_state(m_start_state);
@@ -190,66 +201,63 @@ int MHAPlanner::replan(
     for (int hidx = 0; hidx < num_heuristics(); ++hidx) {
         CKey key;
         key.key[0] = compute_key(m_start_state, hidx);
-        m_open[hidx].insertheap(&m_start_state->od[hidx].open_state, key);
+        m_open[hidx]->insertheap(&m_start_state->od[hidx].open_state, key);
         SBPL_DEBUG("Inserted start state %d into search %d with f = %d", m_start_state->state_id, hidx, key.key[0]);
     }
 
-    end_time = GetTime();
-    m_elapsed += (end_time - start_time);
-
-    while (!m_open[0].emptyheap() && !time_limit_reached()) {
-        start_time = GetTime();
-
+    while (!m_open[0]->emptyheap() && !time_limit_reached()) {
         // special case for mha* without additional heuristics
         if (num_heuristics() == 1) {
-            if (m_goal_state->g <= get_minf(m_open[0])) {
+            if (m_goal_state->g <= get_minf(*m_open[0])) {
                 m_eps_satisfied = m_eps * m_eps_mha;
+                m_elapsed = m_deadline.getelapsedsecs();
                 extract_path(solution_stateIDs_V, solcost);
                 return 1;
             }
             else {
-                MHASearchState* s = state_from_open_state(m_open[0].getminheap());
+                MHASearchState* s = state_from_open_state(m_open[0]->getminheap());
                 expand(s, 0);
             }
         }
 
         for (int hidx = 1; hidx < num_heuristics(); ++hidx) {
-            if (m_open[0].emptyheap()) {
+            if (m_open[0]->emptyheap()) {
                 break;
             }
 
-            if (!m_open[hidx].emptyheap() && get_minf(m_open[hidx]) <=
-                m_eps_mha * get_minf(m_open[0]))
+            if (!m_open[hidx]->emptyheap() && get_minf(*m_open[hidx]) <=
+                m_eps_mha * get_minf(*m_open[0]))
             {
-                if (m_goal_state->g <= get_minf(m_open[hidx])) {
+                if (m_goal_state->g <= get_minf(*m_open[hidx])) {
                     m_eps_satisfied = m_eps * m_eps_mha;
+                    m_elapsed = m_deadline.getelapsedsecs();
                     extract_path(solution_stateIDs_V, solcost);
                     return 1;
                 }
                 else {
                     MHASearchState* s =
-                            state_from_open_state(m_open[hidx].getminheap());
+                            state_from_open_state(m_open[hidx]->getminheap());
                     expand(s, hidx);
                 }
             }
             else {
-                if (m_goal_state->g <= get_minf(m_open[0])) {
+                if (m_goal_state->g <= get_minf(*m_open[0])) {
                     m_eps_satisfied = m_eps * m_eps_mha;
+                    m_elapsed = m_deadline.getelapsedsecs();
                     extract_path(solution_stateIDs_V, solcost);
                     return 1;
                 }
                 else {
                     MHASearchState* s =
-                            state_from_open_state(m_open[0].getminheap());
+                            state_from_open_state(m_open[0]->getminheap());
                     expand(s, 0);
                 }
             }
         }
-        end_time = GetTime();
-        m_elapsed += (end_time - start_time);
     }
+    m_elapsed = m_deadline.getelapsedsecs();
 
-    if (m_open[0].emptyheap()) {
+    if (m_open[0]->emptyheap()) {
         SBPL_DEBUG("Anchor search exhausted");
     }
     if (time_limit_reached()) {
@@ -411,10 +419,13 @@ bool MHAPlanner::check_params(const ReplanParams& params)
 
 bool MHAPlanner::time_limit_reached() const
 {
-    if (m_params.return_first_solution) {
+    if (m_deadline.cancelled()) {
+        return true;
+    }
+    else if (m_params.return_first_solution) {
         return false;
     }
-    else if (m_params.max_time > 0.0 && m_elapsed >= m_params.max_time) {
+    else if (m_params.max_time > 0.0 && m_deadline.expired(m_params.max_time)) {
         return true;
     }
     else if (m_max_expansions > 0 && m_num_expansions >= m_max_expansions) {
@@ -516,7 +527,7 @@ void MHAPlanner::reinit_search()
 void MHAPlanner::clear_open_lists()
 {
     for (int i = 0; i < num_heuristics(); ++i) {
-        m_open[i].makeemptyheap();
+        m_open[i]->makeemptyheap();
     }
 }
 
@@ -541,8 +552,8 @@ void MHAPlanner::expand(MHASearchState* state, int hidx)
 
     // remove s from all open lists
     for (int temp_hidx = 0; temp_hidx < num_heuristics(); ++temp_hidx) {
-        if (m_open[temp_hidx].inheap(&state->od[temp_hidx].open_state)) {
-            m_open[temp_hidx].deleteheap(&state->od[temp_hidx].open_state);
+        if (m_open[temp_hidx]->inheap(&state->od[temp_hidx].open_state)) {
+            m_open[temp_hidx]->deleteheap(&state->od[temp_hidx].open_state);
         }
     }
 
@@ -603,7 +614,7 @@ int MHAPlanner::compute_heuristic(int state_id, int hidx)
     }
 }
 
-int MHAPlanner::get_minf(CHeap& pq) const
+int MHAPlanner::get_minf(CDaryHeap& pq) const
 {
     return pq.getminkeyheap().key[0];
 }
@@ -614,10 +625,10 @@ void MHAPlanner::insert_or_update(MHASearchState* state, int hidx, int f)
     new_key.key[0] = f;
 
     if (state->od[hidx].open_state.heapindex != 0) {
-        m_open[hidx].updateheap(&state->od[hidx].open_state, new_key);
+        m_open[hidx]->updateheap(&state->od[hidx].open_state, new_key);
     }
     else {
-        m_open[hidx].insertheap(&state->od[hidx].open_state, new_key);
+        m_open[hidx]->insertheap(&state->od[hidx].open_state, new_key);
     }
 }
 
@@ -331,7 +331,7 @@ bool RSTARPlanner::ComputeLocalPath(int StartStateID, int GoalStateID, int maxc,
         }
 
         if (local_expands % 10000 == 0) {
-            if ((clock() - TimeStarted) >= maxnumofsecs * (double)CLOCKS_PER_SEC) {
+            if (deadline.getelapsedsecs() >= maxnumofsecs) {
                 SBPL_PRINTF("breaking local search because global planning time expires\n");
                 break;
             }
@@ -611,7 +611,7 @@ int RSTARPlanner::ImprovePath(double MaxNumofSecs)
 
     //expand states until done
     minkey = pSearchStateSpace->OPEN->getminkeyheap();
-    while (!pSearchStateSpace->OPEN->emptyheap() && (clock() - TimeStarted) < MaxNumofSecs * (double)CLOCKS_PER_SEC) {
+    while (!pSearchStateSpace->OPEN->emptyheap() && !deadline.expired(MaxNumofSecs)) {
         //recompute minkey
         minkey = pSearchStateSpace->OPEN->getminkeyheap();
 
@@ -1205,7 +1205,7 @@ bool RSTARPlanner::Search(vector<int>& pathIds, int & PathCost, bool bFirstSolut
                           double MaxNumofSecs)
 {
     CKey key;
-    TimeStarted = clock();
+    deadline.start();
     highlevel_searchexpands = 0;
     lowlevel_searchexpands = 0;
 
@@ -1244,12 +1244,12 @@ bool RSTARPlanner::Search(vector<int>& pathIds, int & PathCost, bool bFirstSolut
 
     //the main loop of R*
     int prevexpands = 0;
-    clock_t loop_time;
+    double loop_time;
     //TODO - change FINAL_EPS and DECREASE_EPS onto a parameter
     while (pSearchStateSpace->eps_satisfied > final_epsilon &&
-           (clock() - TimeStarted) < MaxNumofSecs * (double)CLOCKS_PER_SEC)
+           deadline.getelapsedsecs() < MaxNumofSecs)
     {
-        loop_time = clock();
+        loop_time = deadline.getelapsedsecs();
 
         //decrease eps for all subsequent iterations
         if (fabs(pSearchStateSpace->eps_satisfied - pSearchStateSpace->eps) < ERR_EPS && !bFirstSolution) {
@@ -1286,13 +1286,13 @@ bool RSTARPlanner::Search(vector<int>& pathIds, int & PathCost, bool bFirstSolut
         SBPL_PRINTF("eps=%f highlevel expands=%d g(searchgoal)=%d time=%.3f\n", pSearchStateSpace->eps_satisfied,
                     highlevel_searchexpands - prevexpands,
                     ((RSTARState*)pSearchStateSpace->searchgoalstate->PlannerSpecificData)->g,
-                    double(clock() - loop_time) / CLOCKS_PER_SEC);
+                    deadline.getelapsedsecs() - loop_time);
 
 #if DEBUG
         SBPL_FPRINTF(fDeb, "eps=%f highlevel expands=%d g(searchgoal)=%d time=%.3f\n",
                      pSearchStateSpace->eps_satisfied, highlevel_searchexpands - prevexpands,
                      ((RSTARState*)pSearchStateSpace->searchgoalstate->PlannerSpecificData)->g,
-                     double(clock()-loop_time)/CLOCKS_PER_SEC);
+                     deadline.getelapsedsecs() - loop_time);
         PrintSearchState((RSTARState*)pSearchStateSpace->searchgoalstate->PlannerSpecificData, fDeb);
 #endif
         prevexpands = highlevel_searchexpands;
@@ -1342,7 +1342,7 @@ bool RSTARPlanner::Search(vector<int>& pathIds, int & PathCost, bool bFirstSolut
     }
 
     SBPL_PRINTF("total highlevel expands this call = %d, planning time = %.3f secs, solution cost=%d\n",
-                highlevel_searchexpands, (clock() - TimeStarted) / ((double)CLOCKS_PER_SEC), PathCost);
+                highlevel_searchexpands, deadline.getelapsedsecs(), PathCost);
 
     //SBPL_FPRINTF(fStat, "%d %d\n", highlevel_searchexpands, MinPathCost);
 
@@ -37,7 +37,7 @@
 using namespace std;
 
 static unsigned int g_backups;
-static clock_t g_runtime = 0;
+static double g_runtime = 0;
 static double g_belldelta = INFINITECOST;
 
 VIPlanner::~VIPlanner()
@@ -106,10 +106,10 @@ void VIPlanner::PrintStatHeader(FILE* fOut)
     SBPL_FPRINTF(fOut, "iteration backups v(start)\n");
 }
 
-void VIPlanner::PrintStat(FILE* fOut, clock_t starttime)
+void VIPlanner::PrintStat(FILE* fOut, const SBPLDeadline& deadline)
 {
     SBPL_FPRINTF(fOut, "%d %d %f %f %d\n", viPlanner.iteration, g_backups,
-                 ((double)(clock() - starttime)) / CLOCKS_PER_SEC,
+                 deadline.getelapsedsecs(),
                  ((VIState*)(viPlanner.StartState->PlannerSpecificData))->v,
                  (unsigned int)viPlanner.MDP.StateArray.size());
 }
@@ -206,11 +206,11 @@ void VIPlanner::PrintPolicy(FILE* fPolicy)
     if (!bPrintStatOnly)
         SBPL_FPRINTF(fPolicy,
                      "backups=%d runtime=%f vstart=%f policyvalue=%f fullpolicy=%d Pc(goal)=%f nMerges=%d bCyc=%d\n",
-                     g_backups, (double)g_runtime / CLOCKS_PER_SEC,
+                     g_backups, g_runtime,
                      ((VIState*)(viPlanner.StartState->PlannerSpecificData))->v, PolicyValue, bFullPolicy, Pcgoal,
                      nMerges, bCycles);
     else
-        SBPL_FPRINTF(fPolicy, "%d %f %f %f %d %f %d %d\n", g_backups, (double)g_runtime / CLOCKS_PER_SEC,
+        SBPL_FPRINTF(fPolicy, "%d %f %f %f %d %f %d %d\n", g_backups, g_runtime,
                      ((VIState*)(viPlanner.StartState->PlannerSpecificData))->v, PolicyValue, bFullPolicy, Pcgoal,
                      nMerges, bCycles);
 }
@@ -378,26 +378,26 @@ int VIPlanner::replan(double allocatedtime, vector<int>* solution_stateIDs_V)
     InitializePlanner();
 
     //start the timer
-    clock_t starttime = clock();
+    SBPLDeadline deadline;
 
     //--------------iterate-------------------------------
-    while (((clock() - starttime) / (double)CLOCKS_PER_SEC) < allocatedtime && g_belldelta > MDP_ERRDELTA) {
+    while (deadline.getelapsedsecs() < allocatedtime && g_belldelta > MDP_ERRDELTA) {
         viPlanner.iteration++;
 
         g_belldelta = 0;
         perform_iteration_forward();
 
         if (viPlanner.iteration % 100 == 0) {
-            PrintStat(stdout, starttime);
-            PrintStat(fStat, starttime);
+            PrintStat(stdout, deadline);
+            PrintStat(fStat, deadline);
         }
     }
     //------------------------------------------------------------------
 
-    g_runtime = clock() - starttime;
+    g_runtime = deadline.getelapsedsecs();
 
-    PrintStat(stdout, starttime);
-    PrintStat(fStat, starttime);
+    PrintStat(stdout, deadline);
+    PrintStat(fStat, deadline);
     SBPL_FFLUSH(fStat);
 
     PrintPolicy(fPolicy);
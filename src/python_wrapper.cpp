@@ -83,7 +83,8 @@ public:
         const char* motPrimFilename,
         const py::safe_array<unsigned char>& map_data_array,
         EnvNAVXYTHETALAT_InitParms params,
-        bool computeKernels) {
+        bool computeKernels,
+        const std::string& kernelCacheDirectory) {
         auto footprint = footprint_array.unchecked<2>();
 
         std::vector<sbpl_2Dpt_t> perimeterptsV;
@@ -99,12 +100,24 @@ public:
             perimeterptsV.push_back(sbpl_2Dpt_t(footprint(i, 0), footprint(i, 1)));
         }
         const unsigned char* map_data = &map_data_array.unchecked<2>()(0, 0);
+        _environment.SetKernelCacheDirectory(kernelCacheDirectory.c_str());
         bool envInitialized = _environment.InitializeEnv(perimeterptsV, motPrimFilename, map_data, params, computeKernels);
         if (!envInitialized) {
             throw SBPL_Exception("ERROR: InitializeEnv failed");
         }
     }
 
+    // an environment that searches the lattice model of this one: it shares the costmap snapshot,
+    // the motion primitives and their kernels, and has its own states and heuristics
+    std::unique_ptr<EnvironmentNAVXYTHETALATWrapper> create_search_instance() const {
+        std::unique_ptr<EnvironmentNAVXYTHETALATWrapper> instance(new EnvironmentNAVXYTHETALATWrapper());
+        if (!instance->_environment.InitializeEnvFromModel(_environment.GetLatticeModel())) {
+            throw SBPL_Exception("ERROR: InitializeEnvFromModel failed");
+        }
+        instance->_environment.SetHeuristicCache(_environment.GetHeuristicCache());
+        return instance;
+    }
+
     const EnvironmentNAVXYTHETALAT& env() const {return this->_environment;}
     EnvironmentNAVXYTHETALAT& env() {return this->_environment;}
 
@@ -123,17 +136,22 @@ public:
     }
 
 
-    py::safe_array<unsigned char> get_costmap() const {
+    py::safe_array<unsigned char> get_costmap(bool copy) const {
+
+        // the costmap given to update_environment_costmap(zero_copy=True) is the one the environment uses
+        if (!copy && _costmap_owner) {
+            return py::reinterpret_borrow<py::safe_array<unsigned char>>(_costmap_owner);
+        }
 
         EnvNAVXYTHETALAT_InitParms params = this->get_params();
+        const EnvNAVXYTHETALATConfig_t* cfg = _environment.GetEnvNavConfig();
 
         py::safe_array<unsigned char> result_array({params.size_y, params.size_x});
-        auto result = result_array.mutable_unchecked();
+        unsigned char* p_result = &result_array.mutable_unchecked()(0, 0);
 
+        // the environment keeps the costmap row-major, same as numpy
         for (int y = 0; y < params.size_y; y++) {
-            for (int x = 0; x < params.size_x; x++) {
-                result(y, x) = _environment.GetMapCost(x, y);
-            }
+            memcpy(p_result + y * params.size_x, cfg->Grid2D + y * cfg->Grid2DStride, params.size_x);
         }
 
         return result_array;
@@ -184,6 +202,24 @@ public:
         return _environment.IsValidConfiguration(cell(0), cell(1), cell(2));
     }
 
+    py::safe_array<bool> is_valid_configurations(const py::safe_array<int>& cells_array) const {
+        auto cells = cells_array.unchecked<2>();
+
+        std::vector<sbpl_xy_theta_cell_t> configurations(cells_array.shape(0));
+        for (size_t i = 0; i < configurations.size(); i++) {
+            configurations[i] = sbpl_xy_theta_cell_t(cells(i, 0), cells(i, 1), cells(i, 2));
+        }
+        std::vector<bool> valid;
+        _environment.IsValidConfigurations(configurations, &valid);
+
+        py::safe_array<bool> result_array({(int)valid.size()});
+        auto result = result_array.mutable_unchecked();
+        for (size_t i = 0; i < valid.size(); i++) {
+            result(i) = valid[i];
+        }
+        return result_array;
+    }
+
     py::tuple get_cost_thresholds() const {
         const EnvNAVXYTHETALATConfig_t* pConfig = _environment.GetEnvNavConfig();
         return py::make_tuple(pConfig->obsthresh, pConfig->cost_inscribed_thresh, pConfig->cost_possibly_circumscribed_thresh);
@@ -211,33 +247,88 @@ public:
 
     }
 
+    void set_action_cost_threads(int num_threads, int min_actions) {
+        _environment.SetActionCostThreads(num_threads, min_actions);
+    }
+
+    void set_heuristic_threads(int num_threads) {
+        _environment.SetHeuristicThreads(num_threads);
+    }
+
+    void set_heuristic_cache(std::shared_ptr<SBPL2DGridSearchCache> cache) {
+        _environment.SetHeuristicCache(cache);
+    }
+
+    std::shared_ptr<SBPL2DGridSearchCache> get_heuristic_cache() const {
+        return _environment.GetHeuristicCache();
+    }
+
+    // computes the goal distances of the given (N, 2) goal cells into the heuristic cache
+    void precompute_goal_heuristics(const py::safe_array<int>& cells_array) {
+        if (cells_array.ndim() != 2 || cells_array.shape(1) != 2) {
+            throw SBPL_Exception("Goal cells have to be an (N, 2) array");
+        }
+        if (!_environment.GetHeuristicCache()) {
+            throw SBPL_Exception("The environment has no heuristic cache");
+        }
+        auto cells = cells_array.unchecked<2>();
+        std::vector<sbpl_2Dcell_t> goals(cells_array.shape(0));
+        for (size_t i = 0; i < goals.size(); i++) {
+            goals[i] = sbpl_2Dcell_t(cells(i, 0), cells(i, 1));
+        }
+
+        py::gil_scoped_release release;
+        for (size_t i = 0; i < goals.size(); i++) {
+            if (!_environment.PrecomputeGoalHeuristics(goals[i].x, goals[i].y)) {
+                throw SBPL_Exception("Goal cell is outside of the map");
+            }
+        }
+    }
+
     py::safe_array<int> update_environment_costmap(
-        const py::safe_array<unsigned char>& new_costmap_array)
+        py::safe_array<unsigned char> new_costmap_array, bool zero_copy)
     {
 
         auto params = this->get_params();
 
-        if (new_costmap_array.shape(0) != params.size_y ||
+        if (new_costmap_array.ndim() != 2 ||
+            new_costmap_array.shape(0) != params.size_y ||
             new_costmap_array.shape(1) != params.size_x) {
             throw SBPL_Exception("Costmap sizes do not match");
         }
 
-        auto new_costmap = new_costmap_array.unchecked<2>();
+        const unsigned char* new_costmap = new_costmap_array.data();
+        const EnvNAVXYTHETALATConfig_t* cfg = _environment.GetEnvNavConfig();
+
+        // the changes are found by comparing with the costmap of the environment,
+        // which does not work with the same buffer in either mode
+        if (new_costmap + (size_t)params.size_x * params.size_y > cfg->Grid2D &&
+            new_costmap < cfg->Grid2D + (size_t)cfg->Grid2DStride * params.size_y) {
+            throw SBPL_Exception("Costmap is already used by the environment, changes made in place can not be detected");
+        }
 
+        // simulate sensing the cells: store the ones we haven't seen before
         std::vector<nav2dcell_t> changedcellsV;
-        // simulate sensing the cells
-        for (int x = 0; x < (int)params.size_x; x++) {
-            for (int y = 0; y < (int)params.size_y; y++) {
-                unsigned char truecost = new_costmap(y, x);
-                // update the cell if we haven't seen it before
-                if (_environment.GetMapCost(x, y) != truecost) {
-                    _environment.UpdateCost(x, y, truecost);
-                    // store the changed cells
-                    nav2dcell_t nav2dcell;
-                    nav2dcell.x = x;
-                    nav2dcell.y = y;
-                    changedcellsV.push_back(nav2dcell);
-                }
+        {
+            // the comparison and the copy only touch the buffers, so other python
+            // threads can run meanwhile (but must not write to new_costmap_array)
+            py::gil_scoped_release release;
+            get_changed_cells(cfg->Grid2D, cfg->Grid2DStride, new_costmap, params.size_x,
+                              params.size_x, params.size_y, &changedcellsV);
+
+            if (!changedcellsV.empty() && !zero_copy) {
+                // take the whole costmap at once, the heuristics are repaired around the changed cells
+                _environment.SetMap(new_costmap, changedcellsV);
+            }
+        }
+
+        if (!changedcellsV.empty()) {
+            if (zero_copy) {
+                // plan on the numpy buffer directly and keep it alive for as long as it is used
+                _environment.SetMapBuffer(new_costmap_array.mutable_data(), params.size_x, changedcellsV);
+                set_costmap_owner(new_costmap_array);
+            } else {
+                set_costmap_owner(py::object());
             }
         }
 
@@ -249,16 +340,43 @@ public:
     }
 
 
+    ~EnvironmentNAVXYTHETALATWrapper() {
+        try {
+            set_costmap_owner(py::object());
+        } catch (py::error_already_set&) {
+            // the owner can not be made writeable again (its base has been made read-only meanwhile)
+        }
+    }
+
 private:
+    EnvironmentNAVXYTHETALATWrapper() {}
+
+    // the environment plans on the buffer of costmap_owner (or on its own if it is None), which is read-only
+    // while it is used: an edit in place would not be seen by the obstacle mask and the heuristics
+    void set_costmap_owner(py::object costmap_owner) {
+        if (_costmap_owner) {
+            _costmap_owner.attr("flags").attr("writeable") = true;
+        }
+        if (costmap_owner) {
+            costmap_owner.attr("flags").attr("writeable") = false;
+        }
+        _costmap_owner = costmap_owner;
+    }
+
     EnvironmentNAVXYTHETALAT _environment;
+    // numpy array that owns the costmap buffer of the environment (if it is not owned by the environment itself)
+    py::object _costmap_owner;
 
 };
 
 
 class SBPLPlannerWrapper {
 public:
-    SBPLPlannerWrapper(SBPLPlanner* pPlanner)
+    SBPLPlannerWrapper(SBPLPlanner* pPlanner, bool bsupportsreplanparams, double initialEpsilon)
        : _pPlanner(pPlanner)
+       , _bSupportsReplanParams(bsupportsreplanparams)
+       , _initialEpsilon(initialEpsilon)
+       , _bSearchUntilFirstSolution(false)
     {
 
     }
@@ -285,6 +403,8 @@ public:
     void set_planning_params(double initialEpsilon, bool searchUntilFirstSolution) {
         _pPlanner->set_initialsolution_eps(initialEpsilon);
         _pPlanner->set_search_mode(searchUntilFirstSolution);
+        _initialEpsilon = initialEpsilon;
+        _bSearchUntilFirstSolution = searchUntilFirstSolution;
     }
 
     void apply_environment_changes(const py::safe_array<int>& changedcells_array,
@@ -315,26 +435,50 @@ public:
     py::tuple replan(
             EnvironmentNAVXYTHETALATWrapper& envWrapper,
             double allocated_time_secs_foreachplan,
-            double final_eps) {
+            double final_eps,
+            const SBPLCancelToken* cancel_token) {
         double plan_time, solution_epsilon;
         std::vector<sbpl_xy_theta_pt_t> xythetaPath;
         std::vector<sbpl_xy_theta_cell_t> xythetaCellPath;
 
-        double TimeStarted = clock();
+        if (cancel_token != NULL && !_bSupportsReplanParams) {
+            throw SBPL_Exception("ERROR: this planner does not support cancel tokens");
+        }
+
+        SBPLDeadline deadline;
         std::vector<int> solution_stateIDs_V;
 
         _pPlanner->set_finalsolution_eps(final_eps);
 
-        bool bPlanExists = (_pPlanner->replan(allocated_time_secs_foreachplan, &solution_stateIDs_V) == 1);
+        std::vector<EnvNAVXYTHETALATAction_t> action_list;
+        {
+            // the search and the path conversion do not touch python objects, so
+            // other python threads (e.g. one that cancels the token or runs
+            // another planner) can run meanwhile
+            py::gil_scoped_release release;
+            if (cancel_token != NULL) {
+                ReplanParams params(allocated_time_secs_foreachplan);
+                params.initial_eps = _initialEpsilon;
+                params.final_eps = final_eps;
+                params.return_first_solution = _bSearchUntilFirstSolution;
+                params.cancel_token = cancel_token;
+                _pPlanner->replan(&solution_stateIDs_V, params);
+            }
+            else {
+                _pPlanner->replan(allocated_time_secs_foreachplan, &solution_stateIDs_V);
+            }
 
-        plan_time = (clock() - TimeStarted) / ((double)CLOCKS_PER_SEC);
-        solution_epsilon = _pPlanner->get_solution_eps();
+            plan_time = deadline.getelapsedsecs();
+            solution_epsilon = _pPlanner->get_solution_eps();
+
+            envWrapper.env().ConvertStateIDPathintoXYThetaPath(&solution_stateIDs_V, &xythetaPath);
+            for (int j = 1; j < (int)solution_stateIDs_V.size(); j++) {
+                sbpl_xy_theta_cell_t xytheta_cell;
+                envWrapper.env().GetCoordFromState(solution_stateIDs_V[j], xytheta_cell.x, xytheta_cell.y, xytheta_cell.theta);
+                xythetaCellPath.push_back(xytheta_cell);
+            }
 
-        envWrapper.env().ConvertStateIDPathintoXYThetaPath(&solution_stateIDs_V, &xythetaPath);
-        for (int j = 1; j < (int)solution_stateIDs_V.size(); j++) {
-            sbpl_xy_theta_cell_t xytheta_cell;
-            envWrapper.env().GetCoordFromState(solution_stateIDs_V[j], xytheta_cell.x, xytheta_cell.y, xytheta_cell.theta);
-            xythetaCellPath.push_back(xytheta_cell);
+            envWrapper.env().GetActionsFromStateIDPath(&solution_stateIDs_V, &action_list);
         }
 
         py::safe_array<double> xytheta_path_array({(int)xythetaPath.size(), 3});
@@ -345,8 +489,6 @@ public:
         int* p_xytheta_cell_path = &xytheta_cell_path_array.mutable_unchecked()(0, 0);
         memcpy(p_xytheta_cell_path, &xythetaCellPath[0], sizeof(int)*xythetaCellPath.size()*3);
 
-        std::vector<EnvNAVXYTHETALATAction_t> action_list;
-        envWrapper.env().GetActionsFromStateIDPath(&solution_stateIDs_V, &action_list);
         py::safe_array<int> action_array({(int)action_list.size(), 2});
         auto actions = action_array.mutable_unchecked<2>();
         for (int i = 0; i < action_list.size(); ++i) {
@@ -392,6 +534,33 @@ public:
 
 private:
     SBPLPlanner* _pPlanner;
+    bool _bSupportsReplanParams;
+    double _initialEpsilon; // kept for the ReplanParams passed with a cancel token
+    bool _bSearchUntilFirstSolution;
+};
+
+
+// whether a planner implements replan() with ReplanParams (and so honors cancel
+// tokens) and the initial epsilon it starts with
+template<typename PlannerT>
+struct PlannerReplanParamsSupport {
+    static const bool value = false;
+    static double initial_eps() { return ReplanParams(0.0).initial_eps; }
+};
+template<>
+struct PlannerReplanParamsSupport<ARAPlanner> {
+    static const bool value = true;
+    static double initial_eps() { return ARA_DEFAULT_INITIAL_EPS; }
+};
+template<>
+struct PlannerReplanParamsSupport<ADPlanner> {
+    static const bool value = true;
+    static double initial_eps() { return AD_DEFAULT_INITIAL_EPS; }
+};
+template<>
+struct PlannerReplanParamsSupport<LazyARAPlanner> {
+    static const bool value = true;
+    static double initial_eps() { return ReplanParams(0.0).initial_eps; }
 };
 
 
@@ -400,7 +569,9 @@ class SpecificPlannerWrapper: public SBPLPlannerWrapper {
 public:
     SpecificPlannerWrapper(EnvironmentNAVXYTHETALATWrapper& envWrapper, bool bforwardsearch)
        : _planner(&envWrapper.env(), bforwardsearch)
-       , SBPLPlannerWrapper(&_planner)
+       , SBPLPlannerWrapper(&_planner,
+                            PlannerReplanParamsSupport<PlannerT>::value,
+                            PlannerReplanParamsSupport<PlannerT>::initial_eps())
     {
 
     }
@@ -409,13 +580,140 @@ private:
 };
 
 
-typedef SpecificPlannerWrapper<ARAPlanner> ARAPlannerWrapper;
+class ARAPlannerWrapper: public SpecificPlannerWrapper<ARAPlanner> {
+public:
+    ARAPlannerWrapper(EnvironmentNAVXYTHETALATWrapper& envWrapper, bool bforwardsearch)
+       : SpecificPlannerWrapper<ARAPlanner>(envWrapper, bforwardsearch)
+    {
+
+    }
+
+    // "heap" (the default) or "bucket_queue"
+    void set_open_type(const std::string& open_type) {
+        SBPL_OPENTYPE OPENtype;
+        if (open_type == "heap") {
+            OPENtype = SBPL_OPENTYPE_HEAP;
+        }
+        else if (open_type == "bucket_queue") {
+            OPENtype = SBPL_OPENTYPE_BUCKETQUEUE;
+        }
+        else {
+            throw SBPL_Exception("ERROR: unknown OPEN type " + open_type);
+        }
+        static_cast<ARAPlanner*>(planner())->set_OPEN_type(OPENtype);
+    }
+};
+
 typedef SpecificPlannerWrapper<ADPlanner> ADPlannerWrapper;
 typedef SpecificPlannerWrapper<anaPlanner> anaPlannerWrapper;
 typedef SpecificPlannerWrapper<LazyARAPlanner> LazyARAPlannerWrapper;
 typedef SpecificPlannerWrapper<RSTARPlanner> RSTARPlannerWrapper;
 
 
+class BatchPlannerWrapper {
+public:
+    BatchPlannerWrapper(const EnvironmentNAVXYTHETALATWrapper& envWrapper, bool bforwardsearch, int numthreads)
+       : _planner(&envWrapper.env(), bforwardsearch, numthreads)
+    {
+
+    }
+
+    int get_num_threads() const { return _planner.getnumthreads(); }
+
+    py::tuple plan(
+            const py::safe_array<double>& starts_array,
+            const py::safe_array<double>& goals_array,
+            double allocated_time_secs_foreachplan,
+            double initial_eps,
+            double final_eps,
+            bool search_until_first_solution,
+            bool check_collisions,
+            const SBPLCancelToken* cancel_token) {
+
+        if (starts_array.ndim() != 2 || starts_array.shape(1) != 3 ||
+            goals_array.ndim() != 2 || goals_array.shape(1) != 3 ||
+            starts_array.shape(0) != goals_array.shape(0)) {
+            throw SBPL_Exception("Starts and goals have to be Nx3 arrays of the same size");
+        }
+
+        auto starts = starts_array.unchecked<2>();
+        auto goals = goals_array.unchecked<2>();
+        std::vector<sbpl_xy_theta_pt_t> startsV(starts_array.shape(0));
+        std::vector<sbpl_xy_theta_pt_t> goalsV(goals_array.shape(0));
+        for (size_t i = 0; i < startsV.size(); i++) {
+            startsV[i] = sbpl_xy_theta_pt_t(starts(i, 0), starts(i, 1), starts(i, 2));
+            goalsV[i] = sbpl_xy_theta_pt_t(goals(i, 0), goals(i, 1), goals(i, 2));
+        }
+
+        ReplanParams params(allocated_time_secs_foreachplan);
+        params.initial_eps = initial_eps;
+        params.final_eps = final_eps;
+        params.return_first_solution = search_until_first_solution;
+        params.cancel_token = cancel_token;
+
+        std::vector<BatchPlanResult> results;
+        {
+            py::gil_scoped_release release;
+            _planner.plan(startsV, goalsV, params, check_collisions, &results);
+        }
+
+        // the paths of all the queries are stacked, the ones of query i are
+        // the rows offsets[i]:offsets[i + 1]
+        const int numofqueries = (int)results.size();
+        py::safe_array<int> path_offsets_array({numofqueries + 1});
+        py::safe_array<int> cell_path_offsets_array({numofqueries + 1});
+        auto path_offsets = path_offsets_array.mutable_unchecked();
+        auto cell_path_offsets = cell_path_offsets_array.mutable_unchecked();
+        path_offsets(0) = 0;
+        cell_path_offsets(0) = 0;
+        for (int i = 0; i < numofqueries; i++) {
+            path_offsets(i + 1) = path_offsets(i) + (int)results[i].xythetaPath.size();
+            cell_path_offsets(i + 1) = cell_path_offsets(i) + (int)results[i].xythetaCellPath.size();
+        }
+
+        py::safe_array<double> xytheta_paths_array({path_offsets(numofqueries), 3});
+        py::safe_array<int> xytheta_cell_paths_array({cell_path_offsets(numofqueries), 3});
+        py::safe_array<int> status_array({numofqueries});
+        py::safe_array<int> cost_array({numofqueries});
+        py::safe_array<double> eps_array({numofqueries});
+        py::safe_array<double> time_array({numofqueries});
+        py::safe_array<int> expands_array({numofqueries});
+        double* p_xytheta_paths = xytheta_paths_array.mutable_data();
+        int* p_xytheta_cell_paths = xytheta_cell_paths_array.mutable_data();
+        auto status = status_array.mutable_unchecked();
+        auto cost = cost_array.mutable_unchecked();
+        auto eps = eps_array.mutable_unchecked();
+        auto plan_time = time_array.mutable_unchecked();
+        auto expands = expands_array.mutable_unchecked();
+        for (int i = 0; i < numofqueries; i++) {
+            const BatchPlanResult& result = results[i];
+            memcpy(p_xytheta_paths + 3 * path_offsets(i), result.xythetaPath.data(),
+                   sizeof(double) * result.xythetaPath.size() * 3);
+            memcpy(p_xytheta_cell_paths + 3 * cell_path_offsets(i), result.xythetaCellPath.data(),
+                   sizeof(int) * result.xythetaCellPath.size() * 3);
+            status(i) = result.status;
+            cost(i) = result.cost;
+            eps(i) = result.eps;
+            plan_time(i) = result.time;
+            expands(i) = result.expands;
+        }
+
+        py::dict stats;
+        stats["status"] = status_array;
+        stats["cost"] = cost_array;
+        stats["eps"] = eps_array;
+        stats["time"] = time_array;
+        stats["expands"] = expands_array;
+
+        return py::make_tuple(xytheta_paths_array, path_offsets_array,
+                              xytheta_cell_paths_array, cell_path_offsets_array, stats);
+    }
+
+private:
+    BatchPlanner _planner;
+};
+
+
 class IncrementalSensingWrapper {
 public:
     IncrementalSensingWrapper(int sensingRange) {
@@ -442,26 +740,30 @@ public:
         auto params = true_environment_wrapper.get_params();
 
         std::vector<nav2dcell_t> changedcellsV;
-        // simulate sensing the cells
-        for (int i = 0; i < (int)_sensecells.size(); i++) {
-            int x = CONTXY2DISC(startx, params.cellsize_m) + _sensecells.at(i).x;
-            int y = CONTXY2DISC(starty, params.cellsize_m) + _sensecells.at(i).y;
-
-            // ignore if outside the map
-            if (x < 0 || x >= params.size_x || y < 0 || y >= params.size_y) {
-                continue;
-            }
+        {
+            // only the environments are touched here, so other python threads can run
+            py::gil_scoped_release release;
+            // simulate sensing the cells
+            for (int i = 0; i < (int)_sensecells.size(); i++) {
+                int x = CONTXY2DISC(startx, params.cellsize_m) + _sensecells.at(i).x;
+                int y = CONTXY2DISC(starty, params.cellsize_m) + _sensecells.at(i).y;
+
+                // ignore if outside the map
+                if (x < 0 || x >= params.size_x || y < 0 || y >= params.size_y) {
+                    continue;
+                }
 
-            int index = x + y * params.size_x;
-            unsigned char truecost = true_environment.GetMapCost(x, y);
-            // update the cell if we haven't seen it before
-            if (environment_to_update.GetMapCost(x, y) != truecost) {
-                environment_to_update.UpdateCost(x, y, truecost);
-                // store the changed cells
-                nav2dcell_t nav2dcell;
-                nav2dcell.x = x;
-                nav2dcell.y = y;
-                changedcellsV.push_back(nav2dcell);
+                int index = x + y * params.size_x;
+                unsigned char truecost = true_environment.GetMapCost(x, y);
+                // update the cell if we haven't seen it before
+                if (environment_to_update.GetMapCost(x, y) != truecost) {
+                    environment_to_update.UpdateCost(x, y, truecost);
+                    // store the changed cells
+                    nav2dcell_t nav2dcell;
+                    nav2dcell.x = x;
+                    nav2dcell.y = y;
+                    changedcellsV.push_back(nav2dcell);
+                }
             }
         }
 
@@ -502,17 +804,48 @@ PYBIND11_MODULE(_sbpl_module, m) {
                      const char*,
                      const py::safe_array<unsigned char>&,
                      EnvNAVXYTHETALAT_InitParms,
-                     bool>())
+                     bool,
+                     const std::string&>(),
+           "footprint"_a,
+           "motion_primitives_filename"_a,
+           "map_data"_a,
+           "params"_a,
+           "compute_kernels"_a,
+           "kernel_cache_dir"_a=""
+       )
+       .def("create_search_instance", &EnvironmentNAVXYTHETALATWrapper::create_search_instance)
        .def("get_params", &EnvironmentNAVXYTHETALATWrapper::get_params)
-       .def("get_costmap", &EnvironmentNAVXYTHETALATWrapper::get_costmap)
+       .def("get_costmap", &EnvironmentNAVXYTHETALATWrapper::get_costmap,
+           "copy"_a=true
+       )
        .def("get_motion_primitives_list", &EnvironmentNAVXYTHETALATWrapper::get_motion_primitives)
        .def("xytheta_real_to_cell", &EnvironmentNAVXYTHETALATWrapper::xytheta_real_to_cell)
        .def("xytheta_cell_to_real", &EnvironmentNAVXYTHETALATWrapper::xytheta_cell_to_real)
        .def("is_valid_configuration", &EnvironmentNAVXYTHETALATWrapper::is_valid_configuration)
+       .def("is_valid_configurations", &EnvironmentNAVXYTHETALATWrapper::is_valid_configurations,
+           "cells"_a
+       )
        .def("get_cost_thresholds", &EnvironmentNAVXYTHETALATWrapper::get_cost_thresholds)
        .def("get_primitive_collision_pixels", &EnvironmentNAVXYTHETALATWrapper::get_primitive_collision_pixels)
        .def("set_primitive_collision_pixels", &EnvironmentNAVXYTHETALATWrapper::set_primitive_collision_pixels)
-       .def("update_environment_costmap", &EnvironmentNAVXYTHETALATWrapper::update_environment_costmap)
+       .def("set_action_cost_threads", &EnvironmentNAVXYTHETALATWrapper::set_action_cost_threads,
+           "num_threads"_a,
+           "min_actions"_a=NAVXYTHETALAT_DEFAULT_ACTIONCOSTMINBATCH
+       )
+       .def("set_heuristic_threads", &EnvironmentNAVXYTHETALATWrapper::set_heuristic_threads,
+           "num_threads"_a
+       )
+       .def("set_heuristic_cache", &EnvironmentNAVXYTHETALATWrapper::set_heuristic_cache,
+           "cache"_a
+       )
+       .def("get_heuristic_cache", &EnvironmentNAVXYTHETALATWrapper::get_heuristic_cache)
+       .def("precompute_goal_heuristics", &EnvironmentNAVXYTHETALATWrapper::precompute_goal_heuristics,
+           "cells"_a
+       )
+       .def("update_environment_costmap", &EnvironmentNAVXYTHETALATWrapper::update_environment_costmap,
+           "new_costmap"_a,
+           "zero_copy"_a=false
+       )
     ;
 
     py::class_<EnvNAVXYTHETALAT_InitParms>(m, "EnvNAVXYTHETALAT_InitParms")
@@ -537,6 +870,22 @@ PYBIND11_MODULE(_sbpl_module, m) {
     ;
 
 
+    py::class_<SBPL2DGridSearchCache, std::shared_ptr<SBPL2DGridSearchCache> >(m, "HeuristicCache")
+        .def(py::init<int>(),
+            "max_fields"_a=16
+        )
+        .def("get_num_fields", &SBPL2DGridSearchCache::getnumfields)
+        .def("get_max_fields", &SBPL2DGridSearchCache::getmaxfields)
+        .def("clear", &SBPL2DGridSearchCache::clear)
+    ;
+
+    py::class_<SBPLCancelToken>(m, "CancelToken")
+        .def(py::init<>())
+        .def("cancel", &SBPLCancelToken::cancel)
+        .def("reset", &SBPLCancelToken::reset)
+        .def("cancelled", &SBPLCancelToken::cancelled)
+    ;
+
     py::class_<SBPLPlannerWrapper> base_planner(m, "SBPLPlannerWrapper");
     base_planner
         .def("set_start_goal_from_env", &SBPLPlannerWrapper::set_start_goal_from_env)
@@ -548,7 +897,10 @@ PYBIND11_MODULE(_sbpl_module, m) {
         .def("replan", &SBPLPlannerWrapper::replan,
             "environment"_a,
             "allocated_time"_a,
-            "final_epsilon"_a
+            "final_epsilon"_a,
+            "cancel_token"_a = static_cast<const SBPLCancelToken*>(nullptr),
+            "Releases the GIL while searching. The planner and its environment must not be used\n"
+            "from other threads until it returns, except for cancelling cancel_token."
         )
         .def("set_start", &SBPLPlannerWrapper::set_start)
         .def("set_goal", &SBPLPlannerWrapper::set_goal)
@@ -556,6 +908,11 @@ PYBIND11_MODULE(_sbpl_module, m) {
 
     py::class_<ARAPlannerWrapper>(m, "ARAPlanner", base_planner)
        .def(py::init<EnvironmentNAVXYTHETALATWrapper&, bool>())
+       .def("set_open_type", &ARAPlannerWrapper::set_open_type,
+           "open_type"_a,
+           "\"heap\" (the default) or \"bucket_queue\", a bucket per integer key that is faster\n"
+           "when the keys in OPEN lie close together."
+       )
     ;
 
     py::class_<ADPlannerWrapper>(m, "ADPlanner", base_planner)
@@ -574,6 +931,30 @@ PYBIND11_MODULE(_sbpl_module, m) {
        .def(py::init<EnvironmentNAVXYTHETALATWrapper&, bool>())
     ;
 
+    py::class_<BatchPlannerWrapper>(m, "BatchPlanner")
+        .def(py::init<const EnvironmentNAVXYTHETALATWrapper&, bool, int>(),
+            "environment"_a,
+            "forward_search"_a,
+            "num_threads"_a = 0,
+            py::keep_alive<1, 2>()
+        )
+        .def("get_num_threads", &BatchPlannerWrapper::get_num_threads)
+        .def("plan", &BatchPlannerWrapper::plan,
+            "starts"_a,
+            "goals"_a,
+            "allocated_time"_a,
+            "initial_epsilon"_a,
+            "final_epsilon"_a,
+            "search_until_first_solution"_a = false,
+            "check_collisions"_a = true,
+            "cancel_token"_a = static_cast<const SBPLCancelToken*>(nullptr),
+            "Plans from starts[i] to goals[i] (Nx3 arrays of poses) for every i with ARA* on a pool of threads.\n"
+            "Returns the stacked paths with their row offsets per query, the stacked cell paths with theirs\n"
+            "and a dict of per query arrays: status (1 found, 0 not found, -1 invalid start or goal), cost,\n"
+            "eps, time and expands. Releases the GIL, the environment must not change until it returns."
+        )
+    ;
+
     py::class_<IncrementalSensingWrapper>(m, "IncrementalSensing")
         .def(py::init<int>())
         .def("sense_environment", &IncrementalSensingWrapper::sense_environment)
@@ -147,7 +147,7 @@ void navigationIteration(
         }
     }
 
-    double TimeStarted = clock();
+    SBPLDeadline deadline;
 
     // if necessary notify the planner of changes to costmap
     if (bChanges) {
@@ -177,7 +177,7 @@ void navigationIteration(
            planner->get_solution_eps());
     environment_navxythetalat.PrintTimeStat(stdout);
 
-    plan_time = (clock() - TimeStarted) / ((double)CLOCKS_PER_SEC);
+    plan_time = deadline.getelapsedsecs();
     solution_epsilon = planner->get_solution_eps();
 
     environment_navxythetalat.ConvertStateIDPathintoXYThetaPath(&solution_stateIDs_V, &xythetaPath);
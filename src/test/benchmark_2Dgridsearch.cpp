@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2008, Maxim Likhachev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Carnegie Mellon University nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Times SBPL2DGridSearch over all the cells of a large random grid, with the
+// heap and with SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS on 1 to
+// <max threads> threads, and checks that every search has the values of the
+// heap, e.g.
+//
+//   g++ -O3 -Isrc/include src/test/benchmark_2Dgridsearch.cpp -Lbuild -lsbpl -o benchmark_2Dgridsearch
+//   ./benchmark_2Dgridsearch 4000 4000 8
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <sbpl/headers.h>
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 4) {
+        printf("USAGE: %s <width> <height> <max threads>\n", argv[0]);
+        return 1;
+    }
+    const int width = atoi(argv[1]);
+    const int height = atoi(argv[2]);
+    const int maxnumthreads = atoi(argv[3]);
+    const unsigned char obsthresh = 254;
+
+    //mostly free cells with some cost, and a tenth of obstacles
+    srand(0);
+    std::vector<unsigned char> map(width * height);
+    for (size_t i = 0; i < map.size(); i++) {
+        map[i] = (rand() % 10 == 0) ? obsthresh : rand() % 50;
+    }
+    const int startx = width / 2, starty = height / 2;
+    map[startx + width * starty] = 0;
+
+    printf("all the cells of a %dx%d grid\n", width, height);
+    SBPL2DGridSearch heapsearch(width, height, 0.025f);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    heapsearch.search(&map[0], width, obsthresh, startx, starty, 0, 0, SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS);
+    printf("  heap                 %8.3f secs\n", SecondsSince(start));
+
+    int numoffailures = 0;
+    for (int numthreads = 1; numthreads <= maxnumthreads; numthreads++) {
+        SBPL2DGridSearch search(width, height, 0.025f);
+        search.setOPENdatastructure(SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS);
+        search.setnumthreads(numthreads);
+        start = std::chrono::steady_clock::now();
+        search.search(&map[0], width, obsthresh, startx, starty, 0, 0, SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS);
+        double seconds = SecondsSince(start);
+
+        int numofwrongvalues = 0;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (search.getlowerboundoncostfromstart_inmm(x, y) != heapsearch.getlowerboundoncostfromstart_inmm(x, y)) {
+                    numofwrongvalues++;
+                }
+            }
+        }
+        printf("  parallel, %2d threads %8.3f secs, %d wrong values\n", numthreads, seconds, numofwrongvalues);
+        numoffailures += numofwrongvalues;
+    }
+    return numoffailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2008, Maxim Likhachev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Carnegie Mellon University nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Compares the binary CHeap with CDaryHeap and CBucketHeap, first on a
+// synthetic OPEN list workload and then as the OPEN list of ARA*, AD* and
+// LazyARA on the xytheta lattice, e.g.
+//
+//   g++ -O3 -Isrc/include src/test/benchmark_heap.cpp -Lbuild -lsbpl -o benchmark_heap
+//   ./benchmark_heap env_examples/nav3d/env1.cfg matlab/mprim/pr2.mprim
+//   ./benchmark_heap env_examples/nav3d/cubicle-25mm-inflated-env.cfg matlab/mprim/pr2_all_2.5cm_20turncost.mprim
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <sbpl/headers.h>
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// expands numexpands states: every expansion takes the min off the heap,
+// inserts a few successors with larger keys and lowers the keys of a few
+// states that are already in the heap
+template <typename HEAP>
+static void RunHeapWorkload(HEAP* heap, std::vector<AbstractSearchState>* states, int numexpands,
+                            double* seconds, long int* checksum)
+{
+    srand(0);
+    int numstates = (int)states->size();
+    int nextstate = 1;
+    CKey key;
+    *checksum = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    heap->insertheap(&(*states)[0], key);
+    for (int i = 0; i < numexpands && !heap->emptyheap(); i++) {
+        CKey minkey = heap->getminkeyheap();
+        heap->deleteminheap();
+        *checksum += minkey.key[0];
+
+        for (int succ = 0; succ < 8 && nextstate < numstates; succ++) {
+            key.key[0] = minkey.key[0] + 1 + rand() % 1000;
+            key.key[1] = rand() % 1000;
+            heap->insertheap(&(*states)[nextstate++], key);
+        }
+        for (int update = 0; update < 2; update++) {
+            AbstractSearchState* state = &(*states)[rand() % nextstate];
+            if (heap->inheap(state)) {
+                key = heap->getkeyheap(state);
+                key.key[0] -= __min(key.key[0] - minkey.key[0], (long int)(rand() % 100));
+                heap->updateheap(state, key);
+            }
+        }
+    }
+    *seconds = SecondsSince(start);
+    heap->makeemptyheap();
+}
+
+static void BenchmarkHeaps(int numexpands)
+{
+    std::vector<AbstractSearchState> states(8 * numexpands + 1);
+    for (size_t i = 0; i < states.size(); i++) {
+        states[i].heapindex = 0;
+    }
+    double seconds;
+    long int checksum;
+
+    printf("synthetic OPEN list workload, %d expansions\n", numexpands);
+    {
+        CHeap heap;
+        RunHeapWorkload(&heap, &states, numexpands, &seconds, &checksum);
+        printf("  CHeap                      %8.3f secs (checksum %ld)\n", seconds, checksum);
+    }
+    const int arities[] = { 2, 4, 8 };
+    const int keysizes[] = { KEY_SIZE, 1 };
+    for (int i = 0; i < 3; i++) {
+        for (int k = 0; k < 2; k++) {
+            CDaryHeap heap(arities[i], keysizes[k]);
+            RunHeapWorkload(&heap, &states, numexpands, &seconds, &checksum);
+            printf("  CDaryHeap arity %d keysize %d %8.3f secs (checksum %ld)\n",
+                        arities[i], keysizes[k], seconds, checksum);
+        }
+    }
+    {
+        CBucketHeap heap;
+        RunHeapWorkload(&heap, &states, numexpands, &seconds, &checksum);
+        printf("  CBucketHeap                %8.3f secs (checksum %ld)\n", seconds, checksum);
+    }
+}
+
+static void BenchmarkPlanners(const char* envCfgFilename, const char* motPrimFilename)
+{
+    const char* plannerNames[] = { "ARA*", "AD*", "LazyARA" };
+    //arity 0 runs ARA* with the bucket queue
+    const int arities[] = { 2, 4, 8, 0 };
+
+    printf("%s with %s\n", envCfgFilename, motPrimFilename);
+    for (int p = 0; p < 3; p++) {
+        for (int i = 0; i < 4; i++) {
+            if (arities[i] == 0 && p != 0) {
+                continue;
+            }
+            EnvironmentNAVXYTHETALAT env;
+            std::vector<sbpl_2Dpt_t> perimeter;
+            if (!env.InitializeEnv(envCfgFilename, perimeter, motPrimFilename)) {
+                throw SBPL_Exception("ERROR: InitializeEnv failed");
+            }
+            MDPConfig MDPCfg;
+            if (!env.InitializeMDPCfg(&MDPCfg)) {
+                throw SBPL_Exception("ERROR: InitializeMDPCfg failed");
+            }
+
+            SBPLPlanner* planner;
+            if (p == 0 && arities[i] == 0) {
+                ARAPlanner* araplanner = new ARAPlanner(&env, true);
+                araplanner->set_OPEN_type(SBPL_OPENTYPE_BUCKETQUEUE);
+                planner = araplanner;
+            }
+            else if (p == 0) {
+                planner = new ARAPlanner(&env, true, arities[i]);
+            }
+            else if (p == 1) {
+                planner = new ADPlanner(&env, true, arities[i]);
+            }
+            else {
+                planner = new LazyARAPlanner(&env, true, arities[i]);
+            }
+            planner->set_start(MDPCfg.startstateid);
+            planner->set_goal(MDPCfg.goalstateid);
+            planner->set_initialsolution_eps(3.0);
+            planner->set_search_mode(false);
+
+            ReplanParams params(60.0);
+            params.initial_eps = 3.0;
+            params.final_eps = 1.0;
+            params.dec_eps = 0.2;
+            params.return_first_solution = false;
+            params.repair_time = -1;
+
+            std::vector<int> solution;
+            int solcost = 0;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            int ret = planner->replan(&solution, params, &solcost);
+            double seconds = SecondsSince(start);
+            char OPENname[32];
+            if (arities[i] == 0) {
+                sprintf(OPENname, "buckets");
+            }
+            else {
+                sprintf(OPENname, "arity %d", arities[i]);
+            }
+            printf("  %-8s %-8s %8.3f secs, %d expands, solved %d, cost %d, eps %.2f\n",
+                        plannerNames[p], OPENname, seconds, planner->get_n_expands(), ret, solcost,
+                        planner->get_solution_eps());
+            delete planner;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc % 2 != 1) {
+        printf("USAGE: %s [<env cfg> <mot prims>]...\n", argv[0]);
+        return 1;
+    }
+
+    try {
+        BenchmarkHeaps(2000000);
+        for (int i = 1; i + 1 < argc; i += 2) {
+            BenchmarkPlanners(argv[i], argv[i + 1]);
+        }
+    }
+    catch (SBPL_Exception& e) {
+        printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
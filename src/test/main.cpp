@@ -587,7 +587,7 @@ int planxythetamlevlat(PlannerType plannerType, char* envCfgFilename, char* motP
     //cost_inscribed_thresh parameters in environment_navxythetalat.h file)
     int addlevind = 0;
     if (!environment_navxythetalat.Set2DMapforAddLev(
-            (const unsigned char**)(environment_navxythetalat.GetEnvNavConfig()->Grid2D), addlevind))
+            (const unsigned char*)(environment_navxythetalat.GetEnvNavConfig()->Grid2D), addlevind))
     {
         std::stringstream ss("ERROR: Setting Map for the Additional Level failed with level ");
         ss << addlevind;
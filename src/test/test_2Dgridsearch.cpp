@@ -0,0 +1,512 @@
+/*
+ * Copyright (c) 2008, Maxim Likhachev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Carnegie Mellon University nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Checks SBPL2DGridSearch, its repair and its cache against searches from
+// scratch. Run it from the root of the repository, e.g.
+//
+//   g++ -O3 -Isrc/include src/test/test_2Dgridsearch.cpp -Lbuild -lsbpl -o test_2Dgridsearch
+//   ./test_2Dgridsearch
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <sbpl/headers.h>
+
+static const int WIDTH = 120;
+static const int HEIGHT = 90;
+static const unsigned char OBSTHRESH = 200;
+
+static int numoffailures = 0;
+
+static void Check(bool condition, const char* what)
+{
+    if (!condition) {
+        printf("FAILED: %s\n", what);
+        numoffailures++;
+    }
+}
+
+// a random map with free start and goal cells
+static std::vector<unsigned char> RandomMap(int startx, int starty, int goalx, int goaly)
+{
+    std::vector<unsigned char> map(WIDTH * HEIGHT);
+    for (size_t i = 0; i < map.size(); i++) {
+        map[i] = (rand() % 5 == 0) ? 254 : rand() % 50;
+    }
+    map[startx + WIDTH * starty] = 0;
+    map[goalx + WIDTH * goaly] = 0;
+    return map;
+}
+
+// returns true if search has the values of a search from scratch over map
+static bool SameAsNewSearch(SBPL2DGridSearch* search, const std::vector<unsigned char>& map,
+                            int startx, int starty, int goalx, int goaly)
+{
+    SBPL2DGridSearch newsearch(WIDTH, HEIGHT, 0.025f);
+    newsearch.search(&map[0], WIDTH, OBSTHRESH, startx, starty, goalx, goaly,
+                     SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            if (search->getlowerboundoncostfromstart_inmm(x, y) != newsearch.getlowerboundoncostfromstart_inmm(x, y)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// a field is found again only for the map version it was computed on
+static void TestCacheMissesAfterMapChange()
+{
+    const int startx = 10, starty = 20, goalx = 100, goaly = 70;
+    std::vector<unsigned char> map = RandomMap(startx, starty, goalx, goaly);
+    SBPL2DGridSearchCache cache(8);
+    SBPL2DGridSearch search(WIDTH, HEIGHT, 0.025f);
+
+    unsigned long long mapversion = SBPL2DGridSearchCache::computemapversion(&map[0], WIDTH, HEIGHT, WIDTH);
+    search.searchcached(&cache, mapversion, &map[0], WIDTH, OBSTHRESH, startx, starty, goalx, goaly);
+    Check(cache.getnumfields() == 1, "a new field is added to the cache");
+
+    // the same costs in another buffer with another stride
+    const int stride = WIDTH + 5;
+    std::vector<unsigned char> buffer(stride * HEIGHT, 254);
+    for (int y = 0; y < HEIGHT; y++) {
+        std::copy(map.begin() + WIDTH * y, map.begin() + WIDTH * (y + 1), buffer.begin() + stride * y);
+    }
+    Check(SBPL2DGridSearchCache::computemapversion(&buffer[0], WIDTH, HEIGHT, stride) == mapversion,
+          "the same costs have the same map version");
+    search.searchcached(&cache, mapversion, &buffer[0], stride, OBSTHRESH, startx, starty, goalx, goaly);
+    Check(cache.getnumfields() == 1, "the field is found for the same map");
+    Check(SameAsNewSearch(&search, map, startx, starty, goalx, goaly), "the cached values are the searched ones");
+
+    // the fields of searches with other parameters are not found
+    search.searchcached(&cache, mapversion, &map[0], WIDTH, OBSTHRESH - 1, startx, starty, goalx, goaly);
+    Check(cache.getnumfields() == 2, "the field is not found for another obstacle threshold");
+    SBPL2DGridSearch coarsesearch(WIDTH, HEIGHT, 0.05f);
+    coarsesearch.searchcached(&cache, mapversion, &map[0], WIDTH, OBSTHRESH, startx, starty, goalx, goaly);
+    Check(cache.getnumfields() == 3, "the field is not found for another cell size");
+
+    // flip the top bits of two cells 8 apart, and swap two cells of a row
+    map[7 + WIDTH * 40] ^= 0x80;
+    map[15 + WIDTH * 40] ^= 0x80;
+    unsigned long long newmapversion = SBPL2DGridSearchCache::computemapversion(&map[0], WIDTH, HEIGHT, WIDTH);
+    Check(newmapversion != mapversion, "a changed map has another map version");
+    search.searchcached(&cache, newmapversion, &map[0], WIDTH, OBSTHRESH, startx, starty, goalx, goaly);
+    Check(cache.getnumfields() == 4, "the field is not found after the map has changed");
+    Check(SameAsNewSearch(&search, map, startx, starty, goalx, goaly), "the values are searched over the new map");
+
+    map[30 + WIDTH * 50] = 1;
+    map[31 + WIDTH * 50] = 2;
+    mapversion = SBPL2DGridSearchCache::computemapversion(&map[0], WIDTH, HEIGHT, WIDTH);
+    std::swap(map[30 + WIDTH * 50], map[31 + WIDTH * 50]);
+    Check(SBPL2DGridSearchCache::computemapversion(&map[0], WIDTH, HEIGHT, WIDTH) != mapversion,
+          "swapped cells change the map version");
+    Check(SBPL2DGridSearchCache::newmapversion() != SBPL2DGridSearchCache::newmapversion(),
+          "new map versions are unique");
+}
+
+// the environment hashes a whole costmap it takes and takes a new map
+// version after UpdateCost, the search instances share the version of their
+// snapshot
+static void TestEnvironmentMapVersions()
+{
+    std::vector<sbpl_2Dpt_t> perimeter;
+    perimeter.push_back(sbpl_2Dpt_t(-0.01, -0.01));
+    perimeter.push_back(sbpl_2Dpt_t(0.01, -0.01));
+    perimeter.push_back(sbpl_2Dpt_t(0.01, 0.01));
+    perimeter.push_back(sbpl_2Dpt_t(-0.01, 0.01));
+
+    EnvironmentNAVXYTHETALAT env;
+    if (!env.InitializeEnv("env_examples/nav3d/env1.cfg", perimeter, "matlab/mprim/pr2.mprim")) {
+        Check(false, "the environment is initialized");
+        return;
+    }
+    std::shared_ptr<SBPL2DGridSearchCache> cache(new SBPL2DGridSearchCache(4));
+    env.SetHeuristicCache(cache);
+
+    const EnvNAVXYTHETALATConfig_t* cfg = env.GetEnvNavConfig();
+    const int goalx = cfg->EndX_c, goaly = cfg->EndY_c;
+    env.PrecomputeGoalHeuristics(goalx, goaly);
+    Check(cache->getnumfields() == 1, "the goal distances are cached");
+
+    EnvironmentNAVXYTHETALAT instance;
+    instance.InitializeEnvFromModel(env.GetLatticeModel());
+    instance.SetHeuristicCache(cache);
+    instance.PrecomputeGoalHeuristics(goalx, goaly);
+    Check(cache->getnumfields() == 1, "a search instance finds the goal distances of its environment");
+
+    std::vector<unsigned char> map(cfg->EnvWidth_c * cfg->EnvHeight_c);
+    for (int y = 0; y < cfg->EnvHeight_c; y++) {
+        for (int x = 0; x < cfg->EnvWidth_c; x++) {
+            map[x + cfg->EnvWidth_c * y] = cfg->Grid2DCell(x, y);
+        }
+    }
+
+    unsigned char oldcost = cfg->Grid2DCell(1, 1);
+    env.UpdateCost(1, 1, oldcost + 1);
+    env.PrecomputeGoalHeuristics(goalx, goaly);
+    Check(cache->getnumfields() == 2, "UpdateCost makes the cached goal distances miss");
+
+    instance.PrecomputeGoalHeuristics(goalx, goaly);
+    Check(cache->getnumfields() == 2, "the search instance keeps the version of its snapshot");
+
+    env.SetMap(&map[0]);
+    env.PrecomputeGoalHeuristics(goalx, goaly);
+    Check(cache->getnumfields() == 2, "SetMap with the loaded costs finds their goal distances");
+
+    map[1 + cfg->EnvWidth_c] = oldcost + 2;
+    env.SetMap(&map[0]);
+    env.PrecomputeGoalHeuristics(goalx, goaly);
+    Check(cache->getnumfields() == 3, "SetMap with new costs makes the cached goal distances miss");
+
+    map[1 + cfg->EnvWidth_c] = oldcost;
+    env.SetMapBuffer(&map[0], cfg->EnvWidth_c);
+    env.PrecomputeGoalHeuristics(goalx, goaly);
+    Check(cache->getnumfields() == 3, "SetMapBuffer with the loaded costs finds their goal distances");
+
+    map[1 + cfg->EnvWidth_c] = oldcost + 3;
+    env.SetMapBuffer(&map[0], cfg->EnvWidth_c);
+    env.PrecomputeGoalHeuristics(goalx, goaly);
+    Check(cache->getnumfields() == 4, "SetMapBuffer with new costs makes the cached goal distances miss");
+    map[1 + cfg->EnvWidth_c] = oldcost;
+    env.SetMap(&map[0]);
+
+    // an environment loaded from the same map finds the goal distances of
+    // the first one
+    EnvironmentNAVXYTHETALAT otherenv;
+    if (!otherenv.InitializeEnv("env_examples/nav3d/env1.cfg", perimeter, "matlab/mprim/pr2.mprim")) {
+        Check(false, "the other environment is initialized");
+        return;
+    }
+    otherenv.SetHeuristicCache(cache);
+    Check(otherenv.GetEnvNavConfig()->Grid2DVersion == cfg->Grid2DVersion,
+          "environments loaded from the same map have the same map version");
+    otherenv.PrecomputeGoalHeuristics(goalx, goaly);
+    Check(cache->getnumfields() == 4, "an environment loaded from the same map finds the goal distances");
+}
+
+// a search over all the cells has the values of the one with the heap
+static void TestAllCellsMatchesHeap(SBPL_2DGRIDSEARCH_OPENTYPE opentype, int downsample, int numthreads)
+{
+    int numofwrongvalues = 0;
+    for (int round = 0; round < 10; round++) {
+        const int startx = rand() % WIDTH, starty = rand() % HEIGHT;
+        const int goalx = rand() % WIDTH, goaly = rand() % HEIGHT;
+        std::vector<unsigned char> map = RandomMap(startx, starty, goalx, goaly);
+
+        SBPL2DGridSearch search(WIDTH, HEIGHT, 0.025f, downsample);
+        SBPL2DGridSearch heapsearch(WIDTH, HEIGHT, 0.025f, downsample);
+        search.setOPENdatastructure(opentype);
+        search.setnumthreads(numthreads);
+        search.search(&map[0], WIDTH, OBSTHRESH, startx, starty, goalx, goaly,
+                      SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS);
+        heapsearch.search(&map[0], WIDTH, OBSTHRESH, startx, starty, goalx, goaly,
+                          SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS);
+        for (int y = 0; y < HEIGHT / downsample * downsample; y++) {
+            for (int x = 0; x < WIDTH / downsample * downsample; x++) {
+                if (search.getlowerboundoncostfromstart_inmm(x, y) != heapsearch.getlowerboundoncostfromstart_inmm(x, y)) {
+                    numofwrongvalues++;
+                }
+            }
+        }
+    }
+    Check(numofwrongvalues == 0, "the values over all the cells are the ones of the heap");
+}
+
+// a repaired search has the values of a search from scratch up to the
+// largest g-value it knows to be optimal and that value beyond
+static void TestRepairMatchesNewSearch(SBPL_2DGRIDSEARCH_OPENTYPE opentype, int downsample, int numthreads = 1)
+{
+    const int startx = WIDTH / 2, starty = HEIGHT / 2;
+    int goalx = WIDTH / 5, goaly = HEIGHT / 5;
+    std::vector<unsigned char> map = RandomMap(startx, starty, goalx, goaly);
+    const SBPL_2DGRIDSEARCH_TERM_CONDITION termination = SBPL_2DGRIDSEARCH_TERM_CONDITION_TWOTIMESOPTPATH;
+
+    SBPL2DGridSearch search(WIDTH, HEIGHT, 0.025f, downsample);
+    SBPL2DGridSearch newsearch(WIDTH, HEIGHT, 0.025f, downsample);
+    search.setOPENdatastructure(opentype);
+    search.setnumthreads(numthreads);
+    search.search(&map[0], WIDTH, OBSTHRESH, startx, starty, goalx, goaly, termination);
+
+    const int width = WIDTH / downsample * downsample;
+    const int height = HEIGHT / downsample * downsample;
+    int numofwrongvalues = 0;
+    for (int round = 0; round < 100; round++) {
+        // change cells around a random one, and move the goal now and then
+        std::vector<sbpl_2Dcell_t> changedcells;
+        int centerx = rand() % width, centery = rand() % height;
+        for (int i = 0; i < 20; i++) {
+            int x = centerx + rand() % 21 - 10, y = centery + rand() % 21 - 10;
+            if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT || (x == startx && y == starty)) continue;
+            int kind = rand() % 3;
+            map[x + WIDTH * y] = (kind == 0) ? 254 : (kind == 1) ? 0 : rand() % OBSTHRESH;
+            changedcells.push_back(sbpl_2Dcell_t(x, y));
+        }
+        if (round % 5 == 4) {
+            goalx = rand() % width;
+            goaly = rand() % height;
+        }
+
+        search.repair(&map[0], WIDTH, OBSTHRESH, startx, starty, goalx, goaly, termination, changedcells);
+        newsearch.search(&map[0], WIDTH, OBSTHRESH, startx, starty, goalx, goaly,
+                         SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS);
+
+        int largestoptf = search.getlargestcomputedoptimalf_inmm();
+        int goaldistance = newsearch.getlowerboundoncostfromstart_inmm(goalx, goaly);
+        if (goaldistance < INFINITECOST && largestoptf < 2 * goaldistance) {
+            numofwrongvalues++;
+        }
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int distance = newsearch.getlowerboundoncostfromstart_inmm(x, y);
+                if (search.getlowerboundoncostfromstart_inmm(x, y) != __min(distance, largestoptf)) {
+                    numofwrongvalues++;
+                }
+            }
+        }
+    }
+    Check(numofwrongvalues == 0, "the repaired values are the searched ones");
+}
+
+// getcostfromstart_inmm continues a search that stopped once the goal was
+// settled (after a repair if changedcells are given) to the exact distances
+static void TestCostFromStartMatchesAllCells(SBPL_2DGRIDSEARCH_OPENTYPE opentype, int downsample, int numthreads,
+                                             bool repair)
+{
+    const int width = WIDTH / downsample * downsample;
+    const int height = HEIGHT / downsample * downsample;
+    int numofwrongvalues = 0;
+    for (int round = 0; round < 10; round++) {
+        const int startx = rand() % width, starty = rand() % height;
+        const int goalx = rand() % width, goaly = rand() % height;
+        std::vector<unsigned char> map = RandomMap(startx, starty, goalx, goaly);
+
+        SBPL2DGridSearch search(WIDTH, HEIGHT, 0.025f, downsample);
+        search.setOPENdatastructure(opentype);
+        search.setnumthreads(numthreads);
+        search.search(&map[0], WIDTH, OBSTHRESH, startx, starty, goalx, goaly,
+                      SBPL_2DGRIDSEARCH_TERM_CONDITION_GOALSETTLED);
+        if (repair) {
+            std::vector<sbpl_2Dcell_t> changedcells;
+            for (int i = 0; i < 50; i++) {
+                int x = rand() % WIDTH, y = rand() % HEIGHT;
+                if (x / downsample == startx / downsample && y / downsample == starty / downsample) continue;
+                map[x + WIDTH * y] = (rand() % 2) ? 254 : rand() % 50;
+                changedcells.push_back(sbpl_2Dcell_t(x, y));
+            }
+            search.repair(&map[0], WIDTH, OBSTHRESH, startx, starty, goalx, goaly,
+                          SBPL_2DGRIDSEARCH_TERM_CONDITION_GOALSETTLED, changedcells);
+        }
+
+        SBPL2DGridSearch newsearch(WIDTH, HEIGHT, 0.025f, downsample);
+        newsearch.search(&map[0], WIDTH, OBSTHRESH, startx, starty, goalx, goaly,
+                         SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS);
+        for (int i = 0; i < 200; i++) {
+            int x = rand() % width, y = rand() % height;
+            if (search.getcostfromstart_inmm(&map[0], WIDTH, OBSTHRESH, x, y) !=
+                newsearch.getlowerboundoncostfromstart_inmm(x, y))
+            {
+                numofwrongvalues++;
+            }
+        }
+    }
+    Check(numofwrongvalues == 0, "the continued values are the ones of a search over all the cells");
+}
+
+// with lazy_heuristics the heuristics are the exact distances, which the
+// default ones are up to the distance between the start and the goal
+static void TestLazyHeuristics()
+{
+    std::vector<sbpl_2Dpt_t> perimeter;
+    perimeter.push_back(sbpl_2Dpt_t(-0.01, -0.01));
+    perimeter.push_back(sbpl_2Dpt_t(0.01, -0.01));
+    perimeter.push_back(sbpl_2Dpt_t(0.01, 0.01));
+    perimeter.push_back(sbpl_2Dpt_t(-0.01, 0.01));
+    const int startx = 30, starty = 40, goalx = 50, goaly = 30;
+    std::vector<unsigned char> map = RandomMap(startx, starty, goalx, goaly);
+
+    EnvironmentNAVXYTHETALAT env;
+    EnvironmentNAVXYTHETALAT lazyenv;
+    lazyenv.SetEnvParameter("lazy_heuristics", 1);
+    EnvironmentNAVXYTHETALAT* envs[] = { &env, &lazyenv };
+    MDPConfig mdp; // the same for both
+    for (int e = 0; e < 2; e++) {
+        envs[e]->InitializeEnv(WIDTH, HEIGHT, &map[0], startx * 0.025, starty * 0.025, 0, goalx * 0.025,
+                               goaly * 0.025, 0, perimeter, 0.025, 1.0, 2.0, 254, "matlab/mprim/pr2.mprim", true,
+                               -1e9, 1e9);
+        envs[e]->InitializeMDPCfg(&mdp);
+    }
+
+    int numofwrongvalues = 0;
+    int numofcontinuedvalues = 0;
+    for (int round = 0; round < 3; round++) {
+        if (round > 0) {
+            std::vector<sbpl_2Dcell_t> changedcells;
+            for (int i = 0; i < 20; i++) {
+                int x = rand() % WIDTH, y = rand() % HEIGHT;
+                if ((x == startx && y == starty) || (x == goalx && y == goaly)) continue;
+                map[x + WIDTH * y] = (rand() % 2) ? 254 : 0;
+                changedcells.push_back(sbpl_2Dcell_t(x, y));
+            }
+            env.SetMap(&map[0], changedcells);
+            lazyenv.SetMap(&map[0], changedcells);
+        }
+        for (int e = 0; e < 2; e++) {
+            envs[e]->EnsureHeuristicsUpdated(true);
+            envs[e]->EnsureHeuristicsUpdated(false);
+        }
+
+        int startdistance = env.GetGoalHeuristic(mdp.startstateid);
+        int goaldistance = env.GetStartHeuristic(mdp.goalstateid);
+        for (int i = 0; i < 500; i++) {
+            int x = rand() % WIDTH, y = rand() % HEIGHT;
+            int stateid = env.GetStateFromCoord(x, y, 0);
+            int lazystateid = lazyenv.GetStateFromCoord(x, y, 0);
+            int goalh = env.GetGoalHeuristic(stateid), lazygoalh = lazyenv.GetGoalHeuristic(lazystateid);
+            int starth = env.GetStartHeuristic(stateid), lazystarth = lazyenv.GetStartHeuristic(lazystateid);
+            if (lazygoalh < goalh || __min(lazygoalh, startdistance) != __min(goalh, startdistance) ||
+                lazystarth < starth || __min(lazystarth, goaldistance) != __min(starth, goaldistance))
+            {
+                numofwrongvalues++;
+            }
+            if (lazygoalh > goalh || lazystarth > starth) {
+                numofcontinuedvalues++;
+            }
+        }
+    }
+    Check(numofwrongvalues == 0, "the lazy heuristics are the exact distances");
+    Check(numofcontinuedvalues > 0, "the lazy heuristics go past the distance between the start and the goal");
+}
+
+// the heuristics after SetMap and SetMapBuffer with the changed cells are
+// the ones of an environment made from the new map
+static void TestEnvironmentRepair()
+{
+    std::vector<sbpl_2Dpt_t> perimeter;
+    perimeter.push_back(sbpl_2Dpt_t(-0.01, -0.01));
+    perimeter.push_back(sbpl_2Dpt_t(0.01, -0.01));
+    perimeter.push_back(sbpl_2Dpt_t(0.01, 0.01));
+    perimeter.push_back(sbpl_2Dpt_t(-0.01, 0.01));
+    const int startx = 10, starty = 10, goalx = 100, goaly = 80;
+    std::vector<unsigned char> map = RandomMap(startx, starty, goalx, goaly);
+    std::vector<unsigned char> buffer(map);
+
+    EnvironmentNAVXYTHETALAT env;
+    env.InitializeEnv(WIDTH, HEIGHT, &map[0], startx * 0.025, starty * 0.025, 0, goalx * 0.025, goaly * 0.025, 0,
+                      perimeter, 0.025, 1.0, 2.0, 254, "matlab/mprim/pr2.mprim", true, -1e9, 1e9);
+    MDPConfig mdp;
+    env.InitializeMDPCfg(&mdp);
+
+    env.EnsureHeuristicsUpdated(true);
+    env.EnsureHeuristicsUpdated(false);
+
+    int numofwrongvalues = 0;
+    for (int round = 0; round < 10; round++) {
+        std::vector<sbpl_2Dcell_t> changedcells;
+        for (int i = 0; i < 20; i++) {
+            int x = rand() % WIDTH, y = rand() % HEIGHT;
+            if ((x == startx && y == starty) || (x == goalx && y == goaly)) continue;
+            map[x + WIDTH * y] = (rand() % 2) ? 254 : 0;
+            changedcells.push_back(sbpl_2Dcell_t(x, y));
+        }
+        if (round % 2 == 0) {
+            env.SetMap(&map[0], changedcells);
+        }
+        else {
+            buffer = map;
+            env.SetMapBuffer(&buffer[0], WIDTH, changedcells);
+        }
+
+        EnvironmentNAVXYTHETALAT newenv;
+        newenv.InitializeEnv(WIDTH, HEIGHT, &map[0], startx * 0.025, starty * 0.025, 0, goalx * 0.025, goaly * 0.025,
+                             0, perimeter, 0.025, 1.0, 2.0, 254, "matlab/mprim/pr2.mprim", true, -1e9, 1e9);
+        MDPConfig newmdp;
+        newenv.InitializeMDPCfg(&newmdp);
+
+        env.EnsureHeuristicsUpdated(true);
+        env.EnsureHeuristicsUpdated(false);
+        newenv.EnsureHeuristicsUpdated(true);
+        newenv.EnsureHeuristicsUpdated(false);
+
+        // the searches stop after the distance between the start and the
+        // goal, the values are exact up to there
+        int startdistance = newenv.GetGoalHeuristic(newmdp.startstateid);
+        int goaldistance = newenv.GetStartHeuristic(newmdp.goalstateid);
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                int stateid = env.GetStateFromCoord(x, y, 0);
+                int newstateid = newenv.GetStateFromCoord(x, y, 0);
+                if (__min(env.GetGoalHeuristic(stateid), startdistance) !=
+                            __min(newenv.GetGoalHeuristic(newstateid), startdistance) ||
+                    __min(env.GetStartHeuristic(stateid), goaldistance) !=
+                            __min(newenv.GetStartHeuristic(newstateid), goaldistance))
+                {
+                    numofwrongvalues++;
+                }
+            }
+        }
+    }
+    env.SetMap(&map[0]);
+    Check(numofwrongvalues == 0, "the repaired heuristics are the ones of a new environment");
+}
+
+int main(int, char**)
+{
+    srand(0);
+
+    TestCacheMissesAfterMapChange();
+    TestEnvironmentMapVersions();
+    TestRepairMatchesNewSearch(SBPL_2DGRIDSEARCH_OPENTYPE_HEAP, 1);
+    TestRepairMatchesNewSearch(SBPL_2DGRIDSEARCH_OPENTYPE_HEAP, 2);
+    TestRepairMatchesNewSearch(SBPL_2DGRIDSEARCH_OPENTYPE_SLIDINGBUCKETS, 1);
+    TestRepairMatchesNewSearch(SBPL_2DGRIDSEARCH_OPENTYPE_SLIDINGBUCKETS, 2);
+    TestAllCellsMatchesHeap(SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS, 1, 4);
+    TestAllCellsMatchesHeap(SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS, 2, 4);
+    TestRepairMatchesNewSearch(SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS, 1, 4);
+    TestRepairMatchesNewSearch(SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS, 2, 4);
+    TestEnvironmentRepair();
+    for (int repair = 0; repair < 2; repair++) {
+        TestCostFromStartMatchesAllCells(SBPL_2DGRIDSEARCH_OPENTYPE_HEAP, 1, 1, repair != 0);
+        TestCostFromStartMatchesAllCells(SBPL_2DGRIDSEARCH_OPENTYPE_HEAP, 2, 1, repair != 0);
+        TestCostFromStartMatchesAllCells(SBPL_2DGRIDSEARCH_OPENTYPE_SLIDINGBUCKETS, 1, 1, repair != 0);
+        TestCostFromStartMatchesAllCells(SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS, 1, 4, repair != 0);
+        TestCostFromStartMatchesAllCells(SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS, 2, 4, repair != 0);
+    }
+    TestLazyHeuristics();
+
+    if (numoffailures > 0) {
+        printf("%d checks failed\n", numoffailures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2008, Maxim Likhachev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Carnegie Mellon University nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Runs random operations on CDaryHeap and CBucketHeap and checks every
+// result against a std::set ordered by key, e.g.
+//
+//   g++ -O3 -Isrc/include src/test/test_heap.cpp -Lbuild -lsbpl -o test_heap
+//   ./test_heap
+
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <sbpl/headers.h>
+
+static int numoffailures = 0;
+
+static void Check(bool condition, const char* what)
+{
+    if (!condition) {
+        if (numoffailures < 10) printf("FAILED: %s\n", what);
+        numoffailures++;
+    }
+}
+
+// the first two entries of a key, the ones the heaps below compare
+typedef std::pair<long int, long int> referencekey_t;
+
+// a random key near base: mostly within a few hundred of it, now and then
+// far above it (past the window of CBucketHeap) or below it (which moves the
+// window down). The second entry is set only if the heap compares it.
+static CKey RandomKey(long int base, long int spread, int keysize)
+{
+    CKey key;
+    int kind = rand() % 20;
+    if (kind == 0) key.key[0] = base + rand() % (spread * 100 + 1);
+    else if (kind == 1) key.key[0] = base - rand() % (spread * 10 + 1);
+    else key.key[0] = base + rand() % (spread + 1);
+    if (keysize > 1) key.key[1] = rand() % 4;
+    return key;
+}
+
+static referencekey_t ReferenceKey(const CKey& key)
+{
+    return referencekey_t(key.key[0], key.key[1]);
+}
+
+static void CheckNumOfBuckets(CDaryHeap*, int)
+{
+}
+
+static void CheckNumOfBuckets(CBucketHeap* heap, int maxnumofbuckets)
+{
+    Check(heap->getnumofbuckets() <= maxnumofbuckets, "getnumofbuckets");
+}
+
+// keysize is the number of key entries the heap compares, maxnumofbuckets
+// the largest number of buckets of a CBucketHeap
+template <typename HEAP>
+static void TestHeap(HEAP* heap, int keysize, int maxnumofbuckets, long int spread, int numofoperations)
+{
+    const int numofstates = 2000;
+    std::vector<AbstractSearchState> states(numofstates);
+    for (int i = 0; i < numofstates; i++) {
+        states[i].heapindex = 0;
+    }
+    std::vector<referencekey_t> keys(numofstates); // the key of every state in the reference
+    std::set<std::pair<referencekey_t, int> > reference; // <key, state index>
+
+    long int base = 0;
+    for (int op = 0; op < numofoperations; op++) {
+        int s = rand() % numofstates;
+        AbstractSearchState* state = &states[s];
+        Check(heap->inheap(state) == (reference.count(std::make_pair(keys[s], s)) == 1), "inheap");
+
+        int kind = rand() % 10;
+        if (kind < 4) {
+            // insert or update
+            CKey key = RandomKey(base, spread, keysize);
+            if (heap->inheap(state)) {
+                Check(ReferenceKey(heap->getkeyheap(state)) == keys[s], "getkeyheap");
+                reference.erase(std::make_pair(keys[s], s));
+                heap->updateheap(state, key);
+            }
+            else {
+                heap->insertheap(state, key);
+            }
+            keys[s] = ReferenceKey(key);
+            reference.insert(std::make_pair(keys[s], s));
+        }
+        else if (kind < 5) {
+            if (heap->inheap(state)) {
+                reference.erase(std::make_pair(keys[s], s));
+                heap->deleteheap(state);
+            }
+        }
+        else if (kind < 9) {
+            // delete the min, equal keys may come out in any order
+            Check(heap->emptyheap() == reference.empty(), "emptyheap");
+            if (reference.empty()) continue;
+            referencekey_t minkey = reference.begin()->first;
+            Check(ReferenceKey(heap->getminkeyheap()) == minkey, "getminkeyheap");
+            AbstractSearchState* minstate = heap->deleteminheap();
+            int m = (int)(minstate - &states[0]);
+            Check(m >= 0 && m < numofstates && keys[m] == minkey && reference.erase(std::make_pair(keys[m], m)) == 1,
+                  "deleteminheap");
+            base = minkey.first;
+        }
+        else if (rand() % 50 == 0) {
+            // change every key at once
+            for (int i = 1; i <= heap->currentsize; i++) {
+                int index = (int)(heap->getstateheap(i) - &states[0]);
+                reference.erase(std::make_pair(keys[index], index));
+                CKey key = RandomKey(base, spread, keysize);
+                heap->setkeyheap_unsafe(i, key);
+                keys[index] = ReferenceKey(key);
+                reference.insert(std::make_pair(keys[index], index));
+            }
+            heap->makeheap();
+        }
+        else if (rand() % 100 == 0) {
+            heap->makeemptyheap();
+            reference.clear();
+        }
+
+        Check(heap->currentsize == (int)reference.size(), "currentsize");
+        CheckNumOfBuckets(heap, maxnumofbuckets);
+    }
+
+    // empty it in order
+    while (!heap->emptyheap()) {
+        CKey key;
+        heap->getminheap(key);
+        Check(ReferenceKey(key) == reference.begin()->first, "the keys come out in order");
+        int m = (int)(heap->deleteminheap() - &states[0]);
+        reference.erase(std::make_pair(keys[m], m));
+    }
+    Check(reference.empty(), "all the states come out");
+}
+
+static void TestDaryHeap(int arity, int keysize, long int spread, int numofoperations)
+{
+    CDaryHeap heap(arity, keysize);
+    TestHeap(&heap, keysize, 0, spread, numofoperations);
+}
+
+static void TestBucketHeap(int maxnumofbuckets, long int spread, int numofoperations)
+{
+    CBucketHeap heap(maxnumofbuckets);
+    TestHeap(&heap, 1, maxnumofbuckets, spread, numofoperations);
+}
+
+int main(int, char**)
+{
+    srand(0);
+
+    const int arities[] = { 2, 4, 8 };
+    for (int i = 0; i < 3; i++) {
+        TestDaryHeap(arities[i], 1, 300, 1000000);
+        TestDaryHeap(arities[i], KEY_SIZE, 300, 1000000);
+    }
+    TestBucketHeap(BUCKETHEAP_NUMBUCKETS, 300, 1000000);
+    TestBucketHeap(BUCKETHEAP_NUMBUCKETS, 20000, 1000000);
+    TestBucketHeap(16, 300, 1000000);
+    TestBucketHeap(1024, 5, 1000000);
+
+    if (numoffailures > 0) {
+        printf("%d checks failed\n", numoffailures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
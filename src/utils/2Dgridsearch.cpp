@@ -27,13 +27,19 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
+#include <functional>
+#include <queue>
 #include <sstream>
+#include <unordered_set>
+#include <utility>
 
+#include <sbpl/sbpl_exception.h>
 #include <sbpl/utils/2Dgridsearch.h>
-#include <sbpl/utils/heap.h>
-#include <sbpl/utils/list.h>
+#include <sbpl/utils/workerpool.h>
 
 using namespace std;
 
@@ -41,34 +47,34 @@ using namespace std;
 // into a single cell in the 2D grid.
 // Using templates for common cases so the compiler can generate faster code
 template<int N>
-unsigned char getCostT(unsigned char **Grid2D, int x, int y, int /*resample*/)
+unsigned char getCostT(const unsigned char* Grid2D, int stride, int x, int y, int /*resample*/)
 {
     if(N == 1) // the compiler will optimize out this if statement
     {
-        return Grid2D[x][y];
+        return Grid2D[y * stride + x];
     }
     else
     {
         x *= N;
         y *= N;
-        unsigned char maximum = Grid2D[x][y];
+        unsigned char maximum = Grid2D[y * stride + x];
         for(int dy=0; dy<N; dy++)
             for(int dx=0; dx<N; dx++)
-                maximum = __max(maximum, Grid2D[x+dx][y+dy]);
+                maximum = __max(maximum, Grid2D[(y + dy) * stride + x + dx]);
 
         return maximum;
     }
 }
 
 // fallback for unforseen cases
-unsigned char getCostN(unsigned char **Grid2D, int x, int y, int resample)
+unsigned char getCostN(const unsigned char* Grid2D, int stride, int x, int y, int resample)
 {
     x *= resample;
     y *= resample;
-    unsigned char maximum = Grid2D[x][y];
+    unsigned char maximum = Grid2D[y * stride + x];
     for(int dy=0; dy<resample; dy++)
         for(int dx=0; dx<resample; dx++)
-            maximum = __max(maximum, Grid2D[x+dx][y+dy]);
+            maximum = __max(maximum, Grid2D[(y + dy) * stride + x + dx]);
 
     return maximum;
 }
@@ -77,7 +83,8 @@ unsigned char getCostN(unsigned char **Grid2D, int x, int y, int resample)
 SBPL2DGridSearch::SBPL2DGridSearch(int width_x, int height_y, float cellsize_m, int downsample, int initial_dynamic_bucket_size)
 {
     iteration_ = 0;
-    searchStates2D_ = NULL;
+    g_ = NULL;
+    blockiteration_ = NULL;
     downsample_ = __max(1, downsample);
 
     width_ = width_x / downsample;
@@ -108,9 +115,12 @@ SBPL2DGridSearch::SBPL2DGridSearch(int width_x, int height_y, float cellsize_m,
 
     term_condition_usedlast = SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS;
 
+    repairable_ = false;
+    obsthreshusedlast_ = 0;
+    openinheap_ = false;
+
     //allocate memory
-    OPEN2D_ = new CIntHeap(width_ * height_);
-    if (!createSearchStates2D()) {
+    if (!createSearchGrid2D()) {
         throw SBPL_Exception("ERROR: failed to create searchstatespace2D");
     }
 
@@ -119,12 +129,18 @@ SBPL2DGridSearch::SBPL2DGridSearch(int width_x, int height_y, float cellsize_m,
     OPENtype_ = SBPL_2DGRIDSEARCH_OPENTYPE_HEAP;
 
     initial_dynamic_bucket_size_ = initial_dynamic_bucket_size;
+
+    numthreads_ = 1;
+    workers_ = NULL;
 }
 
 bool SBPL2DGridSearch::setOPENdatastructure(SBPL_2DGRIDSEARCH_OPENTYPE OPENtype)
 {
     OPENtype_ = OPENtype;
 
+    //the OPEN list of the last search may go away
+    repairable_ = false;
+
     switch (OPENtype_) {
     case SBPL_2DGRIDSEARCH_OPENTYPE_HEAP:
         //this is the default, nothing else needs to be done
@@ -138,20 +154,22 @@ bool SBPL2DGridSearch::setOPENdatastructure(SBPL_2DGRIDSEARCH_OPENTYPE OPENtype)
             for (int dind = 0; dind < SBPL_2DGRIDSEARCH_NUMOF2DDIRS; dind++) {
                 maxdistance = __max(maxdistance, dxy_distance_mm_[dind]);
             }
-            int bucketsize = __max(1000, this->width_ + this->height_);
+            int bucketsize = (initial_dynamic_bucket_size_ > 0) ? initial_dynamic_bucket_size_ :
+                                                                  __max(1000, this->width_ + this->height_);
             int numofbuckets = 255 * maxdistance;
-            SBPL_PRINTF("creating sliding bucket-based OPEN2D %d buckets, each bucket of size %d ...", numofbuckets,
-                        bucketsize);
-            OPEN2DBLIST_ = new CSlidingBucket(numofbuckets, bucketsize, initial_dynamic_bucket_size_);
+            SBPL_PRINTF("creating sliding bucket-based OPEN2D %d buckets, each bucket of initial size %d ...",
+                        numofbuckets, bucketsize);
+            OPEN2DBLIST_ = new SBPL2DGridSearchBuckets(numofbuckets, bucketsize);
             SBPL_PRINTF("done\n");
         }
-        //delete other data structures
-        if (OPEN2D_ != NULL) {
-            OPEN2D_->makeemptyheap();
-            delete OPEN2D_;
-            OPEN2D_ = NULL;
-        }
+        //the heap is only used by repair()
+        OPEN2D_.makeemptyheap();
 
+        break;
+    case SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS:
+        //the buckets are created by every search, OPEN2D_ gets the states
+        //left in them for repair()
+        SBPL_PRINTF("setting OPEN2D data structure to parallel buckets\n");
         break;
     default:
         std::stringstream ss("ERROR: unknown data structure type = ");
@@ -162,57 +180,53 @@ bool SBPL2DGridSearch::setOPENdatastructure(SBPL_2DGRIDSEARCH_OPENTYPE OPENtype)
     return true;
 }
 
-bool SBPL2DGridSearch::createSearchStates2D(void)
+bool SBPL2DGridSearch::createSearchGrid2D(void)
 {
-    int x, y;
-
-    if (searchStates2D_ != NULL) {
-        SBPL_ERROR("ERROR: We already have a non-NULL search states array\n");
+    if (g_ != NULL) {
+        SBPL_ERROR("ERROR: We already have a non-NULL g-values array\n");
         return false;
     }
 
-    searchStates2D_ = new SBPL_2DGridSearchState*[width_];
-    for (x = 0; x < width_; x++) {
-        searchStates2D_[x] = new SBPL_2DGridSearchState[height_];
-        for (y = 0; y < height_; y++) {
-            searchStates2D_[x][y].iterationaccessed = iteration_;
-            searchStates2D_[x][y].x = x;
-            searchStates2D_[x][y].y = y;
-            initializeSearchState2D(&searchStates2D_[x][y]);
-        }
+    //the blocks at the right and bottom edges are padded
+    widthinblocks_ = (width_ + 7) / 8;
+    heightinblocks_ = (height_ + 7) / 8;
+    int numofblocks = widthinblocks_ * heightinblocks_;
+    g_ = new std::atomic<int>[numofblocks * 64];
+    blockiteration_ = new int[numofblocks];
+    for (int block = 0; block < numofblocks; block++) {
+        //the g-values are set by the first search that gets to the block
+        blockiteration_[block] = -1;
     }
     return true;
 }
 
-inline void SBPL2DGridSearch::initializeSearchState2D(SBPL_2DGridSearchState* state2D)
+void SBPL2DGridSearch::initializeblock(int block)
 {
-    state2D->g = INFINITECOST;
-    state2D->heapindex = 0;
-    state2D->iterationaccessed = iteration_;
+    std::atomic<int>* blockg = &g_[block << 6];
+    for (int i = 0; i < 64; i++) {
+        blockg[i].store(INFINITECOST, std::memory_order_relaxed);
+    }
+    blockiteration_[block] = iteration_;
 }
 
 void SBPL2DGridSearch::destroy()
 {
-    // destroy the OPEN list:
-    if (OPEN2D_ != NULL) {
-        OPEN2D_->makeemptyheap();
-        delete OPEN2D_;
-        OPEN2D_ = NULL;
-    }
-
-    // destroy the 2D states:
-    if (searchStates2D_ != NULL) {
-        for (int x = 0; x < width_; x++) {
-            delete[] searchStates2D_[x];
-        }
-        delete[] searchStates2D_;
-        searchStates2D_ = NULL;
-    }
+    // destroy the OPEN lists:
+    OPEN2D_.makeemptyheap();
 
     if (OPEN2DBLIST_ != NULL) {
         delete OPEN2DBLIST_;
         OPEN2DBLIST_ = NULL;
     }
+
+    // destroy the g-values:
+    delete[] g_;
+    g_ = NULL;
+    delete[] blockiteration_;
+    blockiteration_ = NULL;
+
+    delete workers_;
+    workers_ = NULL;
 }
 
 void SBPL2DGridSearch::computedxy()
@@ -288,6 +302,28 @@ void SBPL2DGridSearch::computedxy()
     }
 }
 
+float SBPL2DGridSearch::computetermfactor(SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition)
+{
+    //the search stops once the goal g-value is at most term_factor times the
+    //smallest key in OPEN
+    switch (termination_condition) {
+    case SBPL_2DGRIDSEARCH_TERM_CONDITION_OPTPATHFOUND:
+    case SBPL_2DGRIDSEARCH_TERM_CONDITION_GOALSETTLED:
+        return 1;
+    case SBPL_2DGRIDSEARCH_TERM_CONDITION_20PERCENTOVEROPTPATH:
+        return (float)(1.0 / 1.2);
+    case SBPL_2DGRIDSEARCH_TERM_CONDITION_TWOTIMESOPTPATH:
+        return 0.5;
+    case SBPL_2DGRIDSEARCH_TERM_CONDITION_THREETIMESOPTPATH:
+        return (float)(1.0 / 3.0);
+    case SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS:
+        return 0.0;
+    default:
+        SBPL_ERROR("ERROR: incorrect termination factor for grid2Dsearch\n");
+        return 0.0;
+    };
+}
+
 //--------------------------------------------------------------------------------------------------------------------
 
 //-----------------------------------------debugging functions----------------------------------------------------------
@@ -301,7 +337,7 @@ void SBPL2DGridSearch::printvalues()
 
 //-----------------------------------------main functions--------------------------------------------------------------
 
-bool SBPL2DGridSearch::search(unsigned char** Grid2D, unsigned char obsthresh, int startx_c, int starty_c, int goalx_c,
+bool SBPL2DGridSearch::search(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int startx_c, int starty_c, int goalx_c,
                               int goaly_c, SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition)
 {
     startx_c /= downsample_;
@@ -309,15 +345,21 @@ bool SBPL2DGridSearch::search(unsigned char** Grid2D, unsigned char obsthresh, i
     goalx_c /= downsample_;
     goaly_c /= downsample_;
 
+    repairable_ = false;
+
     switch (OPENtype_) {
     case SBPL_2DGRIDSEARCH_OPENTYPE_HEAP:
-        return SBPL2DGridSearch::search_withheap(Grid2D, obsthresh, startx_c, starty_c, goalx_c, goaly_c,
+        return SBPL2DGridSearch::search_withheap(Grid2D, stride, obsthresh, startx_c, starty_c, goalx_c, goaly_c,
                                                  termination_condition);
         break;
     case SBPL_2DGRIDSEARCH_OPENTYPE_SLIDINGBUCKETS:
-        return SBPL2DGridSearch::search_withslidingbuckets(Grid2D, obsthresh, startx_c, starty_c, goalx_c, goaly_c,
+        return SBPL2DGridSearch::search_withslidingbuckets(Grid2D, stride, obsthresh, startx_c, starty_c, goalx_c, goaly_c,
                                                            termination_condition);
         break;
+    case SBPL_2DGRIDSEARCH_OPENTYPE_PARALLELBUCKETS:
+        return SBPL2DGridSearch::search_withparallelbuckets(Grid2D, stride, obsthresh, startx_c, starty_c, goalx_c,
+                                                            goaly_c, termination_condition);
+        break;
     default:
         std::stringstream ss("ERROR: unknown data structure type = ");
         ss << OPENtype_ << " for OPEN2D";
@@ -326,11 +368,9 @@ bool SBPL2DGridSearch::search(unsigned char** Grid2D, unsigned char obsthresh, i
     return false;
 }
 
-bool SBPL2DGridSearch::search_withheap(unsigned char** Grid2D, unsigned char obsthresh, int startx_c, int starty_c,
+bool SBPL2DGridSearch::search_withheap(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int startx_c, int starty_c,
                                        int goalx_c, int goaly_c, SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition)
 {
-    SBPL_2DGridSearchState *searchExpState = NULL;
-    SBPL_2DGridSearchState *searchPredState = NULL;
     int numofExpands = 0;
     int key;
 
@@ -347,7 +387,7 @@ bool SBPL2DGridSearch::search_withheap(unsigned char** Grid2D, unsigned char obs
     goalY_ = goaly_c;
 
     //clear the heap
-    OPEN2D_->makeemptyheap();
+    OPEN2D_.makeemptyheap();
 
     //set the term. condition
     term_condition_usedlast = termination_condition;
@@ -359,62 +399,43 @@ bool SBPL2DGridSearch::search_withheap(unsigned char** Grid2D, unsigned char obs
         return false;
     }
 
-    // initialize the start and goal states
-    searchExpState = &searchStates2D_[startX_][startY_];
-    initializeSearchState2D(searchExpState);
-    initializeSearchState2D(&searchStates2D_[goalx_c][goaly_c]);
-    SBPL_2DGridSearchState* search2DGoalState = &searchStates2D_[goalx_c][goaly_c];
+    //use h-values only if we are NOT computing all state values
+    const bool usehvalues = (termination_condition == SBPL_2DGRIDSEARCH_TERM_CONDITION_OPTPATHFOUND);
+
+    //the g-values of the new iteration start at INFINITECOST
+    const int goalindex = getcellindex(goalx_c, goaly_c);
 
     //seed the search
-    searchExpState->g = 0;
-    key = searchExpState->g;
-    if (termination_condition == SBPL_2DGRIDSEARCH_TERM_CONDITION_OPTPATHFOUND)
-        //use h-values only if we are NOT computing all state values
-        key = key + SBPL_2DGRIDSEARCH_HEUR2D(startX_, startY_);
+    int startindex = getcellindex(startX_, startY_);
+    setg(startindex, 0);
+    key = 0;
+    if (usehvalues) key = key + SBPL_2DGRIDSEARCH_HEUR2D(startX_, startY_);
 
-    OPEN2D_->insertheap(searchExpState, key);
+    OPEN2D_.insertheap(startindex, key);
 
     //set the termination condition
-    float term_factor = 0.0;
-    switch (termination_condition) {
-    case SBPL_2DGRIDSEARCH_TERM_CONDITION_OPTPATHFOUND:
-        term_factor = 1;
-        break;
-    case SBPL_2DGRIDSEARCH_TERM_CONDITION_20PERCENTOVEROPTPATH:
-        term_factor = (float)(1.0 / 1.2);
-        break;
-    case SBPL_2DGRIDSEARCH_TERM_CONDITION_TWOTIMESOPTPATH:
-        term_factor = 0.5;
-        break;
-    case SBPL_2DGRIDSEARCH_TERM_CONDITION_THREETIMESOPTPATH:
-        term_factor = (float)(1.0 / 3.0);
-        break;
-    case SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS:
-        term_factor = 0.0;
-        break;
-    default:
-        SBPL_ERROR("ERROR: incorrect termination factor for grid2Dsearch\n");
-        term_factor = 0.0;
-    };
+    float term_factor = computetermfactor(termination_condition);
 
     char *pbClosed = (char*)calloc(1, width_ * height_);
 
     //the main repetition of expansions
-    while (!OPEN2D_->emptyheap() &&
-           __min(INFINITECOST, search2DGoalState->g) > term_factor * OPEN2D_->getminkeyheap())
+    while (!OPEN2D_.emptyheap() &&
+           (termination_condition == SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS ||
+            __min(INFINITECOST, getg(goalindex)) > term_factor * OPEN2D_.getminkeyheap()))
     {
         //get the next state for expansion
-        searchExpState = (SBPL_2DGridSearchState*)OPEN2D_->deleteminheap();
+        int expindex = OPEN2D_.deleteminheap();
+        int expg = getg(expindex);
         numofExpands++;
 
-        int exp_x = searchExpState->x;
-        int exp_y = searchExpState->y;
+        int exp_x = getcellx(expindex);
+        int exp_y = getcelly(expindex);
 
         //close the state
         pbClosed[exp_x + width_ * exp_y] = 1;
 
         //iterate over successors
-        int expcost =  getCost(Grid2D, exp_x, exp_y, downsample_);
+        int expcost =  getCost(Grid2D, stride, exp_x, exp_y, downsample_);
         for (int dir = 0; dir < SBPL_2DGRIDSEARCH_NUMOF2DDIRS; dir++) {
             int newx = exp_x + dx_[dir];
             int newy = exp_y + dy_[dir];
@@ -425,13 +446,13 @@ bool SBPL2DGridSearch::search_withheap(unsigned char** Grid2D, unsigned char obs
             if (pbClosed[newx + width_ * newy] == 1) continue;
 
             //compute the cost
-            int mapcost = __max(getCost(Grid2D, newx, newy, downsample_), expcost);
+            int mapcost = __max(getCost(Grid2D, stride, newx, newy, downsample_), expcost);
 
 #if SBPL_2DGRIDSEARCH_NUMOF2DDIRS > 8
             if(dir > 7) {
                 //check two more cells through which the action goes
-                mapcost = __max(mapcost, getCost(Grid2D, exp_x + dx0intersects_[dir], exp_y + dy0intersects_[dir], downsample_));
-                mapcost = __max(mapcost, getCost(Grid2D, exp_x + dx1intersects_[dir], exp_y + dy1intersects_[dir], downsample_));
+                mapcost = __max(mapcost, getCost(Grid2D, stride, exp_x + dx0intersects_[dir], exp_y + dy0intersects_[dir], downsample_));
+                mapcost = __max(mapcost, getCost(Grid2D, stride, exp_x + dx1intersects_[dir], exp_y + dy1intersects_[dir], downsample_));
             }
 #endif
 
@@ -439,56 +460,56 @@ bool SBPL2DGridSearch::search_withheap(unsigned char** Grid2D, unsigned char obs
             continue;
             int cost = (mapcost + 1) * dxy_distance_mm_[dir];
 
-            //get the predecessor
-            searchPredState = &searchStates2D_[newx][newy];
-
             //update predecessor if necessary
-            if (searchPredState->iterationaccessed != iteration_ || searchPredState->g > cost + searchExpState->g) {
-                searchPredState->iterationaccessed = iteration_;
-                searchPredState->g = __min(INFINITECOST, cost + searchExpState->g);
-                key = searchPredState->g;
-                if (termination_condition == SBPL_2DGRIDSEARCH_TERM_CONDITION_OPTPATHFOUND)
-                    //use h-values only if we are NOT computing all state values
-                    key = key + SBPL_2DGRIDSEARCH_HEUR2D(searchPredState->x, searchPredState->y);
-
-                if (searchPredState->heapindex == 0)
-                    OPEN2D_->insertheap(searchPredState, key);
-                else
-                    OPEN2D_->updateheap(searchPredState, key);
+            int newindex = getcellindex(newx, newy);
+            int newg = __min(INFINITECOST, cost + expg);
+            if (getg(newindex) > newg) {
+                setg(newindex, newg);
+                key = newg;
+                if (usehvalues) key = key + SBPL_2DGRIDSEARCH_HEUR2D(newx, newy);
+
+                OPEN2D_.insertheap(newindex, key);
             }
         } //over successors
+
+        dropstaleOPENentries(usehvalues);
     }//while
 
     //set lower bounds for the remaining states
-    if (!OPEN2D_->emptyheap())
-        largestcomputedoptf_ = OPEN2D_->getminkeyheap();
+    if (!OPEN2D_.emptyheap())
+        largestcomputedoptf_ = OPEN2D_.getminkeyheap();
     else
         largestcomputedoptf_ = INFINITECOST;
 
     free(pbClosed);
 
+    //OPEN is kept for repair(), its keys are g-values unless h-values were used
+    repairable_ = (termination_condition != SBPL_2DGRIDSEARCH_TERM_CONDITION_OPTPATHFOUND);
+    obsthreshusedlast_ = obsthresh;
+    openinheap_ = true;
+
     SBPL_PRINTF( "# of expands during 2dgridsearch=%d time=%d msecs 2Dsolcost_inmm=%d "
                 "largestoptfval=%d (start=%d %d goal=%d %d)\n",
                 numofExpands, (int)(((clock() - starttime) / (double)CLOCKS_PER_SEC) * 1000),
-                searchStates2D_[goalx_c][goaly_c].g, largestcomputedoptf_, startx_c, starty_c, goalx_c, goaly_c);
+                getg(goalindex), largestcomputedoptf_, startx_c, starty_c, goalx_c, goaly_c);
 
     return true;
 }
 
 //experimental version
-//have only one copy of a state in the list, but the order of expansions is
-//BFS with possible re-expansions. Thus the order can be maintained by FIFO
-//queue implemented by list (requires though the implementation of the lastelement in the list)
-bool SBPL2DGridSearch::search_exp(unsigned char** Grid2D, unsigned char obsthresh, int startx_c, int starty_c,
-                                  int goalx_c, int goaly_c)
-{
-    SBPL_2DGridSearchState *searchExpState = NULL;
-    SBPL_2DGridSearchState *searchPredState = NULL;
+//OPEN list is implemented as a sliding bucket list
+bool SBPL2DGridSearch::search_withslidingbuckets(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int startx_c,
+                                                 int starty_c, int goalx_c, int goaly_c,
+                                                 SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition)
+{
     int numofExpands = 0;
-    CList OPEN2DLIST;
 
-    //get the current time
-    clock_t starttime = clock();
+#if DEBUG
+#ifndef ROS
+    const char* f2dgriddebug = "2dgriddebug.txt";
+#endif
+    FILE* f2Dsearch = SBPL_FOPEN(f2dgriddebug, "w");
+#endif
 
     //closed = 0
     iteration_++;
@@ -503,30 +524,73 @@ bool SBPL2DGridSearch::search_exp(unsigned char** Grid2D, unsigned char obsthres
     if (!withinMap(startx_c, starty_c) || !withinMap(goalx_c, goaly_c)) {
         SBPL_ERROR("ERROR: grid2Dsearch is called on invalid start (%d %d) or goal(%d %d)\n", startx_c, starty_c,
                    goalx_c, goaly_c);
+#if DEBUG
+        SBPL_FCLOSE(f2Dsearch);
+#endif
         return false;
     }
 
-    // initialize the start and goal states
-    searchExpState = &searchStates2D_[startX_][startY_];
-    initializeSearchState2D(searchExpState);
-    //no initialization for the goal state - it will reset iteration_ variable
+    //reset OPEN (and the heap OPEN of the last repair)
+    OPEN2DBLIST_->reset();
+    OPEN2D_.makeemptyheap();
+
+    //set the term. condition
+    term_condition_usedlast = termination_condition;
+
+    //the g-values of the new iteration start at INFINITECOST
+    const int goalindex = getcellindex(goalx_c, goaly_c);
 
     //seed the search
-    searchExpState->g = 0;
-    searchExpState->listelem[SBPL_2DSEARCH_OPEN_LIST_ID] = NULL;
-    OPEN2DLIST.insertinfront(searchExpState, SBPL_2DSEARCH_OPEN_LIST_ID);
+    int startindex = getcellindex(startX_, startY_);
+    setg(startindex, 0);
+    OPEN2DBLIST_->insert(startindex, 0);
+
+    //set the termination condition
+    float term_factor = computetermfactor(termination_condition);
+
+    //get the current time
+    clock_t starttime = clock();
+
+    char *pbClosed = (char*)calloc(1, width_ * height_);
 
     //the main repetition of expansions
-    while (!OPEN2DLIST.empty()) {
+    SBPL_PRINTF("2D search with sliding buckets and term_factor=%.3f\n", term_factor);
+    int prevg = 0;
+    while (!OPEN2DBLIST_->empty() &&
+           (termination_condition == SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS ||
+            getg(goalindex) > term_factor * OPEN2DBLIST_->getminkey()))
+    {
+#if DEBUG
+        SBPL_FPRINTF(f2Dsearch, "currentminelement_priority before pop=%d\n", OPEN2DBLIST_->getminkey());
+#endif
+
         //get the next state for expansion
-        searchExpState = (SBPL_2DGridSearchState*)OPEN2DLIST.getlast();
-        OPEN2DLIST.remove(searchExpState, SBPL_2DSEARCH_OPEN_LIST_ID);
-        numofExpands++;
+        int expindex = OPEN2DBLIST_->popminelement();
+        int expg = getg(expindex);
 
-        int exp_x = searchExpState->x;
-        int exp_y = searchExpState->y;
+        int exp_x = getcellx(expindex);
+        int exp_y = getcelly(expindex);
+
+        if (!OPEN2DBLIST_->empty() && expg > OPEN2DBLIST_->getminkey()) {
+            SBPL_ERROR("ERROR: g=%d for state %d %d but minpriority=%d (prevg=%d)\n", expg,
+                       exp_x, exp_y, OPEN2DBLIST_->getminkey(), prevg);
+        }
+        prevg = expg;
+
+        //close the state if it wasn't yet
+        if (pbClosed[exp_x + width_ * exp_y] == 1) continue;
+        pbClosed[exp_x + width_ * exp_y] = 1;
+
+#if DEBUG
+        SBPL_FPRINTF(f2Dsearch, "expanding state <%d %d> with g=%d (currentminelement_priority=%d)\n",
+                     exp_x, exp_y, expg, OPEN2DBLIST_->getminkey());
+#endif
+
+        //expand
+        numofExpands++;
 
         //iterate over successors
+        int expcost = getCost(Grid2D, stride, exp_x, exp_y, downsample_);
         for (int dir = 0; dir < SBPL_2DGRIDSEARCH_NUMOF2DDIRS; dir++) {
             int newx = exp_x + dx_[dir];
             int newy = exp_y + dy_[dir];
@@ -534,14 +598,16 @@ bool SBPL2DGridSearch::search_exp(unsigned char** Grid2D, unsigned char obsthres
             //make sure it is inside the map and has no obstacle
             if (!withinMap(newx, newy)) continue;
 
+            if (pbClosed[newx + width_ * newy] == 1) continue;
+
             //compute the cost
-            int mapcost = __max( getCost(Grid2D, newx, newy, downsample_), getCost(Grid2D, exp_x, exp_y, downsample_));
+            int mapcost = __max( getCost(Grid2D, stride, newx, newy, downsample_), expcost);
 
 #if SBPL_2DGRIDSEARCH_NUMOF2DDIRS > 8
             if(dir > 7) {
                 //check two more cells through which the action goes
-                mapcost = __max(mapcost, getCost(Grid2D, exp_x + dx0intersects_[dir], exp_y + dy0intersects_[dir], downsample_));
-                mapcost = __max(mapcost, getCost(Grid2D, exp_x + dx1intersects_[dir], exp_y + dy1intersects_[dir], downsample_));
+                mapcost = __max(mapcost, getCost(Grid2D, stride, exp_x + dx0intersects_[dir], exp_y + dy0intersects_[dir], downsample_));
+                mapcost = __max(mapcost, getCost(Grid2D, stride, exp_x + dx1intersects_[dir], exp_y + dy1intersects_[dir], downsample_));
             }
 #endif
 
@@ -549,61 +615,64 @@ bool SBPL2DGridSearch::search_exp(unsigned char** Grid2D, unsigned char obsthres
             continue;
             int cost = (mapcost + 1) * dxy_distance_mm_[dir];
 
-            //get the predecessor
-            searchPredState = &searchStates2D_[newx][newy];
-
-            //clear the list
-            if (searchPredState->iterationaccessed != iteration_) searchPredState->listelem[SBPL_2DSEARCH_OPEN_LIST_ID]
-                = NULL;
-
             //update predecessor if necessary
-            if (searchPredState->iterationaccessed != iteration_ || searchPredState->g > cost + searchExpState->g) {
-                searchPredState->iterationaccessed = iteration_;
-                searchPredState->g = __min(INFINITECOST, cost + searchExpState->g);
+            int newindex = getcellindex(newx, newy);
+            int newg = __min(INFINITECOST, cost + expg);
+            if (getg(newindex) > newg) {
+                setg(newindex, newg);
 
-                if (searchPredState->g >= INFINITECOST) {
-                    throw SBPL_Exception("ERROR: infinite g");
-                }
+#if DEBUG
+                SBPL_FPRINTF(f2Dsearch, "inserting state <%d %d> with g=%d\n", newx, newy, newg);
+#endif
 
-                //put it into the list if not there already
-                if (searchPredState->listelem[SBPL_2DSEARCH_OPEN_LIST_ID] == NULL)
-                    OPEN2DLIST.insertinfront(searchPredState, SBPL_2DSEARCH_OPEN_LIST_ID);
-                //otherwise, the state remains where it is but it now has a new g-value
+                //put it into the list
+                OPEN2DBLIST_->insert(newindex, newg);
             }
         } //over successors
     }//while
 
-    //set lower bounds for the remaining states - none left since we exhausted the whole list
-    largestcomputedoptf_ = INFINITECOST;
+    //set lower bounds for the remaining states
+    if (!OPEN2DBLIST_->empty())
+        largestcomputedoptf_ = getg(OPEN2DBLIST_->getminelement());
+    else
+        largestcomputedoptf_ = INFINITECOST;
+
+    //delete[] pbClosed;
+    free(pbClosed);
+
+    //OPEN is kept for repair()
+    repairable_ = true;
+    obsthreshusedlast_ = obsthresh;
+    openinheap_ = false;
 
     SBPL_PRINTF( "# of expands during 2dgridsearch=%d time=%d msecs 2Dsolcost_inmm=%d "
                 "largestoptfval=%d (start=%d %d goal=%d %d)\n",
                 numofExpands, (int)(((clock() - starttime) / (double)CLOCKS_PER_SEC) * 1000),
-                searchStates2D_[goalx_c][goaly_c].g, largestcomputedoptf_, startx_c, starty_c, goalx_c, goaly_c);
+                getg(goalindex), largestcomputedoptf_, startx_c, starty_c, goalx_c, goaly_c);
 
-    return false;
+#if DEBUG
+    SBPL_FCLOSE(f2Dsearch);
+#endif
+    return true;
 }
 
-//experimental version
-//OPEN list is implemented as a bucket list
-bool SBPL2DGridSearch::search_withbuckets(unsigned char** Grid2D, unsigned char obsthresh, int startx_c, int starty_c,
-                                          int goalx_c, int goaly_c)
-{
-    SBPL_2DGridSearchState *searchExpState = NULL;
-    SBPL_2DGridSearchState *searchPredState = NULL;
-    int numofExpands = 0;
 
-    //get the current time
-    clock_t starttime = clock();
+//-----------------------------------------parallel search--------------------------------------------------------------
 
-    //int max_bucketed_priority = obsthresh*10*__max(this->width_, this->height_);
-    int max_bucketed_priority = (int)(0.1 * obsthresh * dxy_distance_mm_[0] * __max(this->width_, this->height_));
-    SBPL_PRINTF("bucket-based OPEN2D has up to %d bucketed priorities, the rest will be unsorted\n",
-                max_bucketed_priority);
-    CBucket OPEN2DBLIST(0, max_bucketed_priority);
+void SBPL2DGridSearch::setnumthreads(int numthreads)
+{
+    numthreads = __max(1, numthreads);
+    if (numthreads == numthreads_) return;
 
-    SBPL_PRINTF("OPEN2D allocation time=%d msecs\n", (int)(((clock() - starttime) / (double)CLOCKS_PER_SEC) * 1000));
+    delete workers_;
+    workers_ = (numthreads > 1) ? new SBPLWorkerPool(numthreads - 1) : NULL;
+    numthreads_ = numthreads;
+}
 
+bool SBPL2DGridSearch::search_withparallelbuckets(const unsigned char* Grid2D, int stride, unsigned char obsthresh,
+                                                  int startx_c, int starty_c, int goalx_c, int goaly_c,
+                                                  SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition)
+{
     //closed = 0
     iteration_++;
 
@@ -620,261 +689,752 @@ bool SBPL2DGridSearch::search_withbuckets(unsigned char** Grid2D, unsigned char
         return false;
     }
 
-    // initialize the start and goal states
-    searchExpState = &searchStates2D_[startX_][startY_];
-    initializeSearchState2D(searchExpState);
-    //no initialization for the goal state - it will reset iteration_ variable
+    //reset the heap OPEN of the last repair
+    OPEN2D_.makeemptyheap();
+
+    //set the term. condition
+    term_condition_usedlast = termination_condition;
+    float term_factor = computetermfactor(termination_condition);
+
+    //the threads set the g-values in any block, so all the blocks are
+    //initialized up front
+    const int numofblocks = widthinblocks_ * heightinblocks_;
+    const std::function<void(int)> initializechunk = [&](int chunk)
+    {
+        int begin = (int)((long)numofblocks * chunk / numthreads_);
+        int end = (int)((long)numofblocks * (chunk + 1) / numthreads_);
+        for (int block = begin; block < end; block++) {
+            initializeblock(block);
+        }
+    };
+    if (workers_ != NULL) {
+        workers_->run(numthreads_, initializechunk);
+    }
+    else {
+        initializechunk(0);
+    }
+
+    //with the buckets as wide as the cheapest transition, the states in a
+    //bucket can only be improved from the earlier buckets, so their g-values
+    //are final once the bucket is reached and all of them can be expanded at
+    //once. The buckets are reused cyclically, a transition spans fewer than
+    //numofbuckets of them.
+    int bucketwidth = INFINITECOST;
+    int maxdistance = 0;
+    for (int dind = 0; dind < SBPL_2DGRIDSEARCH_NUMOF2DDIRS; dind++) {
+        bucketwidth = __min(bucketwidth, dxy_distance_mm_[dind]);
+        maxdistance = __max(maxdistance, dxy_distance_mm_[dind]);
+    }
+    bucketwidth = __max(1, bucketwidth);
+    const int numofbuckets = (int)obsthresh * maxdistance / bucketwidth + 2;
+
+    //every chunk of a bucket is expanded by one call and inserts into its own
+    //buckets, which makes bucket b the concatenation of buckets[0..numofchunks-1][b]
+    typedef std::pair<int, int> entry_t; //cell index and its g-value when it was inserted
+    const int numofchunks = numthreads_;
+    std::vector<std::vector<std::vector<entry_t> > > buckets(numofchunks, std::vector<std::vector<entry_t> >(numofbuckets));
+    std::vector<int> numofinserts(numofchunks, 0);
+    std::vector<int> numofexpands(numofchunks, 0);
+    std::vector<int> chunkoffsets(numofchunks + 1, 0);
 
     //seed the search
-    searchExpState->g = 0;
-    searchExpState->heapindex = -1;
-    OPEN2DBLIST.insert(searchExpState, searchExpState->g);
+    const int startindex = getcellindex(startX_, startY_);
+    const int goalindex = getcellindex(goalX_, goalY_);
+    setg(startindex, 0);
+    buckets[0][0].push_back(entry_t(startindex, 0));
+    long numofentries = 1;
+
+    int slot = 0;
+    const std::function<void(int)> expandchunk = [&](int chunk)
+    {
+        int begin = (int)((long)chunkoffsets[numofchunks] * chunk / numofchunks);
+        int end = (int)((long)chunkoffsets[numofchunks] * (chunk + 1) / numofchunks);
+        int list = 0;
+        for (int i = begin; i < end; i++) {
+            while (i >= chunkoffsets[list + 1]) list++;
+            const entry_t entry = buckets[list][slot][i - chunkoffsets[list]];
 
-    //the main repetition of expansions
-    while (!OPEN2DBLIST.empty()) {
-        //get the next state for expansion
-        searchExpState = (SBPL_2DGridSearchState*)OPEN2DBLIST.popminelement();
-        numofExpands++;
+            //skip the entries whose state has got a smaller g-value since
+            if (getg(entry.first) != entry.second) continue;
+            numofexpands[chunk]++;
 
-        int exp_x = searchExpState->x;
-        int exp_y = searchExpState->y;
+            int exp_x = getcellx(entry.first);
+            int exp_y = getcelly(entry.first);
 
-        //iterate over successors
-        for (int dir = 0; dir < SBPL_2DGRIDSEARCH_NUMOF2DDIRS; dir++) {
-            int newx = exp_x + dx_[dir];
-            int newy = exp_y + dy_[dir];
+            //iterate over successors
+            int expcost = getCost(Grid2D, stride, exp_x, exp_y, downsample_);
+            for (int dir = 0; dir < SBPL_2DGRIDSEARCH_NUMOF2DDIRS; dir++) {
+                int newx = exp_x + dx_[dir];
+                int newy = exp_y + dy_[dir];
 
-            //make sure it is inside the map and has no obstacle
-            if (!withinMap(newx, newy)) continue;
+                //make sure it is inside the map and has no obstacle
+                if (!withinMap(newx, newy)) continue;
 
-            //compute the cost
-            int mapcost = __max( getCost(Grid2D, newx, newy, downsample_), getCost(Grid2D, exp_x, exp_y, downsample_));
+                //compute the cost
+                int mapcost = __max(getCost(Grid2D, stride, newx, newy, downsample_), expcost);
 
 #if SBPL_2DGRIDSEARCH_NUMOF2DDIRS > 8
-            if(dir > 7) {
-                //check two more cells through which the action goes
-                mapcost = __max(mapcost, getCost(Grid2D, exp_x + dx0intersects_[dir], exp_y + dy0intersects_[dir], downsample_));
-                mapcost = __max(mapcost, getCost(Grid2D, exp_x + dx1intersects_[dir], exp_y + dy1intersects_[dir], downsample_));
-            }
+                if (dir > 7) {
+                    //check two more cells through which the action goes
+                    mapcost = __max(mapcost, getCost(Grid2D, stride, exp_x + dx0intersects_[dir], exp_y + dy0intersects_[dir], downsample_));
+                    mapcost = __max(mapcost, getCost(Grid2D, stride, exp_x + dx1intersects_[dir], exp_y + dy1intersects_[dir], downsample_));
+                }
 #endif
 
-            if (mapcost >= obsthresh) //obstacle encountered
-            continue;
-            int cost = (mapcost + 1) * dxy_distance_mm_[dir];
-
-            //get the predecessor
-            searchPredState = &searchStates2D_[newx][newy];
+                if (mapcost >= obsthresh) //obstacle encountered
+                    continue;
+                int newg = __min(INFINITECOST, (mapcost + 1) * dxy_distance_mm_[dir] + entry.second);
+
+                //lower the g-value of the successor unless another thread has
+                //set it lower already
+                int newindex = getcellindex(newx, newy);
+                int oldg = g_[newindex].load(std::memory_order_relaxed);
+                while (newg < oldg &&
+                       !g_[newindex].compare_exchange_weak(oldg, newg, std::memory_order_relaxed))
+                {
+                }
+                if (newg >= oldg) continue;
 
-            //clear the element from OPEN
-            if (searchPredState->iterationaccessed != iteration_) searchPredState->heapindex = -1;
+                buckets[chunk][(newg / bucketwidth) % numofbuckets].push_back(entry_t(newindex, newg));
+                numofinserts[chunk]++;
+            }
+        }
+    };
 
-            //update predecessor if necessary
-            if (searchPredState->iterationaccessed != iteration_ || searchPredState->g > cost + searchExpState->g) {
-                int oldstatepriority = searchPredState->g;
-                searchPredState->iterationaccessed = iteration_;
-                searchPredState->g = __min(INFINITECOST, cost + searchExpState->g);
+    //the main repetition of expansions, a bucket at a time
+    largestcomputedoptf_ = INFINITECOST;
+    int numofbucketsexpanded = 0;
+    for (int bucket = 0; numofentries > 0; bucket++) {
+        slot = bucket % numofbuckets;
 
-                if (searchPredState->g >= INFINITECOST) {
-                    throw SBPL_Exception("ERROR: infinite g");
+        for (int list = 0; list < numofchunks; list++) {
+            chunkoffsets[list + 1] = chunkoffsets[list] + (int)buckets[list][slot].size();
+        }
+        int bucketsize = chunkoffsets[numofchunks];
+        if (bucketsize == 0) continue;
+
+        //stop before the bucket if the termination condition holds for its
+        //smallest g-value, the smallest key in OPEN
+        if (termination_condition != SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS) {
+            int minkey = INFINITECOST;
+            for (int list = 0; list < numofchunks; list++) {
+                for (size_t i = 0; i < buckets[list][slot].size(); i++) {
+                    const entry_t& entry = buckets[list][slot][i];
+                    if (entry.second < minkey && getg(entry.first) == entry.second) {
+                        minkey = entry.second;
+                    }
                 }
+            }
+            if (minkey < INFINITECOST && __min(INFINITECOST, getg(goalindex)) <= term_factor * minkey) {
+                largestcomputedoptf_ = minkey;
+                break;
+            }
+        }
 
-                //put it into the list if not there already
-                if (searchPredState->heapindex != -1) OPEN2DBLIST.remove(searchPredState, oldstatepriority);
-                OPEN2DBLIST.insert(searchPredState, searchPredState->g);
+        if (workers_ != NULL && bucketsize >= SBPL_2DGRIDSEARCH_PARALLELMINBUCKET) {
+            workers_->run(numofchunks, expandchunk);
+        }
+        else {
+            for (int chunk = 0; chunk < numofchunks; chunk++) {
+                expandchunk(chunk);
             }
-        } //over successors
-    }//while
+        }
+        numofbucketsexpanded++;
 
-    //set lower bounds for the remaining states
-    if (!OPEN2DBLIST.empty())
-        largestcomputedoptf_ = OPEN2DBLIST.getminpriority();
-    else
-        largestcomputedoptf_ = INFINITECOST;
+        numofentries -= bucketsize;
+        for (int list = 0; list < numofchunks; list++) {
+            buckets[list][slot].clear();
+            numofentries += numofinserts[list];
+            numofinserts[list] = 0;
+        }
+    }
 
-    SBPL_PRINTF( "# of expands during 2dgridsearch=%d time=%d msecs 2Dsolcost_inmm=%d "
-                "largestoptfval=%d bucketassortedarraymaxsize=%d (start=%d %d goal=%d %d)\n",
-                numofExpands, (int)(((clock() - starttime) / (double)CLOCKS_PER_SEC) * 1000),
-                searchStates2D_[goalx_c][goaly_c].g, largestcomputedoptf_, OPEN2DBLIST.maxassortedpriorityVsize,
-                startx_c, starty_c, goalx_c, goaly_c);
+    //OPEN is kept for repair() in OPEN2D_: the entries left in the buckets
+    //that still hold the g-value of their state
+    if (numofentries > 0) {
+        for (int list = 0; list < numofchunks; list++) {
+            for (int bind = 0; bind < numofbuckets; bind++) {
+                for (size_t i = 0; i < buckets[list][bind].size(); i++) {
+                    const entry_t& entry = buckets[list][bind][i];
+                    if (getg(entry.first) == entry.second) {
+                        OPEN2D_.insertheap(entry.first, entry.second);
+                    }
+                }
+            }
+        }
+    }
+    repairable_ = true;
+    obsthreshusedlast_ = obsthresh;
+    openinheap_ = true;
 
-    return false;
+    int numofExpands = 0;
+    for (int chunk = 0; chunk < numofchunks; chunk++) {
+        numofExpands += numofexpands[chunk];
+    }
+
+    SBPL_PRINTF("# of expands during 2dgridsearch=%d buckets=%d threads=%d 2Dsolcost_inmm=%d "
+                "largestoptfval=%d (start=%d %d goal=%d %d)\n",
+                numofExpands, numofbucketsexpanded, numthreads_, getg(goalindex), largestcomputedoptf_, startx_c, starty_c, goalx_c, goaly_c);
+
+    return true;
 }
 
-//experimental version
-//OPEN list is implemented as a sliding bucket list
-bool SBPL2DGridSearch::search_withslidingbuckets(unsigned char** Grid2D, unsigned char obsthresh, int startx_c,
-                                                 int starty_c, int goalx_c, int goaly_c,
-                                                 SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition)
+//-----------------------------------------incremental repair-----------------------------------------------------------
+
+//returns the cost of the transition from <x,y> in direction dir (the same as
+//the cost of the reverse transition) or INFINITECOST if it is not possible
+inline int SBPL2DGridSearch::computeedgecost(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int x, int y,
+                                             int dir)
 {
-    SBPL_2DGridSearchState *searchExpState = NULL;
-    SBPL_2DGridSearchState *searchPredState = NULL;
-    int numofExpands = 0;
+    int newx = x + dx_[dir];
+    int newy = y + dy_[dir];
+    if (!withinMap(newx, newy)) return INFINITECOST;
 
-#if DEBUG
-#ifndef ROS
-    const char* f2dgriddebug = "2dgriddebug.txt";
-#endif
-    FILE* f2Dsearch = SBPL_FOPEN(f2dgriddebug, "w");
+    int mapcost = __max(getCost(Grid2D, stride, newx, newy, downsample_), getCost(Grid2D, stride, x, y, downsample_));
+
+#if SBPL_2DGRIDSEARCH_NUMOF2DDIRS > 8
+    if (dir > 7) {
+        //check two more cells through which the action goes
+        mapcost = __max(mapcost, getCost(Grid2D, stride, x + dx0intersects_[dir], y + dy0intersects_[dir], downsample_));
+        mapcost = __max(mapcost, getCost(Grid2D, stride, x + dx1intersects_[dir], y + dy1intersects_[dir], downsample_));
+    }
 #endif
 
-    //closed = 0
-    iteration_++;
+    if (mapcost >= obsthresh) return INFINITECOST;
+    return (mapcost + 1) * dxy_distance_mm_[dir];
+}
 
-    //init start and goal coordinates
-    startX_ = startx_c;
-    startY_ = starty_c;
-    goalX_ = goalx_c;
-    goalY_ = goaly_c;
+//returns the smallest g-value the cell with index can get through the
+//neighbors whose g-values are known (at most largestknownf)
+inline int SBPL2DGridSearch::computebestcostfromknown(const unsigned char* Grid2D, int stride, unsigned char obsthresh,
+                                                      int index, int largestknownf)
+{
+    int x = getcellx(index);
+    int y = getcelly(index);
+    int bestg = INFINITECOST;
+    for (int dir = 0; dir < SBPL_2DGRIDSEARCH_NUMOF2DDIRS; dir++) {
+        int newx = x + dx_[dir];
+        int newy = y + dy_[dir];
+        if (!withinMap(newx, newy)) continue;
+
+        int nbrg = getg(getcellindex(newx, newy));
+        if (nbrg >= INFINITECOST || nbrg > largestknownf) continue;
+
+        int cost = computeedgecost(Grid2D, stride, obsthresh, x, y, dir);
+        if (cost < INFINITECOST) bestg = __min(bestg, nbrg + cost);
+    }
+    return bestg;
+}
 
-    //check the validity of start/goal
-    if (!withinMap(startx_c, starty_c) || !withinMap(goalx_c, goaly_c)) {
-        SBPL_ERROR("ERROR: grid2Dsearch is called on invalid start (%d %d) or goal(%d %d)\n", startx_c, starty_c,
-                   goalx_c, goaly_c);
-#if DEBUG
-        SBPL_FCLOSE(f2Dsearch);
-#endif
-        return false;
+//pops the entries left behind by the cells whose keys went down (see
+//SBPL2DGridSearchHeap) off the top of OPEN2D_. The key of a cell is its
+//g-value, plus its h-value if usehvalues.
+inline void SBPL2DGridSearch::dropstaleOPENentries(bool usehvalues)
+{
+    while (!OPEN2D_.emptyheap()) {
+        int index = OPEN2D_.getminheap();
+        int key = getg(index);
+        if (usehvalues) key += SBPL_2DGRIDSEARCH_HEUR2D(getcellx(index), getcelly(index));
+        if (OPEN2D_.getminkeyheap() == key) return;
+        OPEN2D_.deleteminheap();
     }
+}
 
-    //reset OPEN
-    OPEN2DBLIST_->reset();
+//takes the cells out of OPEN (OPEN2D_ or OPEN2DBLIST_, see openinheap_),
+//leaving OPEN2D_ empty, and returns the smallest g-value among them
+int SBPL2DGridSearch::takeOPENstates(std::vector<int>* openstates)
+{
+    std::vector<SBPL2DGridSearchHeap::entry_t> entries;
+    int minopeng = largestcomputedoptf_;
+    if (openinheap_) {
+        entries = OPEN2D_.getentries();
+    }
+    else {
+        //the g-value of the first cell in the sliding buckets, which
+        //largestcomputedoptf_ is set to, may be the one of a stale entry.
+        //The smallest g-value among the cells in OPEN can be larger.
+        OPEN2DBLIST_->getentries(&entries);
+        minopeng = INFINITECOST;
+    }
 
-    //set the term. condition
+    //the entry of a cell in OPEN is the one with its g-value
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (getg(entries[i].second) != entries[i].first) continue;
+        openstates->push_back(entries[i].second);
+        if (!openinheap_) minopeng = __min(minopeng, entries[i].first);
+    }
+    OPEN2D_.makeemptyheap();
+
+    return minopeng;
+}
+
+//Dijkstra's expansion of the cell with index with OPEN in OPEN2D_
+inline void SBPL2DGridSearch::expandstateinheap(const unsigned char* Grid2D, int stride, unsigned char obsthresh,
+                                                int index)
+{
+    int x = getcellx(index);
+    int y = getcelly(index);
+    int g = getg(index);
+    for (int dir = 0; dir < SBPL_2DGRIDSEARCH_NUMOF2DDIRS; dir++) {
+        int cost = computeedgecost(Grid2D, stride, obsthresh, x, y, dir);
+        if (cost >= INFINITECOST) continue;
+
+        int predindex = getcellindex(x + dx_[dir], y + dy_[dir]);
+        int newg = __min(INFINITECOST, cost + g);
+        if (getg(predindex) > newg) {
+            setg(predindex, newg);
+            OPEN2D_.insertheap(predindex, newg);
+        }
+    }
+}
+
+bool SBPL2DGridSearch::repair(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int startx_c, int starty_c,
+                              int goalx_c, int goaly_c, SBPL_2DGRIDSEARCH_TERM_CONDITION termination_condition,
+                              const std::vector<sbpl_2Dcell_t>& changedcells)
+{
+    if (!repairable_ || obsthresh != obsthreshusedlast_ ||
+        termination_condition == SBPL_2DGRIDSEARCH_TERM_CONDITION_OPTPATHFOUND ||
+        startx_c / downsample_ != startX_ || starty_c / downsample_ != startY_ ||
+        !withinMap(goalx_c / downsample_, goaly_c / downsample_))
+    {
+        return search(Grid2D, stride, obsthresh, startx_c, starty_c, goalx_c, goaly_c, termination_condition);
+    }
+
+    int numofExpands = 0;
+    int numofInvalidated = 0;
+
+    goalX_ = goalx_c / downsample_;
+    goalY_ = goaly_c / downsample_;
     term_condition_usedlast = termination_condition;
 
-    // initialize the start and goal states
-    searchExpState = &searchStates2D_[startX_][startY_];
-    initializeSearchState2D(searchExpState);
-    initializeSearchState2D(&searchStates2D_[goalx_c][goaly_c]);
-    SBPL_2DGridSearchState* search2DGoalState = &searchStates2D_[goalx_c][goaly_c];
+    //the states with g-values up to this one are known (their g-values are
+    //optimal and they have been expanded unless they are in OPEN)
+    int largestknownf = largestcomputedoptf_;
+
+    //take the states out of OPEN, their keys are recomputed below
+    std::vector<int> openstates;
+    largestknownf = __max(largestknownf, takeOPENstates(&openstates));
+
+    //the known states next to the changed cells: the costs of their
+    //transitions may have changed
+    typedef std::pair<int, int> gcell_t;
+    std::priority_queue<gcell_t, std::vector<gcell_t>, std::greater<gcell_t> > invalidationQ;
+    std::vector<int> affectedstates;
+    for (size_t i = 0; i < changedcells.size(); i++) {
+        if (changedcells[i].x < 0 || changedcells[i].y < 0) continue;
+        int cx = changedcells[i].x / downsample_;
+        int cy = changedcells[i].y / downsample_;
+        if (!withinMap(cx, cy)) continue;
+
+        //the transitions of the 16-connected grid go through cells at most 2
+        //cells away from their ends
+        for (int y = __max(0, cy - 2); y <= __min(height_ - 1, cy + 2); y++) {
+            for (int x = __max(0, cx - 2); x <= __min(width_ - 1, cx + 2); x++) {
+                int index = getcellindex(x, y);
+                int g = getg(index);
+                if (g >= INFINITECOST || g > largestknownf) continue;
+                affectedstates.push_back(index);
+                invalidationQ.push(gcell_t(g, index));
+            }
+        }
+    }
 
-    //seed the search
-    searchExpState->g = 0;
-    OPEN2DBLIST_->insert(searchExpState, searchExpState->g);
+    //invalidate, in the order of their g-values, the known states that are no
+    //longer supported by a known predecessor with the new costs (the states
+    //supporting a state have smaller g-values, so they have been processed)
+    const int startindex = getcellindex(startX_, startY_);
+    std::vector<int> invalidatedstates;
+    while (!invalidationQ.empty()) {
+        gcell_t top = invalidationQ.top();
+        invalidationQ.pop();
+
+        int index = top.second;
+        if (getg(index) != top.first || index == startindex) continue;
+
+        int x = getcellx(index);
+        int y = getcelly(index);
+        bool bSupported = false;
+        for (int dir = 0; dir < SBPL_2DGRIDSEARCH_NUMOF2DDIRS && !bSupported; dir++) {
+            int predx = x + dx_[dir];
+            int predy = y + dy_[dir];
+            if (!withinMap(predx, predy)) continue;
+
+            int predg = getg(getcellindex(predx, predy));
+            if (predg >= top.first) continue;
+
+            int cost = computeedgecost(Grid2D, stride, obsthresh, x, y, dir);
+            bSupported = (cost < INFINITECOST && predg + cost == top.first);
+        }
+        if (bSupported) continue;
 
-    //set the termination condition
-    float term_factor = 0.0;
-    switch (termination_condition) {
-    case SBPL_2DGRIDSEARCH_TERM_CONDITION_OPTPATHFOUND:
-        term_factor = 1;
-        break;
-    case SBPL_2DGRIDSEARCH_TERM_CONDITION_20PERCENTOVEROPTPATH:
-        term_factor = (float)(1.0 / 1.2);
-        break;
-    case SBPL_2DGRIDSEARCH_TERM_CONDITION_TWOTIMESOPTPATH:
-        term_factor = 0.5;
-        break;
-    case SBPL_2DGRIDSEARCH_TERM_CONDITION_THREETIMESOPTPATH:
-        term_factor = (float)(1.0 / 3.0);
-        break;
-    case SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS:
-        term_factor = 0.0;
-        break;
-    default:
-        SBPL_ERROR("ERROR: incorrect termination factor for grid2Dsearch\n");
-        term_factor = 0.0;
-    };
+        setg(index, INFINITECOST);
+        invalidatedstates.push_back(index);
+        numofInvalidated++;
 
-    //get the current time
-    clock_t starttime = clock();
+        //the successors may have depended on it
+        for (int dir = 0; dir < SBPL_2DGRIDSEARCH_NUMOF2DDIRS; dir++) {
+            int succx = x + dx_[dir];
+            int succy = y + dy_[dir];
+            if (!withinMap(succx, succy)) continue;
+
+            int succindex = getcellindex(succx, succy);
+            int succg = getg(succindex);
+            if (succg < INFINITECOST && succg > top.first && succg <= largestknownf) {
+                invalidationQ.push(gcell_t(succg, succindex));
+            }
+        }
+    }
 
-    char *pbClosed = (char*)calloc(1, width_ * height_);
+    //seed OPEN with the invalidated states and the states of the old OPEN,
+    //both valued through their known neighbors, and with the known states
+    //next to the changed cells, whose transitions may have got cheaper. Every
+    //state goes into OPEN once, with the g-value it has when it gets there.
+    std::unordered_set<int> seeded;
+    for (size_t i = 0; i < invalidatedstates.size(); i++) {
+        int index = invalidatedstates[i];
+        int g = computebestcostfromknown(Grid2D, stride, obsthresh, index, largestknownf);
+        setg(index, g);
+        if (g < INFINITECOST && seeded.insert(index).second) OPEN2D_.insertheap(index, g);
+    }
+    for (size_t i = 0; i < openstates.size(); i++) {
+        int index = openstates[i];
+        if (seeded.count(index) != 0) continue;
+        int g = getg(index);
+        if (g > largestknownf) {
+            g = computebestcostfromknown(Grid2D, stride, obsthresh, index, largestknownf);
+            setg(index, g);
+        }
+        if (g < INFINITECOST && seeded.insert(index).second) OPEN2D_.insertheap(index, g);
+    }
+    for (size_t i = 0; i < affectedstates.size(); i++) {
+        int index = affectedstates[i];
+        int g = getg(index);
+        if (g < INFINITECOST && seeded.insert(index).second) OPEN2D_.insertheap(index, g);
+    }
 
-    //the main repetition of expansions
-    SBPL_PRINTF("2D search with sliding buckets and term_factor=%.3f\n", term_factor);
-    int prevg = 0;
-    while (!OPEN2DBLIST_->empty() && search2DGoalState->g > term_factor * OPEN2DBLIST_->getminkey()) {
-#if DEBUG
-        SBPL_FPRINTF(f2Dsearch, "currentminelement_priority before pop=%d\n", OPEN2DBLIST_->getminkey());
-#endif
+    const int goalindex = getcellindex(goalX_, goalY_);
 
-        //get the next state for expansion
-        searchExpState = (SBPL_2DGridSearchState*)OPEN2DBLIST_->popminelement();
+    //continue Dijkstra's search at least up to the old bound (beyond it
+    //nothing is known) and until the termination condition holds
+    float term_factor = computetermfactor(termination_condition);
+    while (!OPEN2D_.emptyheap() &&
+           (OPEN2D_.getminkeyheap() < largestknownf ||
+            termination_condition == SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS ||
+            __min(INFINITECOST, getg(goalindex)) > term_factor * OPEN2D_.getminkeyheap()))
+    {
+        expandstateinheap(Grid2D, stride, obsthresh, OPEN2D_.deleteminheap());
+        numofExpands++;
+        dropstaleOPENentries(false);
+    }
+
+    //set lower bounds for the remaining states
+    largestcomputedoptf_ = OPEN2D_.emptyheap() ? INFINITECOST : OPEN2D_.getminkeyheap();
+    openinheap_ = true;
+
+    SBPL_PRINTF("# of expands during 2dgridsearch repair=%d invalidated=%d changedcells=%d "
+                "2Dsolcost_inmm=%d largestoptfval=%d (start=%d %d goal=%d %d)\n",
+                numofExpands, numofInvalidated, (int)changedcells.size(), getg(goalindex),
+                largestcomputedoptf_, startX_, startY_, goalX_, goalY_);
 
-        if (searchExpState->g > OPEN2DBLIST_->getminkey()) {
-            SBPL_ERROR("ERROR: g=%d for state %d %d but minpriority=%d (prevg=%d)\n", searchExpState->g,
-                       searchExpState->x, searchExpState->y, OPEN2DBLIST_->getminkey(), prevg);
+    return true;
+}
+
+int SBPL2DGridSearch::getcostfromstart_inmm(const unsigned char* Grid2D, int stride, unsigned char obsthresh, int x, int y)
+{
+    int index = getcellindex(x / downsample_, y / downsample_);
+
+    //computed already
+    if (getg(index) <= largestcomputedoptf_) {
+        return getg(index);
+    }
+
+    if (!repairable_ || obsthresh != obsthreshusedlast_ ||
+        term_condition_usedlast == SBPL_2DGRIDSEARCH_TERM_CONDITION_OPTPATHFOUND)
+    {
+        return getlowerboundoncostfromstart_inmm(x, y);
+    }
+
+    //the search goes on with OPEN in OPEN2D_
+    if (!openinheap_) {
+        std::vector<int> openstates;
+        takeOPENstates(&openstates);
+        for (size_t i = 0; i < openstates.size(); i++) {
+            OPEN2D_.insertheap(openstates[i], getg(openstates[i]));
         }
-        prevg = searchExpState->g;
+        openinheap_ = true;
+    }
 
-        int exp_x = searchExpState->x;
-        int exp_y = searchExpState->y;
+    //until the g-value of the cell is optimal
+    while (!OPEN2D_.emptyheap() && getg(index) > OPEN2D_.getminkeyheap()) {
+        expandstateinheap(Grid2D, stride, obsthresh, OPEN2D_.deleteminheap());
+        dropstaleOPENentries(false);
+    }
 
-        //close the state if it wasn't yet
-        if (pbClosed[exp_x + width_ * exp_y] == 1) continue;
-        pbClosed[exp_x + width_ * exp_y] = 1;
+    //set lower bounds for the remaining states
+    largestcomputedoptf_ = OPEN2D_.emptyheap() ? INFINITECOST : OPEN2D_.getminkeyheap();
 
-#if DEBUG
-        SBPL_FPRINTF(f2Dsearch, "expanding state <%d %d> with g=%d "
-                     "(currentminelement_priority=%d, currentfirstbucket_bindex=%d, currentfirstbucket_priority=%d)\n",
-                     searchExpState->x, searchExpState->y, searchExpState->g, OPEN2DBLIST_->getminkey(),
-                     OPEN2DBLIST_->currentfirstbucket_bindex, OPEN2DBLIST_->currentfirstbucket_priority);
-#endif
+    return getlowerboundoncostfromstart_inmm(x, y);
+}
 
-        //expand
-        numofExpands++;
+//-----------------------------------------OPEN lists-------------------------------------------------------------------
 
-        //iterate over successors
-        int expcost = getCost(Grid2D, exp_x, exp_y, downsample_);
-        for (int dir = 0; dir < SBPL_2DGRIDSEARCH_NUMOF2DDIRS; dir++) {
-            int newx = exp_x + dx_[dir];
-            int newy = exp_y + dy_[dir];
+void SBPL2DGridSearchHeap::insertheap(int index, int key)
+{
+    heap_.push_back(entry_t(key, index));
+    std::push_heap(heap_.begin(), heap_.end(), std::greater<entry_t>());
+}
 
-            //make sure it is inside the map and has no obstacle
-            if (!withinMap(newx, newy)) continue;
+int SBPL2DGridSearchHeap::deleteminheap()
+{
+    std::pop_heap(heap_.begin(), heap_.end(), std::greater<entry_t>());
+    int index = heap_.back().second;
+    heap_.pop_back();
+    return index;
+}
 
-            if (pbClosed[newx + width_ * newy] == 1) continue;
+SBPL2DGridSearchBuckets::SBPL2DGridSearchBuckets(int numofbuckets, int initialbucketsize)
+{
+    buckets_.resize(__max(1, numofbuckets));
+    initialbucketsize_ = __max(1, initialbucketsize);
+    firstkey_ = 0;
+    minkey_ = 0;
+    minelement_ = 0;
+    numofelements_ = 0;
+}
 
-            //compute the cost
-            int mapcost = __max( getCost(Grid2D, newx, newy, downsample_), expcost);
+void SBPL2DGridSearchBuckets::recomputemin()
+{
+    const int numofbuckets = (int)buckets_.size();
+    while (minelement_ == buckets_[minkey_ % numofbuckets].size()) {
+        //the bucket is reused for the key numofbuckets larger
+        buckets_[minkey_ % numofbuckets].clear();
+        minkey_++;
+        minelement_ = 0;
+    }
+}
 
-#if SBPL_2DGRIDSEARCH_NUMOF2DDIRS > 8
-            if(dir > 7) {
-                //check two more cells through which the action goes
-                mapcost = __max(mapcost, getCost(Grid2D, exp_x + dx0intersects_[dir], exp_y + dy0intersects_[dir], downsample_));
-                mapcost = __max(mapcost, getCost(Grid2D, exp_x + dx1intersects_[dir], exp_y + dy1intersects_[dir], downsample_));
-            }
-#endif
+int SBPL2DGridSearchBuckets::getminkey()
+{
+    if (numofelements_ > 0) recomputemin();
+    return minkey_;
+}
 
-            if (mapcost >= obsthresh) //obstacle encountered
-            continue;
-            int cost = (mapcost + 1) * dxy_distance_mm_[dir];
+int SBPL2DGridSearchBuckets::getminelement()
+{
+    recomputemin();
+    return buckets_[minkey_ % buckets_.size()][minelement_];
+}
 
-            //get the predecessor
-            searchPredState = &searchStates2D_[newx][newy];
+int SBPL2DGridSearchBuckets::popminelement()
+{
+    recomputemin();
+    firstkey_ = minkey_;
+    numofelements_--;
+    return buckets_[minkey_ % buckets_.size()][minelement_++];
+}
 
-            //update predecessor if necessary
-            if (searchPredState->iterationaccessed != iteration_ || searchPredState->g > cost + searchExpState->g) {
-                searchPredState->iterationaccessed = iteration_;
-                searchPredState->g = __min(INFINITECOST, cost + searchExpState->g);
+void SBPL2DGridSearchBuckets::insert(int index, int key)
+{
+    const int numofbuckets = (int)buckets_.size();
+    if (key < firstkey_ || key - firstkey_ >= numofbuckets) {
+        std::stringstream ss;
+        ss << "ERROR: invalid priority=" << key << " (currentfirstbucket_priority=" << firstkey_ <<
+                ") used with sliding buckets";
+        throw SBPL_Exception(ss.str());
+    }
 
-#if DEBUG
-                SBPL_FPRINTF(f2Dsearch, "inserting state <%d %d> with g=%d\n", searchPredState->x, searchPredState->y, searchPredState->g);
-#endif
+    //the buckets between firstkey_ and minkey_ are empty
+    if (key < minkey_) {
+        minkey_ = key;
+        minelement_ = 0;
+    }
 
-                //put it into the list
-                OPEN2DBLIST_->insert(searchPredState, searchPredState->g);
+    std::vector<int>& bucket = buckets_[key % numofbuckets];
+    if (bucket.capacity() == 0) bucket.reserve(initialbucketsize_);
+    bucket.push_back(index);
+    numofelements_++;
+}
+
+void SBPL2DGridSearchBuckets::reset()
+{
+    for (size_t bind = 0; bind < buckets_.size(); bind++) {
+        buckets_[bind].clear();
+    }
+    firstkey_ = 0;
+    minkey_ = 0;
+    minelement_ = 0;
+    numofelements_ = 0;
+}
+
+void SBPL2DGridSearchBuckets::getentries(std::vector<SBPL2DGridSearchHeap::entry_t>* entries) const
+{
+    const int numofbuckets = (int)buckets_.size();
+    for (int bind = 0; bind < numofbuckets; bind++) {
+        int key = minkey_ + (bind - minkey_ % numofbuckets + numofbuckets) % numofbuckets;
+        for (size_t eind = (key == minkey_) ? minelement_ : 0; eind < buckets_[bind].size(); eind++) {
+            entries->push_back(SBPL2DGridSearchHeap::entry_t(key, buckets_[bind][eind]));
+        }
+    }
+}
+
+//-----------------------------------------cached searches--------------------------------------------------------------
+
+SBPL2DGridSearchCache::SBPL2DGridSearchCache(int maxfields)
+{
+    maxfields_ = __max(1, maxfields);
+}
+
+//the finalizer of MurmurHash3, a bijection that mixes all the bits
+static inline unsigned long long mixbits(unsigned long long key)
+{
+    key ^= (key >> 33);
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= (key >> 33);
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= (key >> 33);
+    return key;
+}
+
+unsigned long long SBPL2DGridSearchCache::newmapversion()
+{
+    //the hashes of computemapversion have the top bit set
+    static std::atomic<unsigned long long> lastmapversion(0);
+    return ++lastmapversion;
+}
+
+unsigned long long SBPL2DGridSearchCache::computemapversion(const unsigned char* Grid2D, int width, int height,
+                                                            int stride)
+{
+    //mixes in 8 cells at a time, a changed word always changes the hash of
+    //the words up to it as mixbits is a bijection
+    unsigned long long hash = mixbits(((unsigned long long)(unsigned int)width << 32) | (unsigned int)height);
+    for (int y = 0; y < height; y++) {
+        const unsigned char* row = Grid2D + (size_t)y * stride;
+        for (int x = 0; x < width; x += 8) {
+            unsigned long long word = 0;
+            memcpy(&word, row + x, __min(8, width - x));
+            hash = mixbits(hash ^ word) + 0x9e3779b97f4a7c15ULL;
+        }
+    }
+    return hash | (1ULL << 63);
+}
+
+std::shared_ptr<const std::vector<int> > SBPL2DGridSearchCache::getfield(unsigned long long mapversion, int x, int y)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::list<Field>::iterator it = fields_.begin(); it != fields_.end(); ++it) {
+        if (it->mapversion == mapversion && it->x == x && it->y == y) {
+            //the most recently used field goes first
+            fields_.splice(fields_.begin(), fields_, it);
+            return fields_.front().values;
+        }
+    }
+    return std::shared_ptr<const std::vector<int> >();
+}
+
+void SBPL2DGridSearchCache::addfield(unsigned long long mapversion, int x, int y,
+                                     const std::shared_ptr<const std::vector<int> >& values)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::list<Field>::iterator it = fields_.begin(); it != fields_.end(); ++it) {
+        if (it->mapversion == mapversion && it->x == x && it->y == y) {
+            fields_.erase(it);
+            break;
+        }
+    }
+
+    Field field;
+    field.mapversion = mapversion;
+    field.x = x;
+    field.y = y;
+    field.values = values;
+    fields_.push_front(field);
+
+    //drop the least recently used fields
+    while ((int)fields_.size() > maxfields_) {
+        fields_.pop_back();
+    }
+}
+
+void SBPL2DGridSearchCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    fields_.clear();
+}
+
+int SBPL2DGridSearchCache::getnumfields() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (int)fields_.size();
+}
+
+bool SBPL2DGridSearch::searchcached(SBPL2DGridSearchCache* cache, unsigned long long mapversion,
+                                    const unsigned char* Grid2D, int stride, unsigned char obsthresh,
+                                    int startx_c, int starty_c, int goalx_c, int goaly_c)
+{
+    if (cache == NULL || !withinMap(startx_c / downsample_, starty_c / downsample_) ||
+        !withinMap(goalx_c / downsample_, goaly_c / downsample_))
+    {
+        return search(Grid2D, stride, obsthresh, startx_c, starty_c, goalx_c, goaly_c,
+                      SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS);
+    }
+
+    //the values also depend on the parameters of the search
+    unsigned int cellsizebits;
+    memcpy(&cellsizebits, &cellSize_m_, sizeof(cellsizebits));
+    const unsigned long long fieldversion = mixbits(
+            mapversion ^ mixbits(((unsigned long long)cellsizebits << 32) | ((unsigned long long)downsample_ << 8) |
+                                 obsthresh));
+
+    std::shared_ptr<const std::vector<int> > values =
+            cache->getfield(fieldversion, startx_c / downsample_, starty_c / downsample_);
+
+    //a field of another search over the same map version
+    if (values && values->size() != (size_t)width_ * height_) {
+        values.reset();
+    }
+
+    if (!values) {
+        if (!search(Grid2D, stride, obsthresh, startx_c, starty_c, goalx_c, goaly_c,
+                    SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS))
+        {
+            return false;
+        }
+
+        std::shared_ptr<std::vector<int> > newvalues(new std::vector<int>((size_t)width_ * height_));
+        for (int y = 0; y < height_; y++) {
+            for (int x = 0; x < width_; x++) {
+                (*newvalues)[x + (size_t)width_ * y] = __min(INFINITECOST, getg(getcellindex(x, y)));
             }
-        } //over successors
-    }//while
+        }
+        cache->addfield(fieldversion, startX_, startY_, newvalues);
+        return true;
+    }
 
-    //set lower bounds for the remaining states
-    if (!OPEN2DBLIST_->empty())
-        largestcomputedoptf_ = ((SBPL_2DGridSearchState*)OPEN2DBLIST_->getminelement())->g;
-    else
-        largestcomputedoptf_ = INFINITECOST;
+    //set the values as if the search over all cells had been run
+    iteration_++;
+    OPEN2D_.makeemptyheap();
+    for (int y = 0; y < height_; y++) {
+        for (int x = 0; x < width_; x++) {
+            setg(getcellindex(x, y), (*values)[x + (size_t)width_ * y]);
+        }
+    }
 
-    //delete[] pbClosed;
-    free(pbClosed);
+    startX_ = startx_c / downsample_;
+    startY_ = starty_c / downsample_;
+    goalX_ = goalx_c / downsample_;
+    goalY_ = goaly_c / downsample_;
+    largestcomputedoptf_ = INFINITECOST;
+    term_condition_usedlast = SBPL_2DGRIDSEARCH_TERM_CONDITION_ALLCELLS;
 
-    SBPL_PRINTF( "# of expands during 2dgridsearch=%d time=%d msecs 2Dsolcost_inmm=%d "
-                "largestoptfval=%d (start=%d %d goal=%d %d)\n",
-                numofExpands, (int)(((clock() - starttime) / (double)CLOCKS_PER_SEC) * 1000),
-                searchStates2D_[goalx_c][goaly_c].g, largestcomputedoptf_, startx_c, starty_c, goalx_c, goaly_c);
+    //with an empty OPEN the values can be repaired as after a search
+    repairable_ = true;
+    obsthreshusedlast_ = obsthresh;
+    openinheap_ = true;
+
+    SBPL_PRINTF("2dgridsearch values taken from the cache (start=%d %d goal=%d %d 2Dsolcost_inmm=%d)\n",
+                startX_, startY_, goalX_, goalY_, getg(getcellindex(goalX_, goalY_)));
 
-#if DEBUG
-    SBPL_FCLOSE(f2Dsearch);
-#endif
     return true;
 }
 
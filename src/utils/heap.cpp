@@ -27,8 +27,10 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cstring>
 #include <sbpl/sbpl_exception.h>
 #include <sbpl/utils/heap.h>
+#include <sbpl/utils/utils.h>
 
 using namespace std;
 
@@ -296,6 +298,612 @@ AbstractSearchState* CHeap::deleteminheap()
 
 //---------------------------------end of normal (multi-priority) CHeap class-------------------------------------------
 
+//---------------------------------d-ary (multi-priority) CDaryHeap class-----------------------------------------------
+
+//elements are numbered from 1 as in CHeap, the children of element I are
+//FIRSTCHILD(I) to FIRSTCHILD(I) + arity - 1
+#define DARYHEAP_FIRSTCHILD(I) ((((I) - 1) << aritylog) + 2)
+#define DARYHEAP_PARENT(I) ((((I) - 2) >> aritylog) + 1)
+
+#if defined(__GNUC__)
+#define DARYHEAP_PREFETCH(ADDR) __builtin_prefetch(ADDR)
+#else
+#define DARYHEAP_PREFETCH(ADDR)
+#endif
+
+template <int KEYSIZE>
+static inline bool DaryKeyLess(const long int* key1, const long int* key2)
+{
+    //the 0th is the most important key
+    for (int i = 0; i < KEYSIZE - 1; i++) {
+        if (key1[i] != key2[i]) return key1[i] < key2[i];
+    }
+    return key1[KEYSIZE - 1] < key2[KEYSIZE - 1];
+}
+
+//allocates an array of size elements of elemsize bytes, aligned so that
+//element 2 (the first child of the root) and so every group of siblings after
+//it starts on a DARYHEAP_ALIGNMENT boundary
+static char* AllocateDaryHeapArray(int size, size_t elemsize, char** aligned)
+{
+    char* buffer = new char[size * elemsize + DARYHEAP_ALIGNMENT];
+    size_t misalignment = (size_t)(buffer + 2 * elemsize) % DARYHEAP_ALIGNMENT;
+    *aligned = buffer + (DARYHEAP_ALIGNMENT - misalignment) % DARYHEAP_ALIGNMENT;
+    return buffer;
+}
+
+CDaryHeap::CDaryHeap(int arity, int keysize)
+{
+    if (arity < 2 || arity > DARYHEAP_MAXARITY || (arity & (arity - 1)) != 0) {
+        heaperror("CDaryHeap: arity has to be a power of two between 2 and DARYHEAP_MAXARITY");
+    }
+    if (keysize != 1 && keysize != KEY_SIZE) {
+        heaperror("CDaryHeap: keysize has to be 1 or KEY_SIZE");
+    }
+
+    aritylog = 0;
+    while ((1 << aritylog) < arity) ++aritylog;
+    this->keysize = keysize;
+
+    percolates = 0;
+    currentsize = 0;
+    allocated = 0;
+    statesbuffer = NULL;
+    keysbuffer = NULL;
+    allocate(HEAPSIZE_INIT);
+}
+
+CDaryHeap::~CDaryHeap()
+{
+    int i;
+    for (i = 1; i <= currentsize; ++i)
+        states[i]->heapindex = 0;
+
+    delete[] statesbuffer;
+    delete[] keysbuffer;
+}
+
+void CDaryHeap::allocate(int size)
+{
+    char* alignedstates;
+    char* alignedkeys;
+    char* newstatesbuffer = AllocateDaryHeapArray(size, sizeof(AbstractSearchState*), &alignedstates);
+    char* newkeysbuffer = AllocateDaryHeapArray(size, keysize * sizeof(long int), &alignedkeys);
+
+    if (currentsize > 0) {
+        memcpy(alignedstates, states, (currentsize + 1) * sizeof(AbstractSearchState*));
+        memcpy(alignedkeys, keys, (currentsize + 1) * keysize * sizeof(long int));
+    }
+    delete[] statesbuffer;
+    delete[] keysbuffer;
+
+    statesbuffer = newstatesbuffer;
+    keysbuffer = newkeysbuffer;
+    states = (AbstractSearchState**)alignedstates;
+    keys = (long int*)alignedkeys;
+    allocated = size;
+}
+
+bool CDaryHeap::keyless(const long int* key1, const long int* key2) const
+{
+    return keysize == 1 ? DaryKeyLess<1>(key1, key2) : DaryKeyLess<KEY_SIZE>(key1, key2);
+}
+
+CKey CDaryHeap::getkey(int index) const
+{
+    CKey key;
+    for (int i = 0; i < keysize; i++) {
+        key.key[i] = keys[index * keysize + i];
+    }
+    return key;
+}
+
+template <int KEYSIZE>
+void CDaryHeap::percolatedown(int hole, AbstractSearchState* state, const long int* key)
+{
+    //the key may point into the heap, which gets overwritten below
+    long int tmpkey[KEYSIZE];
+    memcpy(tmpkey, key, sizeof(tmpkey));
+
+    int firstchild;
+    for (; (firstchild = DARYHEAP_FIRSTCHILD(hole)) <= currentsize; ) {
+        int lastchild = firstchild + (1 << aritylog) - 1;
+        if (lastchild > currentsize) lastchild = currentsize;
+        int child = firstchild;
+        for (int i = firstchild + 1; i <= lastchild; ++i) {
+            if (DaryKeyLess<KEYSIZE>(&keys[i * KEYSIZE], &keys[child * KEYSIZE])) child = i;
+        }
+        if (!DaryKeyLess<KEYSIZE>(&keys[child * KEYSIZE], tmpkey)) break;
+
+        //the children of child are compared next
+        if (DARYHEAP_FIRSTCHILD(child) <= currentsize) {
+            DARYHEAP_PREFETCH(&keys[DARYHEAP_FIRSTCHILD(child) * KEYSIZE]);
+        }
+        percolates += 1;
+        states[hole] = states[child];
+        memcpy(&keys[hole * KEYSIZE], &keys[child * KEYSIZE], sizeof(tmpkey));
+        states[hole]->heapindex = hole;
+        hole = child;
+    }
+    states[hole] = state;
+    memcpy(&keys[hole * KEYSIZE], tmpkey, sizeof(tmpkey));
+    state->heapindex = hole;
+}
+
+template <int KEYSIZE>
+void CDaryHeap::percolateup(int hole, AbstractSearchState* state, const long int* key)
+{
+    long int tmpkey[KEYSIZE];
+    memcpy(tmpkey, key, sizeof(tmpkey));
+
+    for (; hole > 1; ) {
+        int parent = DARYHEAP_PARENT(hole);
+        if (!DaryKeyLess<KEYSIZE>(tmpkey, &keys[parent * KEYSIZE])) break;
+        percolates += 1;
+        states[hole] = states[parent];
+        memcpy(&keys[hole * KEYSIZE], &keys[parent * KEYSIZE], sizeof(tmpkey));
+        states[hole]->heapindex = hole;
+        hole = parent;
+    }
+    states[hole] = state;
+    memcpy(&keys[hole * KEYSIZE], tmpkey, sizeof(tmpkey));
+    state->heapindex = hole;
+}
+
+void CDaryHeap::percolatedown(int hole, AbstractSearchState* state, const long int* key)
+{
+    if (currentsize != 0) {
+        if (keysize == 1)
+            percolatedown<1>(hole, state, key);
+        else
+            percolatedown<KEY_SIZE>(hole, state, key);
+    }
+}
+
+void CDaryHeap::percolateup(int hole, AbstractSearchState* state, const long int* key)
+{
+    if (currentsize != 0) {
+        if (keysize == 1)
+            percolateup<1>(hole, state, key);
+        else
+            percolateup<KEY_SIZE>(hole, state, key);
+    }
+}
+
+void CDaryHeap::percolateupordown(int hole, AbstractSearchState* state, const long int* key)
+{
+    if (currentsize != 0) {
+        if (hole > 1 && keyless(key, &keys[DARYHEAP_PARENT(hole) * keysize]))
+            percolateup(hole, state, key);
+        else
+            percolatedown(hole, state, key);
+    }
+}
+
+bool CDaryHeap::emptyheap()
+{
+    return currentsize == 0;
+}
+
+bool CDaryHeap::fullheap()
+{
+    return currentsize == HEAPSIZE - 1;
+}
+
+bool CDaryHeap::inheap(AbstractSearchState *AbstractSearchState)
+{
+    return (AbstractSearchState->heapindex != 0);
+}
+
+CKey CDaryHeap::getkeyheap(AbstractSearchState *AbstractSearchState)
+{
+    if (AbstractSearchState->heapindex == 0) heaperror("GetKey: AbstractSearchState is not in heap");
+
+    return getkey(AbstractSearchState->heapindex);
+}
+
+void CDaryHeap::makeemptyheap()
+{
+    int i;
+
+    for (i = 1; i <= currentsize; ++i)
+        states[i]->heapindex = 0;
+    currentsize = 0;
+}
+
+void CDaryHeap::makeheap()
+{
+    int i;
+
+    if (currentsize < 2) return;
+    for (i = DARYHEAP_PARENT(currentsize); i > 0; i--) {
+        percolatedown(i, states[i], &keys[i * keysize]);
+    }
+}
+
+void CDaryHeap::setkeyheap_unsafe(int index, CKey key)
+{
+    memcpy(&keys[index * keysize], key.key, keysize * sizeof(long int));
+}
+
+void CDaryHeap::growheap()
+{
+    int newsize = 2 * allocated;
+    if (newsize > HEAPSIZE) newsize = HEAPSIZE;
+
+    SBPL_PRINTF("growing heap size from %d to %d\n", allocated, newsize);
+
+    allocate(newsize);
+}
+
+void CDaryHeap::sizecheck()
+{
+    if (fullheap())
+        heaperror("insertheap: heap is full");
+    else if (currentsize == allocated - 1) {
+        growheap();
+    }
+}
+
+void CDaryHeap::insertheap(AbstractSearchState *AbstractSearchState, CKey key)
+{
+    sizecheck();
+
+    if (AbstractSearchState->heapindex != 0) {
+        heaperror("insertheap: AbstractSearchState is already in heap");
+    }
+    percolateup(++currentsize, AbstractSearchState, key.key);
+}
+
+void CDaryHeap::deleteheap(AbstractSearchState *AbstractSearchState)
+{
+    if (AbstractSearchState->heapindex == 0) heaperror("deleteheap: AbstractSearchState is not in heap");
+    int last = currentsize--;
+    percolateupordown(AbstractSearchState->heapindex, states[last], &keys[last * keysize]);
+    AbstractSearchState->heapindex = 0;
+}
+
+void CDaryHeap::updateheap(AbstractSearchState *AbstractSearchState, CKey NewKey)
+{
+    if (AbstractSearchState->heapindex == 0) heaperror("Updateheap: AbstractSearchState is not in heap");
+    int index = AbstractSearchState->heapindex;
+    if (memcmp(&keys[index * keysize], NewKey.key, keysize * sizeof(long int)) != 0) {
+        setkeyheap_unsafe(index, NewKey);
+        percolateupordown(index, AbstractSearchState, &keys[index * keysize]);
+    }
+}
+
+void CDaryHeap::insert_unsafe(AbstractSearchState* AbstractSearchState, CKey key)
+{
+    sizecheck();
+
+    if (AbstractSearchState->heapindex != 0) {
+        heaperror("insertheap: AbstractSearchState is already in heap");
+    }
+
+    ++currentsize;
+    states[currentsize] = AbstractSearchState;
+    setkeyheap_unsafe(currentsize, key);
+    AbstractSearchState->heapindex = currentsize;
+}
+
+void CDaryHeap::deleteheap_unsafe(AbstractSearchState* AbstractSearchState)
+{
+    if (AbstractSearchState->heapindex == 0) {
+        heaperror("deleteheap: AbstractSearchState is not in heap");
+    }
+
+    int index = AbstractSearchState->heapindex;
+    states[index] = states[currentsize];
+    memcpy(&keys[index * keysize], &keys[currentsize * keysize], keysize * sizeof(long int));
+    --currentsize;
+
+    states[index]->heapindex = index;
+    AbstractSearchState->heapindex = 0;
+}
+
+void CDaryHeap::updateheap_unsafe(AbstractSearchState* AbstractSearchState, CKey NewKey)
+{
+    if (AbstractSearchState->heapindex == 0) {
+        heaperror("updateheap: AbstractSearchState is not in heap");
+    }
+    setkeyheap_unsafe(AbstractSearchState->heapindex, NewKey);
+}
+
+AbstractSearchState* CDaryHeap::getminheap()
+{
+    if (currentsize == 0) heaperror("GetMinheap: heap is empty");
+    return states[1];
+}
+
+AbstractSearchState* CDaryHeap::getminheap(CKey& ReturnKey)
+{
+    if (currentsize == 0) {
+        heaperror("GetMinheap: heap is empty");
+    }
+    ReturnKey = getkey(1);
+    return states[1];
+}
+
+CKey CDaryHeap::getminkeyheap()
+{
+    if (currentsize == 0) return InfiniteKey();
+    return getkey(1);
+}
+
+AbstractSearchState* CDaryHeap::deleteminheap()
+{
+    AbstractSearchState *AbstractSearchState;
+
+    if (currentsize == 0) heaperror("DeleteMin: heap is empty");
+
+    AbstractSearchState = states[1];
+    AbstractSearchState->heapindex = 0;
+    int last = currentsize--;
+    percolatedown(1, states[last], &keys[last * keysize]);
+    return AbstractSearchState;
+}
+
+//---------------------------------end of d-ary (multi-priority) CDaryHeap class----------------------------------------
+
+//---------------------------------single-priority CBucketHeap class-----------------------------------------------------
+
+CBucketHeap::CBucketHeap(int maxnumofbuckets)
+{
+    if (maxnumofbuckets < 2 || (maxnumofbuckets & (maxnumofbuckets - 1)) != 0) {
+        heaperror("CBucketHeap: maxnumofbuckets has to be a power of two");
+    }
+
+    this->maxnumofbuckets = maxnumofbuckets;
+    numofbuckets = __min(BUCKETHEAP_MINNUMBUCKETS, maxnumofbuckets);
+    buckets.resize(numofbuckets);
+    elements.reserve(HEAPSIZE_INIT);
+    elements.resize(1);
+    currentsize = 0;
+    bucketedsize = 0;
+    setwindow(0);
+}
+
+CBucketHeap::~CBucketHeap()
+{
+    int i;
+    for (i = 1; i <= currentsize; ++i)
+        elements[i].heapstate->heapindex = 0;
+}
+
+//starts the window a quarter of the buckets below key, so that keys slightly
+//smaller than the current minimum do not move it again right away
+void CBucketHeap::setwindow(long int key)
+{
+    windowstart = key - numofbuckets / 4;
+    minkey = windowstart + numofbuckets;
+}
+
+void CBucketHeap::clearbuckets()
+{
+    for (int i = 0; i < numofbuckets; i++) {
+        buckets[i].clear();
+    }
+    overflow.clear();
+    bucketedsize = 0;
+}
+
+//puts element index into the bucket (or the overflow) of its key
+void CBucketHeap::place(int index)
+{
+    bucketheapelement& element = elements[index];
+    if (element.key < windowstart) {
+        rebuild(element.key);
+        return;
+    }
+
+    vector<int>& container = getcontainer(element.key);
+    element.bucketindex = (int)container.size();
+    container.push_back(index);
+    if (&container != &overflow) {
+        bucketedsize++;
+        if (element.key < minkey) minkey = element.key;
+    }
+}
+
+//takes element index out of its bucket (or the overflow)
+void CBucketHeap::unplace(int index)
+{
+    bucketheapelement& element = elements[index];
+    vector<int>& container = getcontainer(element.key);
+    int last = container.back();
+    container[element.bucketindex] = last;
+    elements[last].bucketindex = element.bucketindex;
+    container.pop_back();
+    if (&container != &overflow) bucketedsize--;
+}
+
+//removes element index and moves the last element into its place
+void CBucketHeap::removeelement(int index)
+{
+    unplace(index);
+    elements[index].heapstate->heapindex = 0;
+    if (index != currentsize) {
+        elements[index] = elements[currentsize];
+        elements[index].heapstate->heapindex = index;
+        getcontainer(elements[index].key)[elements[index].bucketindex] = index;
+    }
+    elements.pop_back();
+    currentsize--;
+}
+
+//moves the window to start below lowestkey and redistributes all the elements
+void CBucketHeap::rebuild(long int lowestkey)
+{
+    clearbuckets();
+    setwindow(lowestkey);
+    for (int i = 1; i <= currentsize; i++) {
+        place(i);
+    }
+}
+
+//doubles the buckets until the window holds all the keys (or there are
+//maxnumofbuckets of them), called when a key has gone to the overflow
+void CBucketHeap::growbuckets()
+{
+    long int lowestkey = elements[1].key;
+    long int highestkey = elements[1].key;
+    for (int i = 2; i <= currentsize; i++) {
+        lowestkey = __min(lowestkey, elements[i].key);
+        highestkey = __max(highestkey, elements[i].key);
+    }
+
+    //the window starts a quarter of the buckets below lowestkey
+    while (numofbuckets < maxnumofbuckets && highestkey - lowestkey >= numofbuckets - numofbuckets / 4) {
+        numofbuckets *= 2;
+    }
+    buckets.resize(numofbuckets);
+    rebuild(lowestkey);
+}
+
+//sets minkey to the smallest key, returns false if the heap is empty
+bool CBucketHeap::findmin()
+{
+    if (bucketedsize == 0) {
+        if (overflow.empty()) return false;
+
+        //all the buckets are empty, move the window to the overflow
+        long int lowestkey = elements[overflow[0]].key;
+        for (size_t i = 1; i < overflow.size(); i++) {
+            if (elements[overflow[i]].key < lowestkey) lowestkey = elements[overflow[i]].key;
+        }
+        vector<int> overflowed;
+        overflowed.swap(overflow);
+        setwindow(lowestkey);
+        for (size_t i = 0; i < overflowed.size(); i++) {
+            place(overflowed[i]);
+        }
+        if (!overflow.empty() && numofbuckets < maxnumofbuckets) growbuckets();
+    }
+
+    while (getbucket(minkey).empty()) {
+        minkey++;
+    }
+    return true;
+}
+
+bool CBucketHeap::emptyheap()
+{
+    return currentsize == 0;
+}
+
+bool CBucketHeap::fullheap()
+{
+    return currentsize == HEAPSIZE - 1;
+}
+
+bool CBucketHeap::inheap(AbstractSearchState *AbstractSearchState)
+{
+    return (AbstractSearchState->heapindex != 0);
+}
+
+CKey CBucketHeap::getkeyheap(AbstractSearchState *AbstractSearchState)
+{
+    if (AbstractSearchState->heapindex == 0) heaperror("GetKey: AbstractSearchState is not in heap");
+
+    CKey key;
+    key.key[0] = elements[AbstractSearchState->heapindex].key;
+    return key;
+}
+
+void CBucketHeap::makeemptyheap()
+{
+    int i;
+
+    for (i = 1; i <= currentsize; ++i)
+        elements[i].heapstate->heapindex = 0;
+    elements.resize(1);
+    currentsize = 0;
+    clearbuckets();
+    setwindow(0);
+}
+
+void CBucketHeap::makeheap()
+{
+    if (currentsize == 0) return;
+
+    long int lowestkey = elements[1].key;
+    for (int i = 2; i <= currentsize; i++) {
+        if (elements[i].key < lowestkey) lowestkey = elements[i].key;
+    }
+    rebuild(lowestkey);
+    if (!overflow.empty() && numofbuckets < maxnumofbuckets) growbuckets();
+}
+
+void CBucketHeap::insertheap(AbstractSearchState *AbstractSearchState, CKey key)
+{
+    if (fullheap()) heaperror("insertheap: heap is full");
+    if (AbstractSearchState->heapindex != 0) {
+        heaperror("insertheap: AbstractSearchState is already in heap");
+    }
+
+    bucketheapelement element;
+    element.heapstate = AbstractSearchState;
+    element.key = key.key[0];
+    element.bucketindex = 0;
+    elements.push_back(element);
+    AbstractSearchState->heapindex = ++currentsize;
+    place(currentsize);
+    if (!overflow.empty() && numofbuckets < maxnumofbuckets) growbuckets();
+}
+
+void CBucketHeap::deleteheap(AbstractSearchState *AbstractSearchState)
+{
+    if (AbstractSearchState->heapindex == 0) heaperror("deleteheap: AbstractSearchState is not in heap");
+    removeelement(AbstractSearchState->heapindex);
+}
+
+void CBucketHeap::updateheap(AbstractSearchState *AbstractSearchState, CKey NewKey)
+{
+    if (AbstractSearchState->heapindex == 0) heaperror("Updateheap: AbstractSearchState is not in heap");
+    int index = AbstractSearchState->heapindex;
+    if (elements[index].key != NewKey.key[0]) {
+        unplace(index);
+        elements[index].key = NewKey.key[0];
+        place(index);
+        if (!overflow.empty() && numofbuckets < maxnumofbuckets) growbuckets();
+    }
+}
+
+AbstractSearchState* CBucketHeap::getminheap()
+{
+    if (!findmin()) heaperror("GetMinheap: heap is empty");
+    return elements[getbucket(minkey).back()].heapstate;
+}
+
+AbstractSearchState* CBucketHeap::getminheap(CKey& ReturnKey)
+{
+    AbstractSearchState* AbstractSearchState = getminheap();
+    ReturnKey = CKey();
+    ReturnKey.key[0] = minkey;
+    return AbstractSearchState;
+}
+
+CKey CBucketHeap::getminkeyheap()
+{
+    if (!findmin()) return InfiniteKey();
+    CKey key;
+    key.key[0] = minkey;
+    return key;
+}
+
+AbstractSearchState* CBucketHeap::deleteminheap()
+{
+    if (!findmin()) heaperror("DeleteMin: heap is empty");
+
+    int index = getbucket(minkey).back();
+    AbstractSearchState* AbstractSearchState = elements[index].heapstate;
+    removeelement(index);
+    return AbstractSearchState;
+}
+
+//---------------------------------end of single-priority CBucketHeap class----------------------------------------------
+
 //---------------------------------single-priority CIntHeap class---------------------------------------------------
 
 //constructors and destructors
@@ -29,7 +29,11 @@
 
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <sstream>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include <sbpl/planners/planner.h>
 #include <sbpl/utils/utils.h>
@@ -771,6 +775,51 @@ void get_2d_motion_cells(vector<sbpl_2Dpt_t> polygon, vector<sbpl_xy_theta_pt_t>
     }
 }
 
+void get_changed_cells(const unsigned char* oldmap, int oldstride, const unsigned char* newmap, int newstride,
+                       int width, int height, vector<sbpl_2Dcell_t>* changedcells)
+{
+    for (int y = 0; y < height; y++) {
+        const unsigned char* oldrow = oldmap + (size_t)y * oldstride;
+        const unsigned char* newrow = newmap + (size_t)y * newstride;
+        int x = 0;
+#if defined(__SSE2__)
+        for (; x + 16 <= width; x += 16) {
+            __m128i o = _mm_loadu_si128((const __m128i*)(oldrow + x));
+            __m128i n = _mm_loadu_si128((const __m128i*)(newrow + x));
+            // one bit per byte that differs
+            unsigned int mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(o, n)) & 0xFFFF;
+            while (mask) {
+                int bit = 0;
+                while (!(mask & (1u << bit))) {
+                    bit++;
+                }
+                changedcells->push_back(sbpl_2Dcell_t(x + bit, y));
+                mask &= mask - 1;
+            }
+        }
+#else
+        for (; x + 8 <= width; x += 8) {
+            unsigned long long o, n;
+            memcpy(&o, oldrow + x, 8);
+            memcpy(&n, newrow + x, 8);
+            if (o == n) {
+                continue;
+            }
+            for (int i = 0; i < 8; i++) {
+                if (oldrow[x + i] != newrow[x + i]) {
+                    changedcells->push_back(sbpl_2Dcell_t(x + i, y));
+                }
+            }
+        }
+#endif
+        for (; x < width; x++) {
+            if (oldrow[x] != newrow[x]) {
+                changedcells->push_back(sbpl_2Dcell_t(x, y));
+            }
+        }
+    }
+}
+
 //This function is inefficient and should be avoided if possible (you should
 //use overloaded functions that uses a set for the cells)!
 void get_2d_footprint_cells(vector<sbpl_2Dpt_t> polygon, vector<sbpl_2Dcell_t>* cells, sbpl_xy_theta_pt_t pose,
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2008, Maxim Likhachev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Carnegie Mellon University nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <sbpl/utils/workerpool.h>
+
+SBPLWorkerPool::SBPLWorkerPool(int numworkers)
+{
+    job = NULL;
+    jobsize = 0;
+    numsleeping = 0;
+    bstop = false;
+    generation = 0;
+    next = 0;
+    done = 0;
+    active = 0;
+
+    for (int t = 0; t < numworkers; t++) {
+        workers.push_back(std::thread(&SBPLWorkerPool::work, this));
+    }
+}
+
+SBPLWorkerPool::~SBPLWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bstop = true;
+        generation++;
+    }
+    wakeup.notify_all();
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+}
+
+void SBPLWorkerPool::runjob(const std::function<void(int)>& fn, int n)
+{
+    for (int i = next++; i < n; i = next++) {
+        try {
+            fn(i);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        done.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void SBPLWorkerPool::run(int n, const std::function<void(int)>& fn)
+{
+    if (n <= 0) {
+        return;
+    }
+    if (workers.empty() || n == 1) {
+        for (int i = 0; i < n; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    bool bwakeup;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        jobsize = n;
+        next = 0;
+        done = 0;
+        error = std::exception_ptr();
+        generation++;
+        bwakeup = numsleeping > 0;
+    }
+    if (bwakeup) {
+        wakeup.notify_all();
+    }
+
+    runjob(fn, n);
+
+    while (done.load(std::memory_order_acquire) < n) {
+        std::this_thread::yield();
+    }
+
+    //nobody can take the job anymore, wait for the workers that did to
+    //leave the loop (they find it finished right away)
+    std::exception_ptr jobexception;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = NULL;
+        jobexception = error;
+        error = std::exception_ptr();
+    }
+    while (active.load(std::memory_order_acquire) > 0) {
+        std::this_thread::yield();
+    }
+
+    if (jobexception) {
+        std::rethrow_exception(jobexception);
+    }
+}
+
+void SBPLWorkerPool::work()
+{
+    unsigned int seen = 0;
+    while (true) {
+        //poll for the next job for a while, then sleep
+        int polls = 0;
+        while (generation.load(std::memory_order_acquire) == seen) {
+            if (++polls < SBPL_WORKERPOOL_SPINCOUNT) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            numsleeping++;
+            wakeup.wait(lock, [&] { return generation.load() != seen; });
+            numsleeping--;
+        }
+
+        const std::function<void(int)>* fn;
+        int n;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (bstop) {
+                return;
+            }
+            seen = generation.load();
+            fn = job;
+            n = jobsize;
+            if (fn != NULL) {
+                active++;
+            }
+        }
+
+        if (fn != NULL) {
+            runjob(*fn, n);
+            active.fetch_sub(1, std::memory_order_release);
+        }
+    }
+}